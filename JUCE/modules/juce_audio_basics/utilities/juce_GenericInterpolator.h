@@ -304,6 +304,18 @@ private:
                          int wrap,
                          Process process)
     {
+        if constexpr (hasBlockImplementation)
+        {
+            // If the input never runs out, the wrapping and zero-feeding can't kick in
+            const auto numNeeded = getNumInputSamplesNeeded (speedRatio, numOutputSamplesToProduce);
+
+            if (numNeeded <= numInputSamplesAvailable)
+            {
+                const auto numUsed = interpolateBlocks (speedRatio, input, output, numOutputSamplesToProduce, process);
+                return wrap == 0 ? numUsed : (numUsed + wrap) % wrap;
+            }
+        }
+
         auto originalIn = input;
         bool exceeded = false;
 
@@ -351,6 +363,9 @@ private:
                          int numOutputSamplesToProduce,
                          Process process)
     {
+        if constexpr (hasBlockImplementation)
+            return interpolateBlocks (speedRatio, input, output, numOutputSamplesToProduce, process);
+
         int numUsed = 0;
 
         interpolateImpl (speedRatio,
@@ -387,6 +402,113 @@ private:
         subSamplePos = pos;
     }
 
+    //==============================================================================
+    /*  Traits can provide a block version of valueAtOffset:
+
+            static void valuesAtOffsets (const float* window, const int* windowStarts,
+                                         const float* offsets, float* results, int numValues) noexcept;
+
+        which must compute results[i] = valueAtOffset (window + windowStarts[i], offsets[i], 0),
+        i.e. each value reads memorySize contiguous samples, oldest first. With no ring
+        buffer index to follow, several positions can be computed at once with SIMD.
+    */
+    template <typename Traits, typename = void>
+    struct HasValuesAtOffsets : std::false_type {};
+
+    template <typename Traits>
+    struct HasValuesAtOffsets<Traits, std::void_t<decltype (&Traits::valuesAtOffsets)>> : std::true_type {};
+
+    static constexpr bool hasBlockImplementation = HasValuesAtOffsets<InterpolatorTraits>::value;
+
+    int getNumInputSamplesNeeded (double speedRatio, int numOutputSamplesToProduce) const noexcept
+    {
+        auto pos = subSamplePos;
+        int numNeeded = 0;
+
+        for (auto i = 0; i < numOutputSamplesToProduce; ++i)
+        {
+            while (pos >= 1.0)
+            {
+                ++numNeeded;
+                pos -= 1.0;
+            }
+
+            pos += speedRatio;
+        }
+
+        return numNeeded;
+    }
+
+    template <typename Process>
+    int interpolateBlocks (double speedRatio,
+                           const float* input,
+                           float* output,
+                           int numOutputSamplesToProduce,
+                           Process process) noexcept
+    {
+        constexpr int blockSize = 64;
+
+        int windowStarts[blockSize];
+        float offsets[blockSize], results[blockSize];
+
+        // The history (oldest first) followed by the start of the input, for the
+        // positions whose window still reaches back into the history
+        float head[(size_t) (2 * memorySize)];
+
+        auto pos = subSamplePos;
+        int numUsed = 0;
+
+        for (int done = 0; done < numOutputSamplesToProduce; done += blockSize)
+        {
+            const auto numInBlock = jmin (blockSize, numOutputSamplesToProduce - done);
+
+            // The same position arithmetic as the sample-by-sample loop. A window
+            // starts at numUsed counting the history, so at numUsed - memorySize
+            // in the input.
+            for (int i = 0; i < numInBlock; ++i)
+            {
+                while (pos >= 1.0)
+                {
+                    ++numUsed;
+                    pos -= 1.0;
+                }
+
+                windowStarts[i] = numUsed;
+                offsets[i] = (float) pos;
+                pos += speedRatio;
+            }
+
+            int numFromHead = 0;
+
+            while (numFromHead < numInBlock && windowStarts[numFromHead] < memorySize)
+                ++numFromHead;
+
+            if (numFromHead > 0)
+            {
+                for (int i = 0; i < memorySize; ++i)
+                    head[i] = lastInputSamples[(indexBuffer + i) % memorySize];
+
+                std::copy (input, input + jmin (numUsed, memorySize), head + memorySize);
+
+                InterpolatorTraits::valuesAtOffsets (head, windowStarts, offsets, results, numFromHead);
+            }
+
+            for (int i = numFromHead; i < numInBlock; ++i)
+                windowStarts[i] -= memorySize;
+
+            InterpolatorTraits::valuesAtOffsets (input, windowStarts + numFromHead, offsets + numFromHead,
+                                                 results + numFromHead, numInBlock - numFromHead);
+
+            for (int i = 0; i < numInBlock; ++i)
+                output[done + i] = process (output[done + i], results[i]);
+        }
+
+        subSamplePos = pos;
+        pushInterpolationSamples (input, numUsed);
+
+        return numUsed;
+    }
+
     //==============================================================================
     float lastInputSamples[(size_t) memorySize];
     double subSamplePos = 1.0;
@@ -100,6 +100,8 @@ private:
             return result;
         }
 
+        static void valuesAtOffsets (const float*, const int*, const float*, float*, int) noexcept;
+
         static const float lookupTable[10001];
     };
 
@@ -108,6 +110,7 @@ private:
         static constexpr float algorithmicLatency = 2.0f;
 
         static float valueAtOffset (const float*, float, int) noexcept;
+        static void valuesAtOffsets (const float*, const int*, const float*, float*, int) noexcept;
     };
 
     struct CatmullRomTraits
@@ -71,4 +71,68 @@ float Interpolators::LagrangeTraits::valueAtOffset (const float* inputs, float o
     return result;
 }
 
+#if JUCE_USE_SSE_INTRINSICS || JUCE_USE_ARM_NEON
+// The same arithmetic as calcCoefficient, for several offsets at once
+template <int k>
+static FloatVectorHelpers::BasicOps32::ParallelType calcCoefficients (FloatVectorHelpers::BasicOps32::ParallelType input,
+                                                                      FloatVectorHelpers::BasicOps32::ParallelType offset) noexcept
+{
+    using Ops = FloatVectorHelpers::BasicOps32;
+
+    const auto apply = [&] (auto j, float nodeOffset)
+    {
+        constexpr int divisor = decltype (j)::value - k;
+
+        if constexpr (divisor != 0)
+            input = Ops::mul (input, Ops::mul (Ops::sub (Ops::load1 (nodeOffset), offset), Ops::load1 (1.0f / divisor)));
+    };
+
+    apply (std::integral_constant<int, 0>(), -2.0f);
+    apply (std::integral_constant<int, 1>(), -1.0f);
+    apply (std::integral_constant<int, 2>(),  0.0f);
+    apply (std::integral_constant<int, 3>(),  1.0f);
+    apply (std::integral_constant<int, 4>(),  2.0f);
+    return input;
+}
+#endif
+
+void Interpolators::LagrangeTraits::valuesAtOffsets (const float* window, const int* windowStarts,
+                                                     const float* offsets, float* results, int numValues) noexcept
+{
+    int i = 0;
+
+   #if JUCE_USE_SSE_INTRINSICS || JUCE_USE_ARM_NEON
+    using Ops = FloatVectorHelpers::BasicOps32;
+    constexpr int numLanes = Ops::numParallel;
+
+    for (; i + numLanes <= numValues; i += numLanes)
+    {
+        // Gather the five input samples of each position into one vector per tap
+        alignas (16) float samples[5][numLanes];
+
+        for (int lane = 0; lane < numLanes; ++lane)
+        {
+            const auto* src = window + windowStarts[i + lane];
+
+            for (int tap = 0; tap < 5; ++tap)
+                samples[tap][lane] = src[tap];
+        }
+
+        const auto offset = Ops::loadU (offsets + i);
+        auto result = Ops::load1 (0.0f);
+
+        result = Ops::add (result, calcCoefficients<0> (Ops::loadA (samples[0]), offset));
+        result = Ops::add (result, calcCoefficients<1> (Ops::loadA (samples[1]), offset));
+        result = Ops::add (result, calcCoefficients<2> (Ops::loadA (samples[2]), offset));
+        result = Ops::add (result, calcCoefficients<3> (Ops::loadA (samples[3]), offset));
+        result = Ops::add (result, calcCoefficients<4> (Ops::loadA (samples[4]), offset));
+
+        Ops::storeU (results + i, result);
+    }
+   #endif
+
+    for (; i < numValues; ++i)
+        results[i] = valueAtOffset (window + windowStarts[i], offsets[i], 0);
+}
+
 } // namespace juce
@@ -10039,4 +10039,140 @@ const float Interpolators::WindowedSincTraits::lookupTable[] {
     0.000000000000000000e+00f
 };
 
+//==============================================================================
+/*  valueAtOffset steps through lookupTable 100 entries at a time, once going down
+    for the taps before the position and once going up for the taps after it.
+    Stored as 100 rows of every 100th entry, both runs become contiguous reads,
+    so the weights of all taps can be computed with vector operations before a
+    single dot product with the (also contiguous) input window.
+*/
+struct WindowedSincRows
+{
+    static constexpr int numRows = 100;
+    static constexpr int rowSize = 104;     // 101 entries + padding, read as zeros
+
+    WindowedSincRows (const float* table, int tableSize) noexcept
+    {
+        for (int r = 0; r < numRows; ++r)
+        {
+            for (int m = 0; m < rowSize; ++m)
+            {
+                const auto index = r + numRows * m;
+                ascending[r][m] = index < tableSize ? table[index] : 0.0f;
+            }
+
+            for (int m = 0; m < rowSize; ++m)
+                descending[r][m] = ascending[r][rowSize - 1 - m];
+        }
+    }
+
+    // weights[t] = value1 + frac * (value2 - value1), as in windowedSinc, where value2
+    // is the entry after value1: the next row, or the first row one step further on
+    static void interpolate (const float* value1, const float* value2, float frac, float* weights, int numWeights) noexcept
+    {
+        int t = 0;
+
+       #if JUCE_USE_SSE_INTRINSICS || JUCE_USE_ARM_NEON
+        using Ops = FloatVectorHelpers::BasicOps32;
+        const auto fracs = Ops::load1 (frac);
+
+        for (; t + Ops::numParallel <= numWeights; t += Ops::numParallel)
+        {
+            const auto v1 = Ops::loadU (value1 + t);
+            Ops::storeU (weights + t, Ops::add (v1, Ops::mul (fracs, Ops::sub (Ops::loadU (value2 + t), v1))));
+        }
+       #endif
+
+        for (; t < numWeights; ++t)
+            weights[t] = value1[t] + (frac * (value2[t] - value1[t]));
+    }
+
+    static float dotProduct (const float* samples, const float* weights, int num) noexcept
+    {
+        int t = 0;
+        float result = 0.0f;
+
+       #if JUCE_USE_SSE_INTRINSICS || JUCE_USE_ARM_NEON
+        using Ops = FloatVectorHelpers::BasicOps32;
+        auto sum = Ops::load1 (0.0f);
+
+        for (; t + Ops::numParallel <= num; t += Ops::numParallel)
+            sum = Ops::add (sum, Ops::mul (Ops::loadU (samples + t), Ops::loadA (weights + t)));
+
+        alignas (16) float lanes[Ops::numParallel];
+        Ops::storeA (lanes, sum);
+
+        for (auto lane : lanes)
+            result += lane;
+       #endif
+
+        for (; t < num; ++t)
+            result += samples[t] * weights[t];
+
+        return result;
+    }
+
+    float ascending[numRows][rowSize];
+    float descending[numRows][rowSize];     // each ascending row reversed
+};
+
+void Interpolators::WindowedSincTraits::valuesAtOffsets (const float* window, const int* windowStarts,
+                                                         const float* offsets, float* results, int numValues) noexcept
+{
+    constexpr int numCrossings = 100;
+    constexpr int numTaps = 2 * numCrossings;
+    constexpr int numRows = WindowedSincRows::numRows;
+    constexpr int lastEntry = WindowedSincRows::rowSize - 1;
+
+    static const WindowedSincRows rows (lookupTable, (int) numElementsInArray (lookupTable));
+    alignas (16) float weights[numTaps];
+
+    for (int i = 0; i < numValues; ++i)
+    {
+        const auto offset = offsets[i];
+        const auto firstPosition = 1.0f - offset;
+
+        // Tap t sits at sincPosition = firstPosition + (t - numCrossings). The positions
+        // below zero walk the table downwards from the first tap, the rest upwards from
+        // the first position at or above zero, exactly like valueAtOffset.
+        const auto firstNonNegative = firstPosition - 1.0f >= 0.0f ? numCrossings - 1 : numCrossings;
+
+        {
+            const auto indexFloat = -(firstPosition + (float) -numCrossings) * 100.0f;
+            const auto indexFloored = std::floor (indexFloat);
+            const auto index = (int) indexFloored;
+            const auto row = index % numRows;
+
+            // Entry m of a row is at lastEntry - m in the reversed row
+            const auto start = lastEntry - index / numRows;
+            const auto* value1 = rows.descending[row] + start;
+            const auto* value2 = row + 1 < numRows ? rows.descending[row + 1] + start
+                                                   : rows.descending[0] + start - 1;
+
+            WindowedSincRows::interpolate (value1, value2, indexFloat - indexFloored, weights, firstNonNegative);
+        }
+
+        {
+            const auto indexFloat = (firstPosition + (float) (firstNonNegative - numCrossings)) * 100.0f;
+            const auto indexFloored = std::floor (indexFloat);
+            const auto index = (int) indexFloored;
+            const auto row = index % numRows;
+
+            const auto start = index / numRows;
+            const auto* value1 = rows.ascending[row] + start;
+            const auto* value2 = row + 1 < numRows ? rows.ascending[row + 1] + start
+                                                   : rows.ascending[0] + start + 1;
+
+            WindowedSincRows::interpolate (value1, value2, indexFloat - indexFloored,
+                                           weights + firstNonNegative, numTaps - firstNonNegative);
+        }
+
+        // The last tap only counts while its position is inside the window
+        if (! (firstPosition + (float) (numCrossings - 1) < (float) numCrossings))
+            weights[numTaps - 1] = 0.0f;
+
+        results[i] = WindowedSincRows::dotProduct (window + windowStarts[i], weights, numTaps);
+    }
+}
+
 } // namespace juce
@@ -1,6 +1,20 @@
 #include "PluginEditor.h"
 #include "PluginProcessor.h"
 
+namespace
+{
+    void addTargetRateItem(juce::ComboBox& box, double rate)
+    {
+        const auto info = HZResampler::identifyRate(rate);
+        auto text = HZResampler::formatRate(rate);
+
+        if (info.pull < 0) text << " (pull-down)";
+        if (info.pull > 0) text << " (pull-up)";
+
+        box.addItem(text, juce::roundToInt(rate));
+    }
+}
+
 HZInverAudioProcessorEditor::HZInverAudioProcessorEditor(HZInverAudioProcessor& p)
     : AudioProcessorEditor(&p), audioProcessor(p)
 {
@@ -54,10 +68,22 @@ HZInverAudioProcessorEditor::HZInverAudioProcessorEditor(HZInverAudioProcessor&
     downloadButton.setButtonText("Descargar...");
     downloadButton.addListener(this);
 
+    // ===== Destino explicito (familias 44.1k / 48k y variantes de video) =====
+    addAndMakeVisible(targetRateBox);
+    for (auto rate : HZResampler::getTargetRates())
+        addTargetRateItem(targetRateBox, rate);
+    targetRateBox.setTextWhenNothingSelected("Destino...");
+    targetRateBox.addListener(this);
+
     addAndMakeVisible(overwriteToggle);
     overwriteToggle.setButtonText("Sobrescribir archivo original");
     overwriteToggle.setToggleState(false, juce::dontSendNotification);
 
+    addAndMakeVisible(liveMonitorToggle);
+    liveMonitorToggle.setButtonText("Monitoreo en vivo (baja latencia)");
+    liveMonitorToggle.setToggleState(audioProcessor.isLiveMonitorEnabled(), juce::dontSendNotification);
+    liveMonitorToggle.addListener(this);
+
     // ===== Logos =====
     // Logo grande "Audio Cream" para el área de drag & drop
     {
@@ -95,6 +121,8 @@ HZInverAudioProcessorEditor::~HZInverAudioProcessorEditor()
     loadButton.removeListener(this);
     convertButton.removeListener(this);
     downloadButton.removeListener(this);
+    liveMonitorToggle.removeListener(this);
+    targetRateBox.removeListener(this);
 }
 
 // =====================================================================
@@ -248,10 +276,13 @@ void HZInverAudioProcessorEditor::resized()
     auto rightBottom = bottom;
 
     loadButton.setBounds(leftBottom.removeFromTop(30).removeFromLeft(230).reduced(4));
-    convertButton.setBounds(leftBottom.removeFromTop(34).removeFromLeft(280).reduced(4));
+    auto convertRow = leftBottom.removeFromTop(34);
+    convertButton.setBounds(convertRow.removeFromLeft(280).reduced(4));
+    targetRateBox.setBounds(convertRow.removeFromLeft(190).reduced(4));
     overwriteToggle.setBounds(leftBottom.removeFromTop(26));
 
     downloadButton.setBounds(rightBottom.removeFromTop(30).removeFromRight(190).reduced(4));
+    liveMonitorToggle.setBounds(rightBottom.removeFromTop(26).removeFromRight(260));
     statusLabel.setBounds(rightBottom);
 }
 
@@ -311,6 +342,26 @@ void HZInverAudioProcessorEditor::buttonClicked(juce::Button* button)
     {
         tryDownload();
     }
+    else if (button == &liveMonitorToggle)
+    {
+        const bool enabled = liveMonitorToggle.getToggleState();
+        audioProcessor.setLiveMonitor(enabled);
+
+        statusLabel.setText(enabled ? "Monitoreo en vivo activado (latencia: "
+                                          + juce::String(audioProcessor.getLatencySamples()) + " muestras)."
+                                    : "Monitoreo en vivo desactivado.",
+                            juce::dontSendNotification);
+        statusLabel.setColour(juce::Label::textColourId, juce::Colours::lightgrey);
+    }
+}
+
+void HZInverAudioProcessorEditor::comboBoxChanged(juce::ComboBox* box)
+{
+    if (box == &targetRateBox && targetRateBox.getSelectedId() != 0)
+    {
+        audioProcessor.setTargetRate((double) targetRateBox.getSelectedId());
+        updateLabelsFromProcessor();
+    }
 }
 
 // =====================================================================
@@ -324,10 +375,34 @@ void HZInverAudioProcessorEditor::updateLabelsFromProcessor()
                           juce::dontSendNotification);
 
         auto sr = audioProcessor.getDetectedSampleRate();
-        juce::String target = (sr == 44100.0 ? "48,000 Hz" : (sr == 48000.0 ? "44,100 Hz" : "-"));
+        auto target = audioProcessor.getTargetRate();
+        juce::String targetText = "-";
+
+        if (target > 0.0)
+        {
+            // Motor que va a usar la conversion (exacto, compacto, halfband...)
+            const auto engine = HZResampler::chooseEngine(sr, target);
+            targetText = HZResampler::formatRate(target) + "  [" + toString(engine)
+                           + (engine == HZEngineKind::variable ? juce::String()
+                                                               : " " + HZRatio::fromRates(sr, target).toString())
+                           + "]";
+
+            if (targetRateBox.indexOfItemId(juce::roundToInt(target)) < 0)
+                addTargetRateItem(targetRateBox, target);
+
+            targetRateBox.setSelectedId(juce::roundToInt(target), juce::dontSendNotification);
+            convertButton.setButtonText("Convertir de " + HZResampler::formatRate(sr).upToFirstOccurrenceOf(" ", false, false)
+                                        + " a " + HZResampler::formatRate(target));
+        }
+        else
+        {
+            targetRateBox.setSelectedId(0, juce::dontSendNotification);
+            convertButton.setButtonText("Convertir (elige destino)");
+        }
 
         rateLabel.setText("Sample Rate detectado: " + juce::String(sr, 1) +
-                              " Hz  →  destino: " + target,
+                              " Hz (" + HZResampler::identifyRate(sr).getDescription() + ")"
+                              "  →  destino: " + targetText,
                           juce::dontSendNotification);
     }
     else
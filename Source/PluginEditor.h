@@ -6,7 +6,8 @@
 class HZInverAudioProcessorEditor
     : public juce::AudioProcessorEditor,
       public juce::FileDragAndDropTarget,
-      public juce::Button::Listener
+      public juce::Button::Listener,
+      public juce::ComboBox::Listener
 {
 public:
     explicit HZInverAudioProcessorEditor(HZInverAudioProcessor&);
@@ -19,6 +20,7 @@ public:
     void filesDropped(const juce::StringArray& files, int x, int y) override;
 
     void buttonClicked(juce::Button* button) override;
+    void comboBoxChanged(juce::ComboBox* box) override;
 
 private:
     HZInverAudioProcessor& audioProcessor;
@@ -34,7 +36,10 @@ private:
     juce::TextButton convertButton { "Convertir de 44.1 a 48 kHz" };
     juce::TextButton downloadButton { "Descargar..." };
 
+    juce::ComboBox targetRateBox;   // id = frecuencia destino en Hz
+
     juce::ToggleButton overwriteToggle { "Sobrescribir archivo original" };
+    juce::ToggleButton liveMonitorToggle { "Monitoreo en vivo (baja latencia)" };
     juce::Image logoImage;
     juce::Image headerLogo;   // nuevo: logo "HZKONVER" para el encabezado
 
@@ -1,29 +1,59 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "ResamplerAutotune.h"
 
 HZInverAudioProcessor::HZInverAudioProcessor()
     : AudioProcessor(BusesProperties()
                      .withInput("Input", juce::AudioChannelSet::stereo(), true)
                      .withOutput("Output", juce::AudioChannelSet::stereo(), true))
 {
+    // Perfil de kernels medido en esta maquina (si existe)
+    HZAutotune::loadProfile();
 }
 
 HZInverAudioProcessor::~HZInverAudioProcessor() {}
 
 // ============================================================
-//                      AUDIO NO SE USA (solo passthrough)
+//         AUDIO: passthrough, o monitoreo en vivo de la
+//         conversión (host -> destino -> host, fase mínima)
 // ============================================================
 void HZInverAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
-    juce::ignoreUnused(sampleRate, samplesPerBlock);
+    const int numChannels = juce::jmax(getTotalNumInputChannels(), getTotalNumOutputChannels());
+
+    // Con una frecuencia de host no reconocida no hay destino que
+    // adivinar: el monitor queda sin preparar y el audio pasa tal cual
+    liveResampler.prepare(sampleRate, HZResampler::getDefaultTargetRate(sampleRate), samplesPerBlock, numChannels);
+    liveMonitorActive = false;
+
+    setLatencySamples(liveMonitor.load() ? liveResampler.getLatencySamples() : 0);
 }
 
 void HZInverAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer,
                                          juce::MidiBuffer& midiMessages)
 {
     juce::ignoreUnused(midiMessages);
-    // No procesamos audio en tiempo real, es solo utilidad offline.
-    juce::ignoreUnused(buffer);
+
+    if (! liveMonitor.load())
+    {
+        liveMonitorActive = false;
+        return;
+    }
+
+    // Al activar se arranca con historial limpio
+    if (! liveMonitorActive)
+    {
+        liveResampler.reset();
+        liveMonitorActive = true;
+    }
+
+    liveResampler.process(buffer);
+}
+
+void HZInverAudioProcessor::setLiveMonitor(bool enabled)
+{
+    liveMonitor = enabled;
+    setLatencySamples(enabled && liveResampler.isPrepared() ? liveResampler.getLatencySamples() : 0);
 }
 
 // ============================================================
@@ -56,7 +86,10 @@ bool HZInverAudioProcessor::loadFile(const juce::File& file)
     }
 
     convertedFile = juce::File(); // limpiar cualquier conversión previa
-    lastMessage = "Archivo cargado correctamente.";
+    targetRate = HZResampler::getDefaultTargetRate(detectedSampleRate);
+
+    lastMessage = targetRate > 0.0 ? "Archivo cargado correctamente."
+                                   : "Archivo cargado: frecuencia no estandar, elige el destino.";
 
     return true;
 }
@@ -72,19 +105,16 @@ bool HZInverAudioProcessor::convertFile(bool overwrite)
         return false;
     }
 
-    // Decide destino automáticamente 44.1 <-> 48 kHz
-    double newRate;
-    if (std::abs(detectedSampleRate - 44100.0) < 1.0)
-        newRate = 48000.0;
-    else if (std::abs(detectedSampleRate - 48000.0) < 1.0)
-        newRate = 44100.0;
-    else
-        newRate = (detectedSampleRate < 48000.0 ? 48000.0 : 44100.0);
+    if (targetRate <= 0.0)
+    {
+        lastMessage = "Elige la frecuencia destino.";
+        return false;
+    }
 
     juce::String msg;
     juce::File outFile = HZResampler::convertSampleRate(
         loadedFile,
-        newRate,
+        targetRate,
         overwrite,
         msg
     );
@@ -1,6 +1,7 @@
 #pragma once
 #include "JuceHeader.h"
 #include "Resampler.h"
+#include "ResamplerLive.h"
 
 class HZInverAudioProcessor : public juce::AudioProcessor
 {
@@ -39,9 +40,20 @@ public:
     /** Cargar archivo desde GUI */
     bool loadFile(const juce::File& file);
 
-    /** Ejecutar conversión 44.1 ↔ 48 */
+    /** Ejecutar conversión a la frecuencia destino elegida */
     bool convertFile(bool overwrite);
 
+    /** Frecuencia destino. Al cargar un archivo se propone la de
+        HZResampler::getDefaultTargetRate; con una frecuencia no
+        reconocida queda en 0 y hay que elegirla antes de convertir. */
+    void setTargetRate(double newTargetRate) { targetRate = newTargetRate; }
+    double getTargetRate() const { return targetRate; }
+
+    /** Monitoreo en vivo: el audio del host pasa por la conversión
+        (ida y vuelta, fase mínima) dentro de processBlock. */
+    void setLiveMonitor(bool enabled);
+    bool isLiveMonitorEnabled() const { return liveMonitor.load(); }
+
     /** Getters expuestos al Editor */
     double getDetectedSampleRate() const { return detectedSampleRate; }
     juce::File getLoadedFile() const { return loadedFile; }
@@ -55,7 +67,12 @@ private:
     juce::File convertedFile;
 
     double detectedSampleRate = 0.0;
+    double targetRate = 0.0;
     juce::String lastMessage;
 
+    HZLiveResampler liveResampler;
+    std::atomic<bool> liveMonitor { false };
+    bool liveMonitorActive = false;   // solo en el hilo de audio
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(HZInverAudioProcessor)
 };
@@ -1,5 +1,18 @@
 #include "Resampler.h"
+#include "ResamplerAnalysis.h"
+#include "ResamplerAutotune.h"
+#include "ResamplerDither.h"
+#include "ResamplerDraft.h"
+#include "ResamplerFlac.h"
+#include "ResamplerMp3.h"
+#include "ResamplerPcm.h"
 #include <cmath>
+#include <cstring>
+#include <utility>
+
+#if JUCE_USE_SSE_INTRINSICS
+ #include <emmintrin.h>
+#endif
 
 // ==========================================================
 //  Utilidades de log (C:\HZInver\hzlog.txt)
@@ -16,6 +29,610 @@ namespace
         auto f = getLogFile();
         f.appendText(s + "\n");
     }
+
+    // Formato de salida que mantiene el de la entrada. Los formatos
+    // con perdida decodifican a float (MP3, Ogg): salen en float 32
+    HZSampleFormat getSourceFormat(const juce::AudioFormatReader& reader) noexcept
+    {
+        if (reader.usesFloatingPointData)
+            return reader.bitsPerSample > 32 ? HZSampleFormat::float64 : HZSampleFormat::float32;
+
+        if (reader.bitsPerSample <= 16)
+            return HZSampleFormat::int16;
+
+        return reader.bitsPerSample <= 24 ? HZSampleFormat::int24 : HZSampleFormat::int32;
+    }
+
+    int getNumThreads(const HZConvertOptions& options)
+    {
+        return options.numThreads > 0 ? options.numThreads : juce::SystemStats::getNumCpus();
+    }
+
+    // ==========================================================
+    //  Lectura por bloques segun la precision
+    //
+    //  WAV/AIFF de archivo: HZPcmReader decodifica los bytes
+    //  del chunk de datos directo al buffer del bloque, en una
+    //  sola pasada (mismo resultado que JUCE). FLAC de archivo
+    //  con total conocido: HZFlacReader decodifica segmentos
+    //  en paralelo por delante de la lectura. MP3 de archivo:
+    //  HZMp3Reader, lo mismo con un indice de frames (lo crea
+    //  convertSampleRate una vez y lo comparten las lecturas).
+    //
+    //  Resto de formatos:
+    //  float : lectura normal de JUCE.
+    //  double: el PCM entero se lee como int32 y se escala
+    //          directo a double (sin pasar por float).
+    //
+    //  La escritura es igual para ambas: HZWavWriter cuantiza
+    //  (HZQuantizer, con dither) o convierte a float en tramos
+    //  chicos y empaqueta los bytes intercalados directo en su
+    //  bloque de salida; HZFlacWriter cuantiza en lotes que
+    //  codifica en paralelo.
+    // ==========================================================
+    template <typename SampleType>
+    struct BlockReader;
+
+    template <>
+    struct BlockReader<float>
+    {
+        BlockReader(juce::AudioFormatReader& reader, HZMp3Reader* mp3Reader, int, int, int numThreads = 1,
+                    bool follow = false)
+            : pcm(mp3Reader == nullptr ? HZPcmReader::create(reader, follow) : nullptr),
+              flac(pcm == nullptr && mp3Reader == nullptr ? HZFlacReader::create(reader, numThreads) : nullptr),
+              mp3(mp3Reader)
+        {
+        }
+
+        bool read(juce::AudioFormatReader& reader, juce::AudioBuffer<float>& dest,
+                  juce::int64 start, int numFrames)
+        {
+            if (pcm != nullptr)
+                return pcm->read(dest.getArrayOfWritePointers(), dest.getNumChannels(), start, numFrames);
+
+            if (flac != nullptr)
+                return flac->read(dest.getArrayOfWritePointers(), dest.getNumChannels(), start, numFrames);
+
+            if (mp3 != nullptr)
+                return mp3->read(dest.getArrayOfWritePointers(), dest.getNumChannels(), start, numFrames);
+
+            return reader.read(&dest, 0, numFrames, start, true, true);
+        }
+
+        std::unique_ptr<HZPcmReader> pcm;
+        std::unique_ptr<HZFlacReader> flac;
+        HZMp3Reader* mp3 = nullptr;             // el de convertSampleRate (un indice por conversion)
+    };
+
+    template <>
+    struct BlockReader<double>
+    {
+        BlockReader(juce::AudioFormatReader& reader, HZMp3Reader* mp3Reader, int numChannels, int maxFrames,
+                    int numThreads = 1, bool follow = false)
+            : pcm(mp3Reader == nullptr ? HZPcmReader::create(reader, follow) : nullptr),
+              flac(pcm == nullptr && mp3Reader == nullptr ? HZFlacReader::create(reader, numThreads) : nullptr),
+              mp3(mp3Reader)
+        {
+            if (pcm != nullptr || flac != nullptr || mp3 != nullptr)
+                return;
+
+            intData.malloc((size_t) numChannels * (size_t) maxFrames);
+            intChannels.malloc((size_t) numChannels);
+
+            for (int ch = 0; ch < numChannels; ++ch)
+                intChannels[ch] = intData + (size_t) ch * (size_t) maxFrames;
+        }
+
+        bool read(juce::AudioFormatReader& reader, juce::AudioBuffer<double>& dest,
+                  juce::int64 start, int numFrames)
+        {
+            if (pcm != nullptr)
+                return pcm->read(dest.getArrayOfWritePointers(), dest.getNumChannels(), start, numFrames);
+
+            if (flac != nullptr)
+                return flac->read(dest.getArrayOfWritePointers(), dest.getNumChannels(), start, numFrames);
+
+            if (mp3 != nullptr)
+                return mp3->read(dest.getArrayOfWritePointers(), dest.getNumChannels(), start, numFrames);
+
+            if (! reader.read(intChannels.get(), dest.getNumChannels(), start, numFrames, true))
+                return false;
+
+            for (int ch = 0; ch < dest.getNumChannels(); ++ch)
+            {
+                auto* out = dest.getWritePointer(ch);
+
+                if (reader.usesFloatingPointData)
+                {
+                    const auto* in = reinterpret_cast<const float*>(intChannels[ch]);
+                    for (int i = 0; i < numFrames; ++i)
+                        out[i] = (double) in[i];
+                }
+                else
+                {
+                    const int* in = intChannels[ch];
+                    for (int i = 0; i < numFrames; ++i)
+                        out[i] = in[i] * (1.0 / 2147483648.0);
+                }
+            }
+
+            return true;
+        }
+
+        std::unique_ptr<HZPcmReader> pcm;
+        std::unique_ptr<HZFlacReader> flac;
+        HZMp3Reader* mp3 = nullptr;             // el de convertSampleRate (un indice por conversion)
+        juce::HeapBlock<int> intData;
+        juce::HeapBlock<int*> intChannels;
+    };
+
+    // ==========================================================
+    //  Canales identicos (dual mono)
+    //
+    //  Igualdad bit a bit de cada canal con el primero: XOR de
+    //  64 bytes por vuelta (SSE2) y un solo test al final de
+    //  cada vuelta. -0 frente a 0 cuenta como distinto: la
+    //  salida tiene que ser la misma que sin el atajo.
+    // ==========================================================
+    bool isSameData(const void* a, const void* b, size_t numBytes) noexcept
+    {
+        const auto* pa = static_cast<const char*>(a);
+        const auto* pb = static_cast<const char*>(b);
+        size_t i = 0;
+
+       #if JUCE_USE_SSE_INTRINSICS
+        const auto load = [](const char* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); };
+
+        for (; i + 64 <= numBytes; i += 64)
+        {
+            const __m128i diff = _mm_or_si128(_mm_or_si128(_mm_xor_si128(load(pa + i),      load(pb + i)),
+                                                           _mm_xor_si128(load(pa + i + 16), load(pb + i + 16))),
+                                              _mm_or_si128(_mm_xor_si128(load(pa + i + 32), load(pb + i + 32)),
+                                                           _mm_xor_si128(load(pa + i + 48), load(pb + i + 48))));
+
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(diff, _mm_setzero_si128())) != 0xffff)
+                return false;
+        }
+       #endif
+
+        return std::memcmp(pa + i, pb + i, numBytes - i) == 0;
+    }
+
+    template <typename SampleType>
+    bool areChannelsIdentical(const juce::AudioBuffer<SampleType>& buffer, int numFrames) noexcept
+    {
+        for (int ch = 1; ch < buffer.getNumChannels(); ++ch)
+            if (! isSameData(buffer.getReadPointer(0), buffer.getReadPointer(ch), (size_t) numFrames * sizeof(SampleType)))
+                return false;
+
+        return true;
+    }
+
+    // Todo el archivo antes de convertir (HZMonoCheck::wholeFile)
+    template <typename SampleType>
+    bool isDualMonoFile(juce::AudioFormatReader& reader, HZMp3Reader* mp3, int numThreads)
+    {
+        constexpr int scanBlock = 65536;
+
+        const int numChannels   = (int) reader.numChannels;
+        const juce::int64 inLen = reader.lengthInSamples;
+
+        juce::AudioBuffer<SampleType> buffer(numChannels, scanBlock);
+        BlockReader<SampleType> blockReader(reader, mp3, numChannels, scanBlock, numThreads);
+
+        for (juce::int64 pos = 0; pos < inLen; pos += scanBlock)
+        {
+            const int n = (int) juce::jmin((juce::int64) scanBlock, inLen - pos);
+
+            if (! blockReader.read(reader, buffer, pos, n) || ! areChannelsIdentical(buffer, n))
+                return false;
+        }
+
+        return true;
+    }
+
+    // ==========================================================
+    //  Seguimiento de un archivo que se esta grabando
+    //
+    //  Se sondea cada followPollMs. Termina con frames nuevos,
+    //  con el archivo cerrado por el grabador (HZPcmReader::
+    //  isClosed, y sin crecer en el ultimo sondeo) o cuando no
+    //  crece en idleSeconds (grabador colgado o que no cierra la
+    //  cabecera). Devuelve el largo con el que seguir.
+    // ==========================================================
+    constexpr int followPollMs = 250;
+
+    juce::int64 waitForInput(HZPcmReader& pcm, juce::int64 known, double idleSeconds)
+    {
+        const auto start = juce::Time::getMillisecondCounterHiRes();
+
+        for (;;)
+        {
+            juce::Thread::sleep(followPollMs);
+
+            if (! pcm.refresh())
+                return known;
+
+            if (pcm.getNumFrames() > known)
+                return pcm.getNumFrames();
+
+            // Si la cabecera final dice menos que lo ya leido (chunks
+            // detras del audio), lo convertido no se puede deshacer
+            if (pcm.isClosed())
+            {
+                logLine("Seguimiento: archivo cerrado por el grabador");
+                return known;
+            }
+
+            if (juce::Time::getMillisecondCounterHiRes() - start >= idleSeconds * 1000.0)
+            {
+                logLine("Seguimiento: sin datos nuevos en " + juce::String(idleSeconds, 1) + " s, se cierra");
+                return known;
+            }
+        }
+    }
+
+    // ==========================================================
+    //  Streaming: leer bloque -> resamplear -> escribir
+    //
+    //  Igual para todos los motores: al final se empuja la cola
+    //  de ceros y el motor genera hasta la ultima salida cuya
+    //  posicion cae dentro de la entrada.
+    //
+    //  makeEngine(numChannels) crea el motor. Con los canales
+    //  identicos se crea con uno solo y su salida se reparte
+    //  (los punteros del cuantizador apuntan todos al canal 0;
+    //  el dither sigue siendo propio de cada canal). Si en modo
+    //  por bloques un bloque difiere, los canales 1..N-1 pasan
+    //  a un segundo motor que se pone al dia releyendo desde el
+    //  principio: lo ya escrito era exacto y desde ahi el coste
+    //  es el de siempre.
+    //
+    //  Seguimiento (followInput): al llegar al final conocido
+    //  no se empuja la cola sino que se espera a que el archivo
+    //  crezca (waitForInput). El largo final queda en el reader.
+    // ==========================================================
+    template <typename SampleType, typename MakeEngine>
+    bool runStream(juce::AudioFormatReader& reader,
+                   HZMp3Reader* mp3,
+                   HZAudioWriter& writer,
+                   MakeEngine&& makeEngine,
+                   const HZConvertOptions& options,
+                   juce::int64& written,
+                   juce::String& outMessage)
+    {
+        const int numChannels = (int) reader.numChannels;
+        juce::int64 inLen     = reader.lengthInSamples;
+
+        // Por bloques se arranca compartido; con wholeFile se decide antes
+        // (en seguimiento no hay archivo entero: queda por bloques)
+        bool shared = numChannels > 1 && options.monoCheck != HZMonoCheck::off;
+
+        if (shared && options.monoCheck == HZMonoCheck::wholeFile && ! options.followInput)
+            shared = isDualMonoFile<SampleType>(reader, mp3, getNumThreads(options));
+
+        auto engine = makeEngine(shared ? 1 : numChannels);
+        decltype(engine) rest;   // canales 1..N-1 tras una divergencia
+
+        const int inBlock  = engine->getInputBlockSize();
+        const int outBlock = engine->getVariant().blockSize;
+
+        juce::AudioBuffer<SampleType> inBuffer(numChannels, inBlock);
+        juce::AudioBuffer<SampleType> outBuffer(numChannels, outBlock);
+        BlockReader<SampleType> blockReader(reader, mp3, numChannels, inBlock, getNumThreads(options),
+                                            options.followInput);
+
+        if (options.followInput && blockReader.pcm == nullptr)
+        {
+            outMessage = "Error: el seguimiento solo funciona con WAV/AIFF PCM.";
+            return false;
+        }
+
+        if (blockReader.pcm != nullptr)
+            logLine(juce::String("Lectura: PCM directo (") + (blockReader.pcm->isMapped() ? "mapeado" : "stream") + ")");
+        else if (blockReader.flac != nullptr)
+            logLine("Lectura: FLAC en paralelo (" + juce::String(blockReader.flac->getNumSegments()) + " segmentos, "
+                    + (blockReader.flac->getNumSeekPoints() > 0 ? "SEEKTABLE" : "sync") + ")");
+        else if (blockReader.mp3 != nullptr)
+            logLine("Lectura: MP3 en paralelo (" + juce::String(blockReader.mp3->getNumMpegFrames()) + " frames, "
+                    + juce::String(blockReader.mp3->getNumSegments()) + " segmentos"
+                    + (blockReader.mp3->getEncoderDelay() >= 0
+                           ? ", retardo " + juce::String(blockReader.mp3->getEncoderDelay())
+                             + " + relleno " + juce::String(blockReader.mp3->getPadding()) + " (LAME)"
+                           : juce::String()) + ")");
+        else
+            logLine("Lectura: AudioFormatReader");
+
+        // El writer cuantiza e intercala directo en su bloque de salida
+        juce::HeapBlock<const SampleType*> sharedOutput((size_t) numChannels);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            sharedOutput[ch] = outBuffer.getReadPointer(0);
+
+        // Lleva el segundo motor hasta readPos y descarta lo que ya se escribio
+        const auto catchUp = [&](juce::int64 readPos)
+        {
+            juce::AudioBuffer<SampleType> replay(numChannels, inBlock);
+            juce::int64 replayed = 0;
+
+            for (juce::int64 pos = 0; pos < readPos; pos += inBlock)
+            {
+                const int n = (int) juce::jmin((juce::int64) inBlock, readPos - pos);
+
+                if (! blockReader.read(reader, replay, pos, n))
+                    return false;
+
+                rest->pushInput(replay.getArrayOfReadPointers() + 1, n);
+
+                for (int produced; (produced = rest->produce(outBuffer.getArrayOfWritePointers() + 1, outBlock)) > 0;)
+                    replayed += produced;
+            }
+
+            jassert(replayed == written);
+            return replayed == written;
+        };
+
+        juce::int64 readPos = 0;
+        written = 0;
+
+        for (bool flushed = false; ! flushed;)
+        {
+            if (options.followInput && readPos >= inLen)
+            {
+                inLen = waitForInput(*blockReader.pcm, inLen, options.followIdleSeconds);
+                reader.lengthInSamples = inLen;
+            }
+
+            if (readPos < inLen)
+            {
+                const int n = (int) juce::jmin((juce::int64) inBlock, inLen - readPos);
+
+                if (! blockReader.read(reader, inBuffer, readPos, n))
+                {
+                    outMessage = "Error: fallo al leer el audio.";
+                    return false;
+                }
+
+                if (shared && options.monoCheck == HZMonoCheck::perBlock && ! areChannelsIdentical(inBuffer, n))
+                {
+                    logLine("Canales distintos desde el frame " + juce::String(readPos) + ": motor aparte para el resto");
+
+                    shared = false;
+                    rest = makeEngine(numChannels - 1);
+
+                    if (! catchUp(readPos))
+                    {
+                        outMessage = "Error: fallo al leer el audio.";
+                        return false;
+                    }
+                }
+
+                engine->pushInput(inBuffer.getArrayOfReadPointers(), n);
+
+                if (rest != nullptr)
+                    rest->pushInput(inBuffer.getArrayOfReadPointers() + 1, n);
+
+                readPos += n;
+            }
+            else
+            {
+                engine->pushSilence(engine->getFlushLength());
+
+                if (rest != nullptr)
+                    rest->pushSilence(rest->getFlushLength());
+
+                flushed = true;
+            }
+
+            for (;;)
+            {
+                const int produced = engine->produce(outBuffer.getArrayOfWritePointers(), outBlock);
+
+                if (produced <= 0)
+                    break;
+
+                if (rest != nullptr && rest->produce(outBuffer.getArrayOfWritePointers() + 1, produced) != produced)
+                {
+                    jassertfalse;
+                    return false;
+                }
+
+                if (! writer.write(shared ? sharedOutput.get() : outBuffer.getArrayOfReadPointers(), produced))
+                {
+                    outMessage = "Error al escribir el audio de salida.";
+                    return false;
+                }
+
+                written += produced;
+            }
+        }
+
+        if (shared)
+            logLine("Canales identicos: se resampleo solo el primero");
+
+        return true;
+    }
+
+    // N_out = ceil(N_in * L / M). Se evalua despues del streaming: en
+    // seguimiento el largo de la entrada se conoce recien al final
+    juce::int64 getOutputLength(const juce::AudioFormatReader& reader, HZRatio ratio) noexcept
+    {
+        return (reader.lengthInSamples * ratio.up + ratio.down - 1) / ratio.down;
+    }
+
+    // Ratio racional fijo
+    template <typename SampleType>
+    bool streamConversion(juce::AudioFormatReader& reader,
+                          HZMp3Reader* mp3,
+                          HZAudioWriter& writer,
+                          HZRatio ratio,
+                          double contentBandwidth,
+                          const HZConvertOptions& options,
+                          HZKernelVariant variant,
+                          juce::ThreadPool* pool,
+                          juce::int64& written,
+                          juce::String& outMessage)
+    {
+        const HZPolyphaseFilter<SampleType> filter(ratio, options.preset, options.phase, contentBandwidth);
+
+        const auto makeEngine = [&](int numChannels)
+        {
+            auto engine = std::make_unique<HZResamplerEngine<SampleType>>(filter, numChannels, variant);
+            engine->setThreadPool(pool);
+            return engine;
+        };
+
+        logLine("Ratio: " + ratio.toString() + " - preset=" + toString(options.preset)
+                + " - fase=" + toString(options.phase)
+                + " - taps=" + juce::String(filter.getNumTaps()));
+
+        return runStream<SampleType>(reader, mp3, writer, makeEngine, options, written, outMessage)
+                 && written == getOutputLength(reader, ratio);
+    }
+
+    // Ratios 2^k: cascada halfband (salta los taps nulos)
+    template <typename SampleType>
+    bool streamHalfbandConversion(juce::AudioFormatReader& reader,
+                                  HZMp3Reader* mp3,
+                                  HZAudioWriter& writer,
+                                  HZRatio ratio,
+                                  double contentBandwidth,
+                                  const HZConvertOptions& options,
+                                  HZKernelVariant variant,
+                                  juce::ThreadPool* pool,
+                                  juce::int64& written,
+                                  juce::String& outMessage)
+    {
+        bool logged = false;
+
+        const auto makeEngine = [&](int numChannels)
+        {
+            auto engine = std::make_unique<HZHalfbandResamplerEngine<SampleType>>(ratio, options.preset, numChannels,
+                                                                                  variant, contentBandwidth);
+            engine->setThreadPool(pool);
+
+            // Las etapas no dependen de los canales: se describen una vez
+            if (! std::exchange(logged, true))
+            {
+                juce::StringArray taps;
+
+                for (int s = 0; s < engine->getNumStages(); ++s)
+                    taps.add(juce::String(engine->getStageTaps(s)));
+
+                logLine("Ratio: " + ratio.toString() + " - halfband x" + juce::String(engine->getNumStages())
+                        + " - preset=" + toString(options.preset) + " - taps por etapa=" + taps.joinIntoString("/"));
+            }
+
+            return engine;
+        };
+
+        return runStream<SampleType>(reader, mp3, writer, makeEngine, options, written, outMessage)
+                 && written == getOutputLength(reader, ratio);
+    }
+
+    // Preset draft: etapas IIR allpass + sinc corto (previews)
+    template <typename SampleType>
+    bool streamDraftConversion(juce::AudioFormatReader& reader,
+                               HZMp3Reader* mp3,
+                               HZAudioWriter& writer,
+                               double inRate, double outRate,
+                               const HZConvertOptions& options,
+                               HZKernelVariant variant,
+                               juce::ThreadPool* pool,
+                               juce::int64& written,
+                               juce::String& outMessage)
+    {
+        const auto ratio = HZRatio::fromRates(inRate, outRate);
+        bool logged = false;
+
+        const auto makeEngine = [&](int numChannels)
+        {
+            auto engine = std::make_unique<HZDraftResamplerEngine<SampleType>>(inRate, outRate, numChannels, variant);
+            engine->setThreadPool(pool);
+
+            if (! std::exchange(logged, true))
+                logLine("Ratio: " + ratio.toString() + " - draft IIR [" + engine->getDescription() + "]"
+                        + " - secciones allpass por etapa=" + juce::String(engine->getSectionsPerStage()));
+
+            return engine;
+        };
+
+        return runStream<SampleType>(reader, mp3, writer, makeEngine, options, written, outMessage)
+                 && written == getOutputLength(reader, ratio);
+    }
+
+    // Ratio racional con tabla exacta demasiado grande (muchas fases,
+    // p.ej. 44100 -> 47952): posicion exacta, tabla interpolada acotada
+    template <typename SampleType>
+    bool streamCompactConversion(juce::AudioFormatReader& reader,
+                                 HZMp3Reader* mp3,
+                                 HZAudioWriter& writer,
+                                 HZRatio ratio,
+                                 double contentBandwidth,
+                                 const HZConvertOptions& options,
+                                 HZKernelVariant variant,
+                                 juce::ThreadPool* pool,
+                                 juce::int64& written,
+                                 juce::String& outMessage)
+    {
+        const HZVariablePolyphaseFilter<SampleType> filter(ratio.toDouble(), options.preset, hzCompactTableBytes,
+                                                           contentBandwidth);
+
+        const auto makeEngine = [&](int numChannels)
+        {
+            auto engine = std::make_unique<HZVariableResamplerEngine<SampleType>>(filter, numChannels, variant, ratio);
+            engine->setThreadPool(pool);
+            return engine;
+        };
+
+        const auto tableKb = [](size_t bytes) { return juce::String((bytes + 1023) / 1024) + " KB"; };
+
+        logLine("Ratio: " + ratio.toString() + " - tabla compacta - preset=" + toString(options.preset)
+                + " - taps=" + juce::String(filter.getNumTaps()) + " - fases=" + juce::String(filter.getNumPhases())
+                + " (" + tableKb((size_t) (filter.getNumPhases() + 1) * (size_t) filter.getNumTaps() * sizeof(SampleType))
+                + " en vez de " + tableKb(HZPolyphaseFilter<SampleType>::getTableBytes(ratio, options.preset)) + ")");
+
+        return runStream<SampleType>(reader, mp3, writer, makeEngine, options, written, outMessage)
+                 && written == getOutputLength(reader, ratio);
+    }
+
+    // Ratio arbitrario / con deriva: tabla interpolada. La rampa
+    // se reparte sobre la duracion estimada de la salida.
+    template <typename SampleType>
+    bool streamVariableConversion(juce::AudioFormatReader& reader,
+                                  HZMp3Reader* mp3,
+                                  HZAudioWriter& writer,
+                                  double inRate, double inRateEnd, double outRate,
+                                  double contentBandwidth,
+                                  const HZConvertOptions& options,
+                                  HZKernelVariant variant,
+                                  juce::ThreadPool* pool,
+                                  juce::int64& written,
+                                  juce::String& outMessage)
+    {
+        const HZVariablePolyphaseFilter<SampleType> filter(outRate / juce::jmax(inRate, inRateEnd), options.preset,
+                                                           0, contentBandwidth);
+        const double meanStep = 0.5 * (inRate + inRateEnd) / outRate;
+        const auto rampFrames = (juce::int64) std::ceil((double) reader.lengthInSamples / meanStep);
+
+        const auto makeEngine = [&](int numChannels)
+        {
+            auto engine = std::make_unique<HZVariableResamplerEngine<SampleType>>(filter, numChannels, variant, inRate / outRate);
+            engine->setThreadPool(pool);
+
+            if (inRateEnd != inRate)
+                engine->setInputStep(inRateEnd / outRate, rampFrames);
+
+            return engine;
+        };
+
+        logLine("Ratio variable: " + juce::String(inRate, 4)
+                + (inRateEnd != inRate ? " -> " + juce::String(inRateEnd, 4) : juce::String())
+                + " / " + juce::String(outRate, 4) + " - preset=" + toString(options.preset)
+                + " - taps=" + juce::String(filter.getNumTaps()) + " - fases=" + juce::String(filter.getNumPhases()));
+
+        return runStream<SampleType>(reader, mp3, writer, makeEngine, options, written, outMessage);
+    }
 }
 
 // ==========================================================
@@ -34,12 +651,162 @@ double HZResampler::detectSampleRate(const juce::File& file)
 }
 
 // ==========================================================
-//  Convertir Sample Rate (lectura completa + Lagrange)
+//  Familias de frecuencias (broadcast / video)
+// ==========================================================
+namespace
+{
+    // Nominales reconocidas: 11025 * n (44.1k) y 8000 * n (48k)
+    constexpr int standardRates[] = { 8000, 11025, 12000, 16000, 22050, 24000, 32000,
+                                      44100, 48000, 88200, 96000, 176400, 192000 };
+
+    bool isStandardRate(double rate)
+    {
+        for (auto r : standardRates)
+            if (rate == (double) r)
+                return true;
+
+        return false;
+    }
+}
+
+juce::String toString(HZEngineKind kind)
+{
+    switch (kind)
+    {
+        case HZEngineKind::rational: return "racional";
+        case HZEngineKind::compact:  return "tabla compacta";
+        case HZEngineKind::halfband: return "halfband";
+        case HZEngineKind::draft:    return "draft IIR";
+        case HZEngineKind::variable: return "ratio variable";
+    }
+
+    return {};
+}
+
+juce::String HZRateInfo::getDescription() const
+{
+    if (! isKnown())
+        return "no estandar";
+
+    auto s = HZResampler::formatRate(nominalRate).upToFirstOccurrenceOf(" ", false, false) + "k";
+
+    if (pull < 0) s << " pull-down (NTSC)";
+    if (pull > 0) s << " pull-up (NTSC)";
+
+    return s;
+}
+
+HZRateInfo HZResampler::identifyRate(double sampleRate)
+{
+    HZRateInfo info;
+    info.rate = sampleRate;
+
+    for (auto r : standardRates)
+    {
+        const double nominal = (double) r;
+        int pull = 0;
+
+        if (std::abs(sampleRate - nominal) < 0.5)
+            pull = 0;
+        else if (std::abs(sampleRate - nominal * 1000.0 / 1001.0) < 1.0)
+            pull = -1;
+        else if (std::abs(sampleRate - nominal * 1001.0 / 1000.0) < 1.0)
+            pull = 1;
+        else
+            continue;
+
+        info.nominalRate = nominal;
+        info.pull = pull;
+        info.family = (r % 11025 == 0 ? HZRateFamily::khz44 : HZRateFamily::khz48);
+        break;
+    }
+
+    return info;
+}
+
+double HZResampler::getDefaultTargetRate(double sampleRate)
+{
+    const auto info = identifyRate(sampleRate);
+
+    if (! info.isKnown())
+        return 0.0;
+
+    // Video: deshacer el pull sin cambiar de familia (L/M = 1000/999 o 1000/1001)
+    if (info.pull != 0)
+        return info.nominalRate;
+
+    // 44.1k <-> 48k al mismo multiplo: siempre 160/147
+    if (info.family == HZRateFamily::khz44)
+        return info.nominalRate * 160.0 / 147.0;
+
+    const double other = info.nominalRate * 147.0 / 160.0;
+
+    if (isStandardRate(other))
+        return other;
+
+    // 32k / 16k / 8k no tienen par en 44.1k: a 48k (3/2, 3/1, 6/1)
+    return 48000.0;
+}
+
+juce::Array<double> HZResampler::getTargetRates()
+{
+    return { 32000.0, 44056.0, 44100.0, 44144.0, 47952.0, 48000.0, 48048.0,
+             88200.0, 96000.0, 176400.0, 192000.0 };
+}
+
+juce::String HZResampler::formatRate(double sampleRate)
+{
+    auto s = juce::String(sampleRate / 1000.0, 3);
+
+    if (s.containsChar('.'))
+        s = s.trimCharactersAtEnd("0").trimCharactersAtEnd(".");
+
+    return s + " kHz";
+}
+
+HZEngineKind HZResampler::chooseEngine(double inRate, double newRate, const HZConvertOptions& options)
+{
+    const double actualRate    = options.inputRate > 0.0 ? options.inputRate : inRate;
+    const double actualRateEnd = options.inputRateEnd > 0.0 ? options.inputRateEnd : actualRate;
+
+    // Valores no enteros o con rampa: no hay ratio racional util
+    const auto isWhole = [](double r) { return r == std::floor(r); };
+
+    if (! isWhole(actualRate) || ! isWhole(newRate) || actualRateEnd != actualRate)
+        return HZEngineKind::variable;
+
+    const auto ratio = HZRatio::fromRates(actualRate, newRate);
+
+    // Preset draft: IIR polifasico en los ratios racionales. La fase
+    // minima sigue por las rutas FIR
+    if (options.preset == HZPreset::draft && options.phase == HZPhaseResponse::linear
+          && HZDraftResamplerEngine<float>::supportsRates(actualRate, newRate))
+        return HZEngineKind::draft;
+
+    // Halfband y tabla compacta: solo fase lineal
+    if (options.phase != HZPhaseResponse::linear || ! ratio.isValid())
+        return HZEngineKind::rational;
+
+    // 2x / 4x / ...: etapas halfband
+    if (HZHalfbandResamplerEngine<float>::supportsRatio(ratio))
+        return HZEngineKind::halfband;
+
+    // Tabla de L fases fuera de cache (44056 -> 44100: L = 11025):
+    // tabla interpolada acotada
+    const auto tableBytes = options.doublePrecision ? HZPolyphaseFilter<double>::getTableBytes(ratio, options.preset)
+                                                    : HZPolyphaseFilter<float>::getTableBytes(ratio, options.preset);
+
+    return tableBytes > hzExactTableLimitBytes ? HZEngineKind::compact : HZEngineKind::rational;
+}
+
+// ==========================================================
+//  Convertir Sample Rate (streaming por bloques + polifasico)
 // ==========================================================
 juce::File HZResampler::convertSampleRate(const juce::File& input,
                                           double newRate,
                                           bool overwrite,
-                                          juce::String& outMessage)
+                                          juce::String& outMessage,
+                                          const HZConvertOptions& options)
 {
     outMessage.clear();
 
@@ -52,151 +819,327 @@ juce::File HZResampler::convertSampleRate(const juce::File& input,
     juce::AudioFormatManager fm;
     fm.registerBasicFormats();
 
-    std::unique_ptr<juce::AudioFormatReader> reader(fm.createReaderFor(input));
+    if (options.followInput && overwrite)
+    {
+        outMessage = "Error: no se puede sobrescribir un archivo que se esta grabando.";
+        return juce::File();
+    }
+
+    // Seguimiento: el reader sale de la cabecera del archivo, no del de JUCE
+    // (que no abre un RIFF / FORM de tamaño 0, lo que suelen dejar los
+    // grabadores hasta cerrar). El largo es lo que ya esta en disco
+    auto reader = options.followInput ? HZPcmReader::createFollowReader(input)
+                                      : std::unique_ptr<juce::AudioFormatReader>(fm.createReaderFor(input));
     if (reader == nullptr)
     {
-        outMessage = "Error: no se pudo leer el archivo.";
+        outMessage = options.followInput && input.existsAsFile()
+                       ? "Error: el seguimiento solo funciona con WAV/AIFF PCM."
+                       : "Error: no se pudo leer el archivo.";
         return juce::File();
     }
 
+    // MP3: el largo sale del indice de frames (el de JUCE es una estimacion
+    // sin tag Xing y cuenta el retardo y el relleno del encoder). El mismo
+    // reader sirve despues para el escaneo dual mono y la conversion
+    std::unique_ptr<HZMp3Reader> mp3(HZMp3Reader::create(*reader, getNumThreads(options)));
+
+    if (mp3 != nullptr)
+        reader->lengthInSamples = mp3->getNumFrames();
+
     const int numChannels   = (int) reader->numChannels;
     const double inRate     = reader->sampleRate;
     const juce::int64 inLen = reader->lengthInSamples;
 
-    if (numChannels <= 0 || inLen <= 0)
+    if (numChannels <= 0 || inLen < 0 || (inLen == 0 && ! options.followInput))
     {
         outMessage = "Error: archivo de audio vacio o invalido.";
         return juce::File();
     }
 
-    if (std::abs(inRate - newRate) < 1.0)
+    // Reloj real de la entrada (deriva); con valores no enteros o con
+    // rampa no hay ratio racional util y se usa el motor variable
+    const double actualRate    = options.inputRate > 0.0 ? options.inputRate : inRate;
+    const double actualRateEnd = options.inputRateEnd > 0.0 ? options.inputRateEnd : actualRate;
+
+    if (std::abs(actualRate / inRate - 1.0) > 0.05 || std::abs(actualRateEnd / inRate - 1.0) > 0.05)
     {
-        outMessage = "El archivo ya esta en ese Sample Rate.";
-        return input;
+        outMessage = "Error: la frecuencia real se aleja demasiado del header.";
+        return juce::File();
     }
 
-    // ========= LOG DE ENTRADA =========
-    logLine("==== Iniciando conversion ====");
-    logLine("Archivo: " + input.getFullPathName());
-    logLine("Canales: " + juce::String(numChannels));
-    logLine("SampleRate origen: " + juce::String(inRate));
-    logLine("SampleRate destino: " + juce::String(newRate));
-    logLine("Samples totales: " + juce::String(inLen));
-
-    // ======================================================
-    // 1) Leer TODO el archivo en memoria
-    // ======================================================
-    if (inLen > std::numeric_limits<int>::max())
+    // La rampa se reparte sobre la duracion total, que en seguimiento no se sabe
+    if (options.followInput && actualRateEnd != actualRate)
     {
-        outMessage = "Error: archivo demasiado largo para este metodo.";
+        outMessage = "Error: la deriva con rampa necesita el archivo completo.";
         return juce::File();
     }
 
-    const int inSamplesInt = (int) inLen;
+    const auto engine = chooseEngine(inRate, newRate, options);
+    const bool variableRatio = (engine == HZEngineKind::variable);
 
-    juce::AudioBuffer<float> readBuffer(numChannels, inSamplesInt);
-    if (! reader->read(&readBuffer, 0, inSamplesInt, 0, true, true))
+    const auto ratio = HZRatio::fromRates(actualRate, newRate);
+    if (! ratio.isValid())
     {
-        outMessage = "Error: fallo al leer el audio.";
+        outMessage = "Error: Sample Rate invalido.";
         return juce::File();
     }
 
+    if (! variableRatio && std::abs(actualRate - newRate) < 1.0)
+    {
+        outMessage = "El archivo ya esta en ese Sample Rate.";
+        return input;
+    }
+
     // ======================================================
-    // 2) Calcular muestras de salida y crear buffer salida
-    //    N_out = ceil(newRate * N_in / inRate)
+    // 1) Kernel + variante elegida por el autotune
     // ======================================================
-    const double ratioSR    = newRate / inRate;
-    const juce::int64 outLen64 = (juce::int64) std::ceil(ratioSR * (double) inLen);
+    const auto preset = options.preset;
+    // El draft no usa el kernel FIR: no hay nada que afinar
+    auto variant = engine == HZEngineKind::draft ? HZKernelVariant() : HZAutotune::getVariant(engine, ratio, preset);
+
+    // Layout y bloque no cambian el resultado; la ISA si (FMA, orden de suma)
+    if (options.deterministic)
+        variant.isa = getCanonicalIsa();
 
-    if (outLen64 <= 0 || outLen64 > std::numeric_limits<int>::max())
+    if (options.blockSize > 0)
+        variant.blockSize = options.blockSize;
+
+    const int numThreads = getNumThreads(options);
+    std::unique_ptr<juce::ThreadPool> pool;
+
+    if (numThreads > 1)
+        pool = std::make_unique<juce::ThreadPool>(numThreads - 1);
+
+
+    // ========= LOG DE ENTRADA =========
+    logLine("==== Iniciando conversion ====");
+    logLine("Archivo: " + input.getFullPathName());
+    logLine("Canales: " + juce::String(numChannels));
+    logLine("SampleRate origen: " + juce::String(inRate) + " (" + identifyRate(inRate).getDescription() + ")");
+    if (actualRate != inRate || actualRateEnd != actualRate)
+        logLine("SampleRate real: " + juce::String(actualRate, 4)
+                + (actualRateEnd != actualRate ? " -> " + juce::String(actualRateEnd, 4) : juce::String()));
+    logLine("SampleRate destino: " + juce::String(newRate) + " (" + identifyRate(newRate).getDescription() + ")");
+    logLine("Samples totales: " + juce::String(inLen) + (options.followInput ? " (grabando: seguimiento)" : ""));
+    logLine("Variante: isa=" + toString(variant.isa)
+            + " layout=" + toString(variant.layout)
+            + " bloque=" + juce::String(variant.blockSize)
+            + " hilos=" + juce::String(numThreads)
+            + (options.deterministic ? " (determinista)" : "")
+            + (options.doublePrecision ? " (doble)" : ""));
+
+    const bool flac = options.container == HZContainer::flac;
+    auto outputFormat = options.outputFormat != HZSampleFormat::source ? options.outputFormat
+                                                                       : getSourceFormat(*reader);
+
+    if (flac && ! HZFlacWriter::supportsFormat(outputFormat))
+    {
+        if (options.outputFormat != HZSampleFormat::source)
+        {
+            outMessage = "Error: FLAC solo admite 16 o 24 bits.";
+            return juce::File();
+        }
+
+        outputFormat = HZSampleFormat::int24;
+    }
+
+    if (flac && numChannels > 8)
     {
-        outMessage = "Error: longitud de salida invalida.";
+        outMessage = "Error: FLAC admite hasta 8 canales.";
         return juce::File();
     }
 
-    const int outSamplesInt = (int) outLen64;
-    juce::AudioBuffer<float> outBuffer(numChannels, outSamplesInt);
-    outBuffer.clear();
+    logLine("Salida: " + juce::String(flac ? "FLAC " : "") + toString(outputFormat)
+            + (options.outputFormat == HZSampleFormat::source ? " (de la entrada)" : "")
+            + (isFloatFormat(outputFormat) ? juce::String() : " - dither=" + toString(options.dither)));
 
-    // ======================================================
-    // 3) Resampling por canal con LagrangeInterpolator
-    //    IMPORTANTE: ratio = inRate / newRate
-    //    y el ultimo parametro es el NUMERO DE MUESTRAS DE SALIDA
-    // ======================================================
-    const float* inPtr  = nullptr;
-    float*       outPtr = nullptr;
+    // Ancho de banda del contenido (medido en un lote o con el
+    // pre-escaneo): recortado en B, el kernel FIR se acorta
+    // (transicion [B, min - B]) con la misma atenuacion
+    double bandwidthHz = options.contentBandwidthHz;
+    double contentBandwidth = 0.0;
 
-    for (int ch = 0; ch < numChannels; ++ch)
+    if (engine != HZEngineKind::draft)
     {
-        juce::LagrangeInterpolator interp;
-        interp.reset();
+        if (bandwidthHz <= 0.0 && options.adaptiveKernel)
+        {
+            const auto scan = HZContentAnalyzer::measureBandwidth(*reader, getAttenuationDb(options.preset));
+            bandwidthHz = scan.bandwidthHz;
 
-        inPtr  = readBuffer.getReadPointer(ch);
-        outPtr = outBuffer.getWritePointer(ch);
+            if (! scan.isValid())
+                logLine("Ancho de banda: sin medida, kernel completo");
+        }
 
-        const double speedRatio = inRate / newRate;
+        if (bandwidthHz > 0.0)
+        {
+            contentBandwidth = bandwidthHz / juce::jmin(juce::jmax(actualRate, actualRateEnd), newRate);
 
-        const int consumed = interp.process(speedRatio,
-                                            inPtr,
-                                            outPtr,
-                                            outSamplesInt);
-
-        // Log basico por canal
-        logLine("Canal " + juce::String(ch) +
-                " - outSamples=" + juce::String(outSamplesInt) +
-                " - inConsumidos=" + juce::String(consumed));
+            logLine("Ancho de banda: " + juce::String(bandwidthHz / 1000.0, 2) + " kHz"
+                    + (options.contentBandwidthHz > 0.0 ? " (medido en el lote)" : " (pre-escaneo)")
+                    + " - " + juce::String(contentBandwidth, 3) + " de la frecuencia menor");
+        }
     }
 
     // ======================================================
-    // 4) Preparar archivo de salida junto al original
+    // 2) Preparar archivo de salida junto al original.
+    //    Se escribe en un temporal: el original se sigue
+    //    leyendo mientras tanto (modo sobrescribir).
     // ======================================================
     juce::File output = input;
 
+    // Sobrescribir en FLAC: el original se reemplaza por el .flac (se
+    // borra recien cuando la salida ya esta en su lugar)
+    if (overwrite && flac)
+        output = input.withFileExtension(".flac");
+
     if (! overwrite)
     {
-        juce::String suffix = (newRate > inRate ? "_48hz" : "_44hz");
+        // Sufijo con el destino real: _48k, _44k1, _47k952
+        const auto khz = formatRate(newRate).upToFirstOccurrenceOf(" ", false, false);
+        juce::String suffix = "_" + (khz.containsChar('.') ? khz.replaceCharacter('.', 'k') : khz + "k");
+
         auto parent = input.getParentDirectory();
-        auto newName = input.getFileNameWithoutExtension() + suffix + ".wav";
+        auto newName = input.getFileNameWithoutExtension() + suffix + (flac ? ".flac" : ".wav");
         output = parent.getChildFile(newName);
     }
 
-    juce::WavAudioFormat wav;
-    std::unique_ptr<juce::FileOutputStream> outStream(output.createOutputStream());
+    // Progresivo: directo en el destino, para que se pueda leer mientras crece
+    const bool progressive = options.progressiveSeconds > 0.0 && ! overwrite;
 
-    if (outStream == nullptr)
+    juce::TemporaryFile tempOutput(output);
+    std::unique_ptr<juce::FileOutputStream> outStream((progressive ? output : tempOutput.getFile()).createOutputStream());
+    auto* fileStream = outStream.get();
+
+    // FileOutputStream abre al final de un archivo existente: se escribe
+    // desde el principio y el resto se corta con la cabecera ya en disco
+    // (el destino nunca queda vacio ni invalido)
+    if (outStream == nullptr || (progressive && ! outStream->setPosition(0)))
     {
         outMessage = "Error: no se pudo crear el archivo de salida.";
         return juce::File();
     }
 
-    auto* rawStream = outStream.get();
-    std::unique_ptr<juce::AudioFormatWriter> writer(
-        wav.createWriterFor(rawStream,
-                            newRate,
-                            (unsigned int) numChannels,
-                            24,              // bits de salida
-                            {},              // metadata vacia
-                            0));             // calidad por defecto
+    // El writer es dueño del stream (cabecera WAV igual a la de JUCE)
+    std::unique_ptr<HZAudioWriter> writer;
+    HZWavWriter* wavWriter = nullptr;
 
-    // El writer ahora es dueño del stream:
-    outStream.release();
+    if (flac)
+    {
+        writer = std::make_unique<HZFlacWriter>(std::move(outStream), newRate, numChannels,
+                                                outputFormat, options.dither, numThreads);
+    }
+    else
+    {
+        auto wav = std::make_unique<HZWavWriter>(std::move(outStream), newRate, numChannels,
+                                                 outputFormat, options.dither, options.bw64);
+        wavWriter = wav.get();
+        writer = std::move(wav);
+    }
 
-    if (writer == nullptr)
+    // Metadatos de la entrada WAV (BWF, iXML, marcadores, loops): van
+    // despues del audio, con los tiempos a la frecuencia nueva
+    if (options.copyMetadata && ! options.followInput)
     {
-        outMessage = "Error: no se pudo crear el writer WAV.";
-        delete rawStream; // por si createWriterFor fallo
+        if (auto metadata = HZWavMetadata::create(input))
+        {
+            if (wavWriter != nullptr)
+            {
+                metadata->setRates(inRate, actualRate, actualRateEnd, newRate, inLen, outputFormat);
+                logLine("Metadatos: " + metadata->getDescription());
+                wavWriter->setMetadata(std::move(metadata));
+            }
+            else
+            {
+                logLine("Metadatos: no se copian a FLAC (" + metadata->getDescription() + ")");
+            }
+        }
+    }
+
+    if (! writer->isOk())
+    {
+        outMessage = juce::String("Error: no se pudo crear el writer ") + (flac ? "FLAC." : "WAV.");
         return juce::File();
     }
 
-    const bool ok = writer->writeFromAudioSampleBuffer(outBuffer, 0, outSamplesInt);
+    if (progressive)
+    {
+        writer->setProgressiveHeader(options.progressiveSeconds);
+
+        if (fileStream->truncate().failed())
+        {
+            outMessage = "Error: no se pudo crear el archivo de salida.";
+            return juce::File();
+        }
+
+        logLine(flac ? juce::String("Salida progresiva: frames FLAC al disco por lote")
+                     : "Salida progresiva: cabecera cada " + juce::String(options.progressiveSeconds, 1) + " s");
+    }
+
+    // ======================================================
+    // 3) Streaming (misma infraestructura en float y double)
+    // ======================================================
+    juce::int64 written = 0;
+    bool ok = false;
+
+    if (variableRatio)
+        ok = options.doublePrecision
+               ? streamVariableConversion<double>(*reader, mp3.get(), *writer, actualRate, actualRateEnd, newRate, contentBandwidth, options, variant, pool.get(), written, outMessage)
+               : streamVariableConversion<float> (*reader, mp3.get(), *writer, actualRate, actualRateEnd, newRate, contentBandwidth, options, variant, pool.get(), written, outMessage);
+    else if (engine == HZEngineKind::draft)
+        ok = options.doublePrecision
+               ? streamDraftConversion<double>(*reader, mp3.get(), *writer, actualRate, newRate, options, variant, pool.get(), written, outMessage)
+               : streamDraftConversion<float> (*reader, mp3.get(), *writer, actualRate, newRate, options, variant, pool.get(), written, outMessage);
+    else if (engine == HZEngineKind::compact)
+        ok = options.doublePrecision
+               ? streamCompactConversion<double>(*reader, mp3.get(), *writer, ratio, contentBandwidth, options, variant, pool.get(), written, outMessage)
+               : streamCompactConversion<float> (*reader, mp3.get(), *writer, ratio, contentBandwidth, options, variant, pool.get(), written, outMessage);
+    else if (engine == HZEngineKind::halfband)
+        ok = options.doublePrecision
+               ? streamHalfbandConversion<double>(*reader, mp3.get(), *writer, ratio, contentBandwidth, options, variant, pool.get(), written, outMessage)
+               : streamHalfbandConversion<float> (*reader, mp3.get(), *writer, ratio, contentBandwidth, options, variant, pool.get(), written, outMessage);
+    else
+        ok = options.doublePrecision
+               ? streamConversion<double>(*reader, mp3.get(), *writer, ratio, contentBandwidth, options, variant, pool.get(), written, outMessage)
+               : streamConversion<float> (*reader, mp3.get(), *writer, ratio, contentBandwidth, options, variant, pool.get(), written, outMessage);
+
+    // Cerrar la salida (cabecera) y liberar la entrada antes de reemplazar
+    if (! writer->finish() && ok)
+    {
+        ok = false;
+        outMessage = "Error al escribir el audio de salida.";
+    }
+
+    if (ok && wavWriter != nullptr && wavWriter->isLargeFile())
+        logLine(juce::String("Salida de mas de 4 GB: cabecera ") + (options.bw64 ? "BW64" : "RF64"));
+
+    if (options.followInput)
+        logLine("Seguimiento: samples de entrada al cerrar: " + juce::String(reader->lengthInSamples));
+
+    writer.reset();
+    mp3.reset();
+    reader.reset();
 
     if (! ok)
+    {
+        if (outMessage.isEmpty())
+            outMessage = "Error al escribir el audio de salida.";
+
+        if (progressive)
+            output.deleteFile();
+
+        return juce::File();
+    }
+
+    if (! progressive && ! tempOutput.overwriteTargetFileWithTemporary())
     {
         outMessage = "Error al escribir el audio de salida.";
         return juce::File();
     }
 
-    logLine("Total frames escritos: " + juce::String(outSamplesInt));
+    if (overwrite && output != input && ! input.deleteFile())
+        logLine("No se pudo borrar el original: " + input.getFullPathName());
+
+    logLine("Total frames escritos: " + juce::String(written));
     logLine("==== Conversion finalizada OK ====\n");
 
     outMessage = "Archivo guardado en: " + output.getFullPathName();
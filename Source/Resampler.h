@@ -1,15 +1,179 @@
 #pragma once
 #include "JuceHeader.h"
+#include "ResamplerEngine.h"
+#include "ResamplerDither.h"
+
+/** Deteccion de canales identicos (dual mono): se resamplea uno solo. */
+enum class HZMonoCheck
+{
+    off,
+    perBlock,   // cada bloque al leerlo; si uno difiere, el resto se pone al dia
+    wholeFile   // una pasada previa por todo el archivo (sin relectura a mitad)
+};
+
+/** Contenedor del archivo de salida. */
+enum class HZContainer
+{
+    wav,
+    flac    // 16 o 24 bits, frames codificados en paralelo
+};
+
+struct HZConvertOptions
+{
+    HZPreset preset = HZPreset::standard;
+
+    /** Hilos para el resampling y para codificar / decodificar FLAC
+        (0 = todos los nucleos). */
+    int numThreads = 0;
+
+    /** Frames de salida por bloque (0 = el elegido por el autotune). */
+    int blockSize = 0;
+
+    /** Salida identica bit a bit en cualquier maquina, con cualquier numero
+        de hilos y tamaño de bloque: fija la ISA con orden canonico. */
+    bool deterministic = false;
+
+    /** Motor en doble precision (masters): decodifica a double y
+        cuantiza directo desde double al escribir. */
+    bool doublePrecision = false;
+
+    /** Formato de muestra del WAV de salida. source mantiene el de la
+        entrada (16 bits sigue en 16, float en float). */
+    HZSampleFormat outputFormat = HZSampleFormat::source;
+
+    /** WAV o FLAC. FLAC solo admite 16 y 24 bits: con outputFormat
+        source, una entrada float o de 32 bits sale en 24. Al sobrescribir
+        en FLAC, el original se reemplaza por un .flac del mismo nombre. */
+    HZContainer container = HZContainer::wav;
+
+    /** Dither aplicado al cuantizar a un formato entero. */
+    HZDitherMode dither = HZDitherMode::tpdf;
+
+    /** Salidas de mas de 4 GB: la cabecera pasa a RF64 al cerrar (sin
+        reescribir el audio). true usa el id BW64 (ITU-R BS.2088), que
+        el reader de JUCE no abre. */
+    bool bw64 = false;
+
+    /** Chunks del WAV de entrada (bext, iXML, cue, smpl, LIST...) copiados
+        a la salida WAV tal cual, con marcadores, loops y marcas de tiempo
+        pasados a la frecuencia nueva. No aplica a FLAC ni en seguimiento
+        (el archivo todavia no esta cerrado). */
+    bool copyMetadata = true;
+
+    /** > 0: la salida se escribe directo en el destino (sin temporal)
+        y la cabecera se pone al dia cada progressiveSeconds, asi el
+        archivo a medio convertir es un WAV valido que se puede ir
+        leyendo. No aplica al sobrescribir (el original se esta leyendo);
+        si la conversion falla, el parcial se borra. */
+    double progressiveSeconds = 0.0;
+
+    /** Entrada que todavia se esta grabando (WAV/AIFF PCM): al llegar al
+        final conocido se espera a que crezca y se sigue convirtiendo.
+        Termina cuando el grabador cierra el archivo (cabecera con los
+        tamaños finales) o cuando no crece en followIdleSeconds. Junto
+        con progressiveSeconds, la salida se puede ir leyendo. */
+    bool followInput = false;
+    double followIdleSeconds = 10.0;
+
+    /** Fase del kernel del motor racional. minimum recorta la latencia a
+        pocas muestras a cambio de retrasar la salida su retardo de grupo. */
+    HZPhaseResponse phase = HZPhaseResponse::linear;
+
+    /** Pre-escaneo con FFT de unos segundos del archivo: si el contenido
+        esta recortado (upsample de 44.1k, voz) el kernel FIR se acorta
+        manteniendo la atenuacion del preset. No aplica al draft. */
+    bool adaptiveKernel = false;
+
+    /** Ancho de banda ya medido (p.ej. por HZContentAnalyzer::scanFiles
+        en un lote), en Hz. > 0: se usa tal cual, sin pre-escaneo. */
+    double contentBandwidthHz = 0.0;
+
+    /** Canales bit a bit iguales: un solo canal pasa por el motor y su
+        salida se copia (el dither de cada canal no cambia). */
+    HZMonoCheck monoCheck = HZMonoCheck::perBlock;
+
+    /** Frecuencia real de la entrada cuando el reloj del equipo se
+        desvia del valor del header (p.ej. 47998.7). 0 = la del header.
+        Un valor no entero usa el motor de ratio variable. */
+    double inputRate = 0.0;
+
+    /** Frecuencia real al final del archivo: la deriva se corrige con
+        una rampa lineal desde inputRate. 0 = deriva constante. */
+    double inputRateEnd = 0.0;
+};
+
+// ==========================================================
+//  Familias de frecuencias
+//
+//  44.1k: 11025 * n (CD, 88.2k, 176.4k)
+//  48k:   8000 * n (broadcast 32k, 48k, 96k, 192k)
+//
+//  Mas las variantes de video (NTSC), la nominal con pull:
+//    pull-down x1000/1001: 47952, 44056
+//    pull-up   x1001/1000: 48048, 44144
+// ==========================================================
+enum class HZRateFamily
+{
+    khz44,
+    khz48,
+    unknown
+};
+
+struct HZRateInfo
+{
+    double rate = 0.0;
+    HZRateFamily family = HZRateFamily::unknown;
+    double nominalRate = 0.0;   // sin pull; 0 = frecuencia no reconocida
+    int pull = 0;               // -1 pull-down, +1 pull-up
+
+    bool isKnown() const noexcept { return nominalRate > 0.0; }
+
+    /** P.ej. "48k pull-down (NTSC)" o "44.1k". */
+    juce::String getDescription() const;
+};
+
+/** Motor que usa convertSampleRate para un par de frecuencias. */
+enum class HZEngineKind
+{
+    rational,   // tabla exacta de L fases
+    compact,    // tabla interpolada acotada (L grande)
+    halfband,   // ratios 2^k
+    draft,      // IIR allpass + sinc corto
+    variable    // ratio no racional o con deriva
+};
+
+juce::String toString(HZEngineKind kind);
 
 class HZResampler
 {
 public:
     static double detectSampleRate(const juce::File& file);
 
+    /** Familia y pull de una frecuencia de header (tolerancia de 1 Hz
+        en las variantes de video, que se redondean al escribirse). */
+    static HZRateInfo identifyRate(double sampleRate);
+
+    /** Destino por defecto: las variantes de video vuelven a su nominal
+        (47952 -> 48000), 44.1k <-> 48k al mismo multiplo (88200 -> 96000)
+        y 32k / 16k / 8k suben a 48k. 0 si la frecuencia no se reconoce:
+        el destino lo tiene que elegir el usuario. */
+    static double getDefaultTargetRate(double sampleRate);
+
+    /** Destinos que ofrece la GUI, de menor a mayor. */
+    static juce::Array<double> getTargetRates();
+
+    /** "44.1 kHz", "47.952 kHz". */
+    static juce::String formatRate(double sampleRate);
+
+    /** Motor que usaria convertSampleRate (inputRate / inputRateEnd de
+        las opciones incluidos). */
+    static HZEngineKind chooseEngine(double inRate, double newRate, const HZConvertOptions& options = {});
+
     static juce::File convertSampleRate(
         const juce::File& input,
         double newRate,
         bool overwrite,
-        juce::String& outMessage
+        juce::String& outMessage,
+        const HZConvertOptions& options = {}
     );
 };
@@ -0,0 +1,221 @@
+#include "ResamplerAnalysis.h"
+#include <atomic>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+    constexpr int fftOrder = 13;
+    constexpr int fftSize  = 1 << fftOrder;
+    constexpr int maxWindows = 64;
+
+    // El pico de referencia ignora los bins por debajo de ~20 Hz: un
+    // offset de DC bajaria el umbral y haria parecer vacia la banda alta
+    constexpr double minReferenceHz = 20.0;
+
+    // Por archivo en los lotes: la mitad que el pre-escaneo
+    constexpr double batchScanSeconds = 2.0;
+
+    constexpr double originRates[] = { 8000.0, 11025.0, 16000.0, 22050.0, 32000.0, 44100.0,
+                                       48000.0, 88200.0, 96000.0, 176400.0, 192000.0 };
+
+    HZFileScan scanFile(const juce::File& file, double attenuationDb)
+    {
+        HZFileScan scan;
+        scan.file = file;
+
+        // Un AudioFormatManager por hilo: los readers no se comparten
+        juce::AudioFormatManager fm;
+        fm.registerBasicFormats();
+
+        std::unique_ptr<juce::AudioFormatReader> reader(fm.createReaderFor(file));
+
+        if (reader == nullptr)
+        {
+            scan.error = "no se pudo leer el archivo";
+            return scan;
+        }
+
+        scan.sampleRate = reader->sampleRate;
+        scan.bandwidth  = HZContentAnalyzer::measureBandwidth(*reader, attenuationDb, batchScanSeconds);
+        scan.originRate = HZContentAnalyzer::estimateOriginRate(scan.bandwidth.bandwidthHz, scan.sampleRate);
+
+        if (! scan.bandwidth.isValid())
+            scan.error = "sin medida (silencio o archivo corto)";
+
+        return scan;
+    }
+}
+
+HZBandwidthScan HZContentAnalyzer::measureBandwidth(juce::AudioFormatReader& reader,
+                                                    double attenuationDb,
+                                                    double scanSeconds)
+{
+    HZBandwidthScan result;
+    result.sampleRate = reader.sampleRate;
+
+    const int numChannels   = (int) reader.numChannels;
+    const juce::int64 inLen = reader.lengthInSamples;
+    const double sampleRate = reader.sampleRate;
+
+    if (numChannels <= 0 || inLen < fftSize || sampleRate <= 0.0)
+        return result;
+
+    const auto wanted = (juce::int64) std::ceil(scanSeconds * sampleRate / fftSize);
+    const int numWindows = (int) juce::jlimit((juce::int64) 1, (juce::int64) maxWindows,
+                                              juce::jmin(wanted, inLen / fftSize));
+
+    // Kaiser: lobulo lateral ~ 20 dB por debajo del umbral
+    const double beta = 0.1102 * (attenuationDb + 20.0 - 8.7);
+
+    juce::dsp::FFT fft(fftOrder);
+    juce::dsp::WindowingFunction<float> window((size_t) fftSize,
+                                               juce::dsp::WindowingFunction<float>::kaiser,
+                                               false, (float) beta);
+
+    juce::AudioBuffer<float> block(numChannels, fftSize);
+    std::vector<float> fftData((size_t) fftSize * 2);
+    std::vector<float> peakHold((size_t) fftSize / 2 + 1, 0.0f);
+
+    for (int w = 0; w < numWindows; ++w)
+    {
+        // Ventanas centradas en tramos iguales del archivo
+        const juce::int64 start = (inLen - fftSize) * (2 * w + 1) / (2 * numWindows);
+
+        if (! reader.read(&block, 0, fftSize, start, true, true))
+            return result;
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            std::copy(block.getReadPointer(ch), block.getReadPointer(ch) + fftSize, fftData.begin());
+            std::fill(fftData.begin() + fftSize, fftData.end(), 0.0f);
+
+            window.multiplyWithWindowingTable(fftData.data(), (size_t) fftSize);
+            fft.performFrequencyOnlyForwardTransform(fftData.data(), true);
+
+            for (size_t b = 0; b < peakHold.size(); ++b)
+                peakHold[b] = juce::jmax(peakHold[b], fftData[b]);
+        }
+    }
+
+    result.windowsScanned = numWindows;
+
+    const auto firstReference = (size_t) std::ceil(minReferenceHz * fftSize / sampleRate);
+    float peak = 0.0f;
+
+    for (size_t b = firstReference; b < peakHold.size(); ++b)
+        peak = juce::jmax(peak, peakHold[b]);
+
+    // Silencio digital: no hay nada que medir
+    if (peak <= 0.0f)
+        return result;
+
+    const auto threshold = (float) (peak * std::pow(10.0, -attenuationDb / 20.0));
+    size_t last = 0;
+
+    for (size_t b = peakHold.size(); b-- > 0;)
+    {
+        if (peakHold[b] > threshold)
+        {
+            last = b;
+            break;
+        }
+    }
+
+    // Margen de medio lobulo principal de la ventana, en bins
+    const double guard = std::ceil(std::sqrt(1.0 + std::pow(beta / juce::MathConstants<double>::pi, 2.0)));
+
+    result.bandwidthHz = juce::jmin(sampleRate * 0.5, ((double) last + guard + 1.0) * sampleRate / fftSize);
+    return result;
+}
+
+double HZContentAnalyzer::estimateOriginRate(double bandwidthHz, double sampleRate)
+{
+    if (bandwidthHz <= 0.0)
+        return 0.0;
+
+    // Desde 88.2k, solo fuentes de hasta la mitad: un 96k real que se
+    // apaga en 40k cabe en 88.2k, pero nadie sube de 88.2k a 96k (la
+    // vecina de la otra familia no es un origen, es el mismo material)
+    const double maxOrigin = sampleRate >= 88200.0 ? sampleRate * 0.5 : sampleRate;
+
+    for (auto rate : originRates)
+        if (rate <= maxOrigin && bandwidthHz <= rate * 0.5 * 1.02)
+            return rate;
+
+    return sampleRate;
+}
+
+juce::Array<HZFileScan> HZContentAnalyzer::scanFiles(const juce::Array<juce::File>& files,
+                                                     double attenuationDb,
+                                                     int numThreads)
+{
+    juce::Array<HZFileScan> scans;
+    scans.resize(files.size());
+
+    if (files.isEmpty())
+        return scans;
+
+    const int threads = juce::jmin(files.size(),
+                                   numThreads > 0 ? numThreads : juce::SystemStats::getNumCpus());
+
+    // Cola compartida: cada hilo toma el siguiente archivo libre
+    std::atomic<int> next { 0 };
+
+    const auto worker = [&]
+    {
+        for (int i = next++; i < files.size(); i = next++)
+            scans.getReference(i) = scanFile(files.getReference(i), attenuationDb);
+    };
+
+    if (threads <= 1)
+    {
+        worker();
+        return scans;
+    }
+
+    juce::ThreadPool pool(threads - 1);
+    std::atomic<int> remaining { threads - 1 };
+    juce::WaitableEvent finished;
+
+    for (int t = 1; t < threads; ++t)
+    {
+        pool.addJob([&worker, &remaining, &finished]
+        {
+            worker();
+
+            if (--remaining == 0)
+                finished.signal();
+        });
+    }
+
+    worker();
+    finished.wait();
+
+    return scans;
+}
+
+bool HZContentAnalyzer::writeManifest(const juce::Array<HZFileScan>& scans, const juce::File& manifest)
+{
+    juce::Array<juce::var> entries;
+
+    for (const auto& scan : scans)
+    {
+        auto* entry = new juce::DynamicObject();
+        entry->setProperty("file", scan.file.getFullPathName());
+        entry->setProperty("sampleRate", scan.sampleRate);
+        entry->setProperty("bandwidthHz", juce::roundToInt(scan.bandwidth.bandwidthHz));
+        entry->setProperty("originRate", scan.originRate);
+        entry->setProperty("upsampled", scan.isUpsampled());
+
+        if (scan.error.isNotEmpty())
+            entry->setProperty("error", scan.error);
+
+        entries.add(juce::var(entry));
+    }
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty("files", entries);
+
+    return manifest.replaceWithText(juce::JSON::toString(juce::var(root)));
+}
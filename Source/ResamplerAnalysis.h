@@ -0,0 +1,74 @@
+#pragma once
+#include "JuceHeader.h"
+
+// ==========================================================
+//  Pre-escaneo del contenido (ancho de banda util)
+//
+//  Unos segundos del archivo, en ventanas de 8192 repartidas
+//  a lo largo de toda la duracion, pasan por juce::dsp::FFT.
+//  El espectro se acumula con retencion de picos por bin
+//  (todas las ventanas y canales): un platillo aislado cuenta
+//  igual que un tono sostenido.
+//
+//  El ancho de banda es el ultimo bin que no queda a mas de
+//  attenuationDb por debajo del pico. La ventana Kaiser tiene
+//  20 dB de margen sobre esa atenuacion para que la fuga de
+//  los graves no tape la banda vacia.
+// ==========================================================
+struct HZBandwidthScan
+{
+    double bandwidthHz = 0.0;   // 0 = sin medida (silencio, archivo corto, error)
+    double sampleRate = 0.0;
+    int windowsScanned = 0;
+
+    bool isValid() const noexcept { return bandwidthHz > 0.0; }
+};
+
+// ==========================================================
+//  Escaneo por lotes (procedencia de archivos de alta frecuencia)
+//
+//  Cada archivo se mide en un hilo del pool con el mismo
+//  pre-escaneo, con menos ventanas (el analisis salta la mayor
+//  parte del archivo: para ubicar el corte alcanza).
+//
+//  La frecuencia de origen es la menor estandar cuyo Nyquist
+//  cubre el ancho de banda medido, con 2% de margen por la
+//  medida: un 96k que corta en 21.5 kHz es un 44.1k subido.
+//  El ancho de banda sirve despues para convertir con kernels
+//  cortos (HZConvertOptions::contentBandwidthHz).
+// ==========================================================
+struct HZFileScan
+{
+    juce::File file;
+    double sampleRate = 0.0;
+    HZBandwidthScan bandwidth;
+    double originRate = 0.0;    // frecuencia real del contenido; 0 = sin medida
+    juce::String error;
+
+    bool isUpsampled() const noexcept { return originRate > 0.0 && originRate < sampleRate; }
+};
+
+class HZContentAnalyzer
+{
+public:
+    /** Lee ~scanSeconds de audio repartidos en el archivo (no mueve
+        nada: el reader se puede usar despues desde el principio). */
+    static HZBandwidthScan measureBandwidth(juce::AudioFormatReader& reader,
+                                            double attenuationDb,
+                                            double scanSeconds = 4.0);
+
+    /** Menor frecuencia estandar que contiene el ancho de banda; 0 si
+        no hay medida. Candidatas: hasta sampleRate, o hasta la mitad
+        desde 88.2k (si no, sampleRate: no hubo upsample). */
+    static double estimateOriginRate(double bandwidthHz, double sampleRate);
+
+    /** Un archivo por trabajo en numThreads hilos (0 = todos los
+        nucleos). El resultado sigue el orden de files. */
+    static juce::Array<HZFileScan> scanFiles(const juce::Array<juce::File>& files,
+                                             double attenuationDb,
+                                             int numThreads = 0);
+
+    /** Manifest JSON del lote: por archivo, frecuencia, ancho de banda,
+        origen estimado y la marca "upsampled". */
+    static bool writeManifest(const juce::Array<HZFileScan>& scans, const juce::File& manifest);
+};
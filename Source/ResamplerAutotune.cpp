@@ -0,0 +1,247 @@
+#include "ResamplerAutotune.h"
+#include <cmath>
+#include <map>
+
+// ==========================================================
+//  Estado del perfil (compartido por todas las conversiones)
+// ==========================================================
+namespace
+{
+    struct ProfileState
+    {
+        juce::CriticalSection lock;
+        std::map<juce::String, HZKernelVariant> entries;
+        bool loaded = false;
+    };
+
+    ProfileState& getState()
+    {
+        static ProfileState state;
+        return state;
+    }
+
+    juce::File getProfileFile()
+    {
+        return juce::File("C:/HZInver/hzautotune.xml");
+    }
+
+    juce::String makeKey(HZEngineKind engine, HZRatio ratio, HZPreset preset)
+    {
+        // Ratio variable: cada deriva medida da otro ratio, asi que la
+        // entrada no puede ser por ratio. El kernel si depende de el: al
+        // bajar tiene baseTaps / escala taps (escala = salida / entrada),
+        // asi que se agrupa por ceil(1 / escala): x1 al subir, x2, x3...
+        if (engine == HZEngineKind::variable)
+        {
+            const double scale = juce::jmin(1.0, ratio.toDouble());
+            const int bucket = (int) std::ceil(1.0 / scale - 1.0e-9);
+
+            return "variable:x" + juce::String(bucket) + ":" + toString(preset);
+        }
+
+        const char* name = engine == HZEngineKind::compact  ? "compact"
+                         : engine == HZEngineKind::halfband ? "halfband"
+                                                            : "rational";
+
+        return juce::String(name) + ":" + ratio.toString() + ":" + toString(preset);
+    }
+
+    void saveProfileLocked(const ProfileState& state)
+    {
+        juce::XmlElement root("HZAUTOTUNE");
+        root.setAttribute("cpu", HZAutotune::getCpuSignature());
+
+        for (const auto& [key, variant] : state.entries)
+        {
+            auto* e = root.createNewChildElement("ENTRY");
+            e->setAttribute("key", key);
+            e->setAttribute("isa", toString(variant.isa));
+            e->setAttribute("layout", toString(variant.layout));
+            e->setAttribute("blockSize", variant.blockSize);
+        }
+
+        auto file = getProfileFile();
+        file.getParentDirectory().createDirectory();
+        root.writeTo(file);
+    }
+
+    // ------------------------------------------------------
+    //  Benchmark de una variante: mismo bucle por bloques
+    //  que la conversion real, sobre ruido estereo.
+    // ------------------------------------------------------
+    template <typename Engine>
+    double measureEngine(Engine& engine, const juce::AudioBuffer<float>& input, HZKernelVariant variant)
+    {
+        juce::AudioBuffer<float> out(input.getNumChannels(), variant.blockSize);
+        const int inBlock = engine.getInputBlockSize();
+        juce::HeapBlock<const float*> ptrs((size_t) input.getNumChannels());
+
+        const auto start = juce::Time::getHighResolutionTicks();
+
+        for (int pos = 0; pos < input.getNumSamples(); pos += inBlock)
+        {
+            const int n = juce::jmin(inBlock, input.getNumSamples() - pos);
+
+            for (int ch = 0; ch < input.getNumChannels(); ++ch)
+                ptrs[ch] = input.getReadPointer(ch, pos);
+
+            engine.pushInput(ptrs.get(), n);
+
+            while (engine.produce(out.getArrayOfWritePointers(), variant.blockSize) > 0)
+            {
+            }
+        }
+
+        return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+    }
+}
+
+// ==========================================================
+//  API
+// ==========================================================
+juce::String HZAutotune::getCpuSignature()
+{
+    using juce::SystemStats;
+
+    juce::String isa;
+    if (SystemStats::hasSSE2())   isa << " sse2";
+    if (SystemStats::hasAVX2())   isa << " avx2";
+    if (SystemStats::hasFMA3())   isa << " fma3";
+    if (SystemStats::hasNeon())   isa << " neon";
+
+    return SystemStats::getCpuVendor() + " | " + SystemStats::getCpuModel()
+         + " | " + juce::String(SystemStats::getNumCpus()) + " cpus |" + isa;
+}
+
+void HZAutotune::loadProfile()
+{
+    auto& state = getState();
+    const juce::ScopedLock sl(state.lock);
+
+    state.entries.clear();
+    state.loaded = true;
+
+    auto xml = juce::XmlDocument::parse(getProfileFile());
+
+    if (xml == nullptr || ! xml->hasTagName("HZAUTOTUNE"))
+        return;
+
+    // Otro CPU (o un perfil antiguo): hay que volver a medir
+    if (xml->getStringAttribute("cpu") != getCpuSignature())
+        return;
+
+    for (auto* e : xml->getChildWithTagNameIterator("ENTRY"))
+    {
+        HZKernelVariant v;
+        v.isa       = isaFromString(e->getStringAttribute("isa"));
+        v.layout    = layoutFromString(e->getStringAttribute("layout"));
+        v.blockSize = juce::jlimit(256, 1 << 20, e->getIntAttribute("blockSize", v.blockSize));
+
+        if (isIsaAvailable(v.isa))
+            state.entries[e->getStringAttribute("key")] = v;
+    }
+}
+
+HZKernelVariant HZAutotune::getVariant(HZEngineKind engine, HZRatio ratio, HZPreset preset)
+{
+    {
+        auto& state = getState();
+        const juce::ScopedLock sl(state.lock);
+
+        if (! state.loaded)
+            loadProfile();   // CriticalSection es reentrante
+
+        auto it = state.entries.find(makeKey(engine, ratio, preset));
+        if (it != state.entries.end())
+            return it->second;
+    }
+
+    return tune(engine, ratio, preset);
+}
+
+HZKernelVariant HZAutotune::tune(HZEngineKind engine, HZRatio ratio, HZPreset preset)
+{
+    static constexpr int blockSizes[] = { 1024, 4096, 16384, 65536 };
+    static constexpr HZKernelIsa isas[] = { HZKernelIsa::scalar, HZKernelIsa::simd128, HZKernelIsa::avx2 };
+    static constexpr HZChannelLayout layouts[] = { HZChannelLayout::planar, HZChannelLayout::frameMajor };
+
+    // El kernel del motor que se mide (una vez para todas las variantes):
+    // tabla exacta, la acotada del compacto o la interpolada del motor
+    // variable (con el ratio redondeado: no arma la tabla de L fases);
+    // las etapas halfband las arma cada motor
+    const bool interpolated = engine == HZEngineKind::compact || engine == HZEngineKind::variable;
+    std::unique_ptr<HZPolyphaseFilter<float>> filter;
+    std::unique_ptr<HZVariablePolyphaseFilter<float>> interpolatedFilter;
+
+    if (interpolated)
+        interpolatedFilter = std::make_unique<HZVariablePolyphaseFilter<float>>(
+            ratio.toDouble(), preset, engine == HZEngineKind::compact ? hzCompactTableBytes : 0);
+    else if (engine != HZEngineKind::halfband)
+        filter = std::make_unique<HZPolyphaseFilter<float>>(ratio, preset);
+
+    const auto measureVariant = [&](const juce::AudioBuffer<float>& input, HZKernelVariant v)
+    {
+        if (engine == HZEngineKind::compact)
+        {
+            HZVariableResamplerEngine<float> e(*interpolatedFilter, input.getNumChannels(), v, ratio);
+            return measureEngine(e, input, v);
+        }
+
+        if (engine == HZEngineKind::variable)
+        {
+            HZVariableResamplerEngine<float> e(*interpolatedFilter, input.getNumChannels(), v, 1.0 / ratio.toDouble());
+            return measureEngine(e, input, v);
+        }
+
+        if (engine == HZEngineKind::halfband)
+        {
+            HZHalfbandResamplerEngine<float> e(ratio, preset, input.getNumChannels(), v);
+            return measureEngine(e, input, v);
+        }
+
+        HZResamplerEngine<float> e(*filter, input.getNumChannels(), v);
+        return measureEngine(e, input, v);
+    };
+
+    // ~1.5 s de ruido estereo a 44.1 kHz
+    juce::AudioBuffer<float> input(2, 65536);
+    juce::Random rng(0x485a);
+
+    for (int ch = 0; ch < input.getNumChannels(); ++ch)
+        for (int i = 0; i < input.getNumSamples(); ++i)
+            input.setSample(ch, i, rng.nextFloat() * 2.0f - 1.0f);
+
+    HZKernelVariant best;
+    double bestTime = std::numeric_limits<double>::max();
+
+    for (auto isa : isas)
+    {
+        if (! isIsaAvailable(isa))
+            continue;
+
+        for (auto layout : layouts)
+        {
+            for (auto blockSize : blockSizes)
+            {
+                const HZKernelVariant v { isa, layout, blockSize };
+
+                // Mejor de dos pasadas (la primera calienta caches)
+                const double t = juce::jmin(measureVariant(input, v), measureVariant(input, v));
+
+                if (t < bestTime)
+                {
+                    bestTime = t;
+                    best = v;
+                }
+            }
+        }
+    }
+
+    auto& state = getState();
+    const juce::ScopedLock sl(state.lock);
+
+    state.entries[makeKey(engine, ratio, preset)] = best;
+    saveProfileLocked(state);
+
+    return best;
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include "JuceHeader.h"
+#include "Resampler.h"
+
+// ==========================================================
+//  Autotune: mide las variantes del kernel en esta maquina
+//  y guarda la mas rapida por (motor, ratio, preset). Se
+//  mide el motor que va a correr (chooseEngine): el compacto
+//  con su tabla acotada, no la exacta de L fases. El motor
+//  variable (deriva) tiene una entrada por preset y por
+//  escala de bajada (el largo del kernel), no por ratio.
+//
+//  Perfil: C:\HZInver\hzautotune.xml. Se descarta si cambia
+//  el modelo de CPU (o sus extensiones de ISA).
+// ==========================================================
+class HZAutotune
+{
+public:
+    /** Carga el perfil guardado. Llamar al iniciar. */
+    static void loadProfile();
+
+    /** Variante ganadora para (motor, ratio, preset). Si no esta en el perfil, la mide y la guarda.
+        engine: el de chooseEngine (draft no usa variantes). */
+    static HZKernelVariant getVariant(HZEngineKind engine, HZRatio ratio, HZPreset preset);
+
+    /** Micro-benchmark de todas las variantes disponibles; guarda el resultado. */
+    static HZKernelVariant tune(HZEngineKind engine, HZRatio ratio, HZPreset preset);
+
+    /** Identifica la CPU: fabricante, modelo, nucleos e ISA. */
+    static juce::String getCpuSignature();
+};
@@ -0,0 +1,205 @@
+#include "ResamplerDither.h"
+#include <cmath>
+
+#if JUCE_USE_SSE_INTRINSICS
+ #include <emmintrin.h>
+#endif
+
+namespace
+{
+    // Noise shaping de 3 taps (Wannamaker, ponderado E):
+    // NTF(z) = 1 - 1.623 z^-1 + 0.982 z^-2 - 0.109 z^-3
+    constexpr double shapingCoeffs[3] = { 1.623, -0.982, 0.109 };
+
+    // Un paso de xorshift32 -> TPDF entero en (-65536, 65536):
+    // diferencia de las dos mitades de 16 bits (dos uniformes).
+    inline int nextTpdf(juce::uint32& x) noexcept
+    {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        return (int) (x >> 16) - (int) (x & 0xffff);
+    }
+
+    juce::uint32 mixSeed(juce::uint32 seed, int channel, int lane) noexcept
+    {
+        juce::uint32 x = seed ^ (0x9e3779b9u * (juce::uint32) (channel * 4 + lane + 1));
+        x ^= x >> 16; x *= 0x85ebca6bu;
+        x ^= x >> 13; x *= 0xc2b2ae35u;
+        x ^= x >> 16;
+        return x != 0 ? x : 0x6d2b79f5u;   // xorshift no admite estado 0
+    }
+
+    inline int toLeftJustified(int q, int shift) noexcept
+    {
+        return (int) ((juce::uint32) q << shift);
+    }
+}
+
+juce::String toString(HZDitherMode mode)
+{
+    switch (mode)
+    {
+        case HZDitherMode::tpdf:   return "tpdf";
+        case HZDitherMode::shaped: return "shaped";
+        case HZDitherMode::none:
+        default:                   return "none";
+    }
+}
+
+juce::String toString(HZSampleFormat format)
+{
+    switch (format)
+    {
+        case HZSampleFormat::int16:   return "16 bits";
+        case HZSampleFormat::int24:   return "24 bits";
+        case HZSampleFormat::int32:   return "32 bits";
+        case HZSampleFormat::float32: return "float 32";
+        case HZSampleFormat::float64: return "float 64";
+        case HZSampleFormat::source:
+        default:                      return "como la entrada";
+    }
+}
+
+int getBitsPerSample(HZSampleFormat format) noexcept
+{
+    switch (format)
+    {
+        case HZSampleFormat::int16:   return 16;
+        case HZSampleFormat::int24:   return 24;
+        case HZSampleFormat::float64: return 64;
+        case HZSampleFormat::int32:
+        case HZSampleFormat::float32: return 32;
+        case HZSampleFormat::source:
+        default:                      return 0;
+    }
+}
+
+bool isFloatFormat(HZSampleFormat format) noexcept
+{
+    return format == HZSampleFormat::float32 || format == HZSampleFormat::float64;
+}
+
+HZQuantizer::HZQuantizer(int numChannels, int b, HZDitherMode m, juce::uint32 seed)
+    : bits(b), mode(m), channels((size_t) numChannels)
+{
+    jassert(bits == 16 || bits == 24 || bits == 32);
+
+    for (size_t ch = 0; ch < channels.size(); ++ch)
+        for (int lane = 0; lane < 4; ++lane)
+            channels[ch].lanes[lane] = mixSeed(seed, (int) ch, lane);
+}
+
+template <typename SampleType>
+void HZQuantizer::process(const SampleType* const* input, int* const* output, int numFrames) noexcept
+{
+    for (size_t ch = 0; ch < channels.size(); ++ch)
+        processChannel(channels[ch], input[ch], output[ch], numFrames);
+
+    framePosition += numFrames;
+}
+
+// ==========================================================
+//  Todo el calculo es en double (a 24 bits un float no tiene
+//  resolucion por debajo del LSB cerca de fondo de escala) y
+//  con redondeo al par mas cercano, igual en SSE2 y escalar.
+// ==========================================================
+template <typename SampleType>
+void HZQuantizer::processChannel(ChannelState& s, const SampleType* in, int* out, int numFrames) const noexcept
+{
+    const double scale     = std::ldexp(1.0, bits - 1);
+    const double lo        = -scale;
+    const double hi        = scale - 1.0;
+    const double tpdfScale = mode == HZDitherMode::none ? 0.0 : 1.0 / 65536.0;
+    const int shift        = 32 - bits;
+
+    const auto quantizeOne = [&](int i) noexcept
+    {
+        const int d = mode == HZDitherMode::none ? 0 : nextTpdf(s.lanes[(framePosition + i) & 3]);
+        const double y = juce::jlimit(lo, hi, (double) in[i] * scale + d * tpdfScale);
+        out[i] = toLeftJustified((int) std::lrint(y), shift);
+    };
+
+    if (mode == HZDitherMode::shaped)
+    {
+        // Realimentacion del error: secuencial por naturaleza
+        auto& e = s.error;
+
+        for (int i = 0; i < numFrames; ++i)
+        {
+            const int d = nextTpdf(s.lanes[(framePosition + i) & 3]);
+            const double v = (double) in[i] * scale
+                               - (shapingCoeffs[0] * e[0] + shapingCoeffs[1] * e[1] + shapingCoeffs[2] * e[2]);
+            const double y = juce::jlimit(lo, hi, v + d * tpdfScale);
+            const int q = (int) std::lrint(y);
+
+            e[2] = e[1];
+            e[1] = e[0];
+            e[0] = juce::jlimit(-4.0, 4.0, q - v);   // acotado: evita inestabilidad al saturar
+            out[i] = toLeftJustified(q, shift);
+        }
+
+        return;
+    }
+
+    int i = 0;
+
+   #if JUCE_USE_SSE_INTRINSICS
+    // Cabeza escalar hasta que el frame absoluto este alineado al lane 0
+    for (; i < numFrames && ((framePosition + i) & 3) != 0; ++i)
+        quantizeOne(i);
+
+    __m128i state = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s.lanes));
+    const __m128i low16   = _mm_set1_epi32(0xffff);
+    const __m128i shiftBy = _mm_cvtsi32_si128(shift);
+    const __m128d vScale  = _mm_set1_pd(scale);
+    const __m128d vTpdf   = _mm_set1_pd(tpdfScale);
+    const __m128d vLo     = _mm_set1_pd(lo);
+    const __m128d vHi     = _mm_set1_pd(hi);
+    const bool dithered   = mode != HZDitherMode::none;
+
+    for (; i + 4 <= numFrames; i += 4)
+    {
+        __m128i d = _mm_setzero_si128();
+
+        if (dithered)
+        {
+            state = _mm_xor_si128(state, _mm_slli_epi32(state, 13));
+            state = _mm_xor_si128(state, _mm_srli_epi32(state, 17));
+            state = _mm_xor_si128(state, _mm_slli_epi32(state, 5));
+            d = _mm_sub_epi32(_mm_srli_epi32(state, 16), _mm_and_si128(state, low16));
+        }
+
+        __m128d x01, x23;
+
+        if constexpr (std::is_same_v<SampleType, float>)
+        {
+            const __m128 x = _mm_loadu_ps(in + i);
+            x01 = _mm_cvtps_pd(x);
+            x23 = _mm_cvtps_pd(_mm_movehl_ps(x, x));
+        }
+        else
+        {
+            x01 = _mm_loadu_pd(in + i);
+            x23 = _mm_loadu_pd(in + i + 2);
+        }
+
+        const __m128d d01 = _mm_cvtepi32_pd(d);
+        const __m128d d23 = _mm_cvtepi32_pd(_mm_shuffle_epi32(d, 0x0e));
+
+        const __m128d y01 = _mm_min_pd(vHi, _mm_max_pd(vLo, _mm_add_pd(_mm_mul_pd(x01, vScale), _mm_mul_pd(d01, vTpdf))));
+        const __m128d y23 = _mm_min_pd(vHi, _mm_max_pd(vLo, _mm_add_pd(_mm_mul_pd(x23, vScale), _mm_mul_pd(d23, vTpdf))));
+
+        const __m128i q = _mm_unpacklo_epi64(_mm_cvtpd_epi32(y01), _mm_cvtpd_epi32(y23));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_sll_epi32(q, shiftBy));
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(s.lanes), state);
+   #endif
+
+    for (; i < numFrames; ++i)
+        quantizeOne(i);
+}
+
+template void HZQuantizer::process<float>(const float* const*, int* const*, int) noexcept;
+template void HZQuantizer::process<double>(const double* const*, int* const*, int) noexcept;
@@ -0,0 +1,64 @@
+#pragma once
+#include "JuceHeader.h"
+
+// ==========================================================
+//  Cuantizacion de salida con dither (float/double -> int)
+//
+//  El dither se suma en el mismo recorrido que convierte a
+//  enteros, justo antes del writer: no hay pasada extra sobre
+//  el buffer.
+// ==========================================================
+enum class HZDitherMode
+{
+    none,       // redondeo simple
+    tpdf,       // TPDF +-1 LSB (ruido blanco)
+    shaped      // TPDF + noise shaping de 3 taps (ruido hacia agudos)
+};
+
+juce::String toString(HZDitherMode mode);
+
+/** Formato de las muestras del WAV de salida. */
+enum class HZSampleFormat
+{
+    source,     // el de la entrada (16 -> 16, float -> float...)
+    int16,
+    int24,
+    int32,
+    float32,    // sin cuantizar ni recortar (conserva el headroom)
+    float64
+};
+
+juce::String toString(HZSampleFormat format);
+
+int getBitsPerSample(HZSampleFormat format) noexcept;
+bool isFloatFormat(HZSampleFormat format) noexcept;
+
+class HZQuantizer
+{
+public:
+    /** bits = 16, 24 o 32. La semilla fija el ruido de cada canal. */
+    HZQuantizer(int numChannels, int bits, HZDitherMode mode, juce::uint32 seed = 0x485a4b56);
+
+    /** Convierte numFrames (planar) al formato de AudioFormatWriter::write:
+        int32 justificado a la izquierda. */
+    template <typename SampleType>
+    void process(const SampleType* const* input, int* const* output, int numFrames) noexcept;
+
+private:
+    // Cuatro generadores xorshift32 por canal: la muestra n usa el
+    // lane n % 4, asi el ruido depende solo del indice de frame y no
+    // de como se parte la salida en bloques.
+    struct ChannelState
+    {
+        juce::uint32 lanes[4];
+        double error[3] {};
+    };
+
+    const int bits;
+    const HZDitherMode mode;
+    std::vector<ChannelState> channels;
+    juce::int64 framePosition = 0;
+
+    template <typename SampleType>
+    void processChannel(ChannelState& state, const SampleType* in, int* out, int numFrames) const noexcept;
+};
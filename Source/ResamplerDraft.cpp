@@ -0,0 +1,828 @@
+#include "ResamplerDraft.h"
+#include <cmath>
+
+namespace
+{
+    // Halfband IIR del preset draft: banda de paso hasta 0.21 de la
+    // frecuencia sobremuestreada (0.42 fs, ~18.5 kHz a 44.1k)
+    constexpr double draftTransitionWidth = 0.08;
+    constexpr double draftStopbandDb      = -70.0;
+
+    // ------------------------------------------------------
+    //  Lanes de las secciones allpass: la rama directa y la
+    //  retardada de cada canal van en lanes vecinos (2c, 2c+1),
+    //  asi una sola pasada vectorial avanza las dos ramas de
+    //  varios canales. Sin SIMD: un canal, dos lanes escalares.
+    // ------------------------------------------------------
+   #if JUCE_USE_SIMD
+    template <typename SampleType>
+    using LaneVector = juce::dsp::SIMDRegister<SampleType>;
+   #else
+    template <typename SampleType>
+    struct LaneVector
+    {
+        SampleType v[2];
+
+        static constexpr size_t size() noexcept { return 2; }
+        static LaneVector expand(SampleType s) noexcept                { return { { s, s } }; }
+        static LaneVector fromRawArray(const SampleType* a) noexcept   { return { { a[0], a[1] } }; }
+        void copyToRawArray(SampleType* a) const noexcept              { a[0] = v[0]; a[1] = v[1]; }
+
+        LaneVector operator+(LaneVector o) const noexcept { return { { v[0] + o.v[0], v[1] + o.v[1] } }; }
+        LaneVector operator-(LaneVector o) const noexcept { return { { v[0] - o.v[0], v[1] - o.v[1] } }; }
+        LaneVector operator*(LaneVector o) const noexcept { return { { v[0] * o.v[0], v[1] * o.v[1] } }; }
+    };
+   #endif
+
+    template <typename SampleType>
+    constexpr int getChannelsPerGroup() noexcept
+    {
+        return juce::jmax(1, (int) LaneVector<SampleType>::size() / 2);
+    }
+
+    // Secciones de primer orden a la frecuencia baja (A(z^2) a la
+    // alta), igual que juce::dsp::Oversampling:
+    //   y = a * x + s;  s = x - a * y
+    // Una rama mas corta se completa con a = 1, que con s = 0 deja
+    // pasar la señal sin cambios.
+    template <typename SampleType>
+    struct AllpassLanes
+    {
+        using Vec = LaneVector<SampleType>;
+
+        AllpassLanes(const std::vector<double>& direct, const std::vector<double>& delayed)
+        {
+            const size_t numSections = juce::jmax(direct.size(), delayed.size());
+            alignas(sizeof(Vec)) SampleType lanes[Vec::size()];
+
+            for (size_t k = 0; k < numSections; ++k)
+            {
+                for (size_t lane = 0; lane < Vec::size(); ++lane)
+                {
+                    const auto& branch = (lane & 1) == 0 ? direct : delayed;
+                    lanes[lane] = (SampleType) (k < branch.size() ? branch[k] : 1.0);
+                }
+
+                alphas.push_back(Vec::fromRawArray(lanes));
+            }
+        }
+
+        inline Vec process(Vec x, Vec* state) const noexcept
+        {
+            for (size_t k = 0; k < alphas.size(); ++k)
+            {
+                const Vec y = alphas[k] * x + state[k];
+                state[k] = x - alphas[k] * y;
+                x = y;
+            }
+
+            return x;
+        }
+
+        int getNumSections() const noexcept { return (int) alphas.size(); }
+
+        std::vector<Vec> alphas;
+    };
+
+    // Copia local del estado durante un bloque: asi el compilador no
+    // lo relee de memoria tras cada escritura de la salida
+    template <typename SampleType>
+    struct LocalState
+    {
+        static constexpr int maxSections = 8;
+
+        explicit LocalState(std::vector<LaneVector<SampleType>>& s) noexcept
+            : source(s)
+        {
+            jassert(s.size() <= (size_t) maxSections);
+            std::copy(s.begin(), s.end(), data);
+        }
+
+        ~LocalState() { std::copy_n(data, source.size(), source.begin()); }
+
+        std::vector<LaneVector<SampleType>>& source;
+        LaneVector<SampleType> data[maxSections];
+    };
+
+    // fn(std::integral_constant<int, N>) con N = canales del grupo: con
+    // N constante el armado de los lanes queda en registros
+    template <typename Function>
+    void withChannelCount(int numGroupChannels, Function&& fn)
+    {
+        switch (numGroupChannels)
+        {
+            case 1:  fn(std::integral_constant<int, 1>()); break;
+            case 2:  fn(std::integral_constant<int, 2>()); break;
+            case 3:  fn(std::integral_constant<int, 3>()); break;
+            default: fn(std::integral_constant<int, 4>()); break;
+        }
+    }
+
+    double besselI0(double x)
+    {
+        double sum = 1.0, term = 1.0;
+
+        for (int k = 1; k < 50; ++k)
+        {
+            term *= (x / (2.0 * k)) * (x / (2.0 * k));
+            sum += term;
+
+            if (term < sum * 1.0e-12)
+                break;
+        }
+
+        return sum;
+    }
+
+    // Retardo de grupo en DC de una rama, en muestras de la frecuencia
+    // alta: cada (a + z^-2) / (1 + a z^-2) aporta 2 (1 - a) / (1 + a)
+    double getBranchDelay(const std::vector<double>& alphas)
+    {
+        double delay = 0.0;
+
+        for (auto a : alphas)
+            delay += 2.0 * (1.0 - a) / (1.0 + a);
+
+        return delay;
+    }
+}
+
+// ==========================================================
+//  Etapas. Procesan un grupo de canales (los que caben en
+//  un vector de lanes) y guardan su estado por grupo.
+// ==========================================================
+template <typename SampleType>
+struct HZDraftResamplerEngine<SampleType>::Stage
+{
+    virtual ~Stage() = default;
+    virtual void reset() = 0;
+    virtual const char* getName() const noexcept = 0;
+
+    /** Procesa numIn muestras de los canales del grupo (in[c], c < numGroupChannels)
+        y agrega la salida de cada uno a *out[c]. */
+    virtual void process(int group, const SampleType* const* in, int numGroupChannels, int numIn,
+                         std::vector<SampleType>* const* out) = 0;
+};
+
+// x2: la salida par sale de la rama directa y la impar de la
+// rama con retardo, las dos sobre la misma muestra de entrada
+template <typename SampleType>
+struct HZDraftResamplerEngine<SampleType>::UpStage final : Stage
+{
+    using Vec = LaneVector<SampleType>;
+    static constexpr int maxChannels = getChannelsPerGroup<SampleType>();
+
+    UpStage(const std::vector<double>& direct, const std::vector<double>& delayed, int numGroups)
+        : allpass(direct, delayed),
+          state((size_t) numGroups, std::vector<Vec>((size_t) allpass.getNumSections(), Vec::expand(0)))
+    {
+    }
+
+    void reset() override
+    {
+        for (auto& s : state)
+            std::fill(s.begin(), s.end(), Vec::expand(0));
+    }
+
+    const char* getName() const noexcept override { return "x2"; }
+
+    void process(int group, const SampleType* const* in, int numGroupChannels, int numIn,
+                 std::vector<SampleType>* const* out) override
+    {
+        SampleType* dest[maxChannels] {};
+
+        for (int c = 0; c < numGroupChannels; ++c)
+        {
+            const size_t first = out[c]->size();
+            out[c]->resize(first + 2 * (size_t) numIn);
+            dest[c] = out[c]->data() + first;
+        }
+
+        withChannelCount(numGroupChannels, [&](auto n)
+        {
+            run<decltype(n)::value>(state[(size_t) group], in, numIn, dest);
+        });
+    }
+
+    template <int N>
+    void run(std::vector<Vec>& groupState, const SampleType* const* in, int numIn, SampleType* const* dest) const noexcept
+    {
+        if constexpr (N <= maxChannels)
+        {
+            LocalState<SampleType> s(groupState);
+            alignas(sizeof(Vec)) SampleType lanes[Vec::size()] {};
+
+            for (int i = 0; i < numIn; ++i)
+            {
+                for (int c = 0; c < N; ++c)
+                    lanes[2 * c] = lanes[2 * c + 1] = in[c][i];
+
+                allpass.process(Vec::fromRawArray(lanes), s.data).copyToRawArray(lanes);
+
+                for (int c = 0; c < N; ++c)
+                {
+                    dest[c][2 * i]     = lanes[2 * c];
+                    dest[c][2 * i + 1] = lanes[2 * c + 1];
+                }
+            }
+        }
+    }
+
+    const AllpassLanes<SampleType> allpass;
+    std::vector<std::vector<Vec>> state;
+};
+
+// /2: y = 0.5 * (directa(par) + retardada(impar anterior)). Si un
+// bloque trae un numero impar de muestras, la ultima queda retenida.
+template <typename SampleType>
+struct HZDraftResamplerEngine<SampleType>::DownStage final : Stage
+{
+    using Vec = LaneVector<SampleType>;
+    static constexpr int maxChannels = getChannelsPerGroup<SampleType>();
+
+    struct GroupState
+    {
+        std::vector<Vec> allpass;
+        SampleType delay[maxChannels] {}, held[maxChannels] {};
+        bool hasHeld = false;
+    };
+
+    DownStage(const std::vector<double>& direct, const std::vector<double>& delayed, int numGroups)
+        : allpass(direct, delayed),
+          groups((size_t) numGroups)
+    {
+        reset();
+    }
+
+    void reset() override
+    {
+        for (auto& g : groups)
+        {
+            g.allpass.assign((size_t) allpass.getNumSections(), Vec::expand(0));
+            std::fill(std::begin(g.delay), std::end(g.delay), SampleType());
+            std::fill(std::begin(g.held), std::end(g.held), SampleType());
+            g.hasHeld = false;
+        }
+    }
+
+    const char* getName() const noexcept override { return "/2"; }
+
+    void process(int group, const SampleType* const* in, int numGroupChannels, int numIn,
+                 std::vector<SampleType>* const* out) override
+    {
+        auto& g = groups[(size_t) group];
+        const int numOut = (numIn + (g.hasHeld ? 1 : 0)) / 2;
+
+        SampleType* dest[maxChannels] {};
+
+        for (int c = 0; c < numGroupChannels; ++c)
+        {
+            const size_t first = out[c]->size();
+            out[c]->resize(first + (size_t) numOut);
+            dest[c] = out[c]->data() + first;
+        }
+
+        withChannelCount(numGroupChannels, [&](auto n)
+        {
+            run<decltype(n)::value>(g, in, numIn, dest);
+        });
+    }
+
+    template <int N>
+    void run(GroupState& g, const SampleType* const* in, int numIn, SampleType* const* dest) const noexcept
+    {
+        if constexpr (N <= maxChannels)
+        {
+            LocalState<SampleType> s(g.allpass);
+            alignas(sizeof(Vec)) SampleType lanes[Vec::size()] {};
+            SampleType delay[N];
+            std::copy_n(g.delay, N, delay);
+
+            // lanes = (par, impar) de cada canal -> salida n
+            const auto step = [&](int n) noexcept
+            {
+                allpass.process(Vec::fromRawArray(lanes), s.data).copyToRawArray(lanes);
+
+                for (int c = 0; c < N; ++c)
+                {
+                    dest[c][n] = (SampleType) 0.5 * (delay[c] + lanes[2 * c]);
+                    delay[c] = lanes[2 * c + 1];
+                }
+            };
+
+            int i = 0, n = 0;
+
+            if (g.hasHeld && numIn > 0)
+            {
+                for (int c = 0; c < N; ++c)
+                {
+                    lanes[2 * c]     = g.held[c];
+                    lanes[2 * c + 1] = in[c][0];
+                }
+
+                step(n++);
+                g.hasHeld = false;
+                i = 1;
+            }
+
+            for (; i + 1 < numIn; i += 2)
+            {
+                for (int c = 0; c < N; ++c)
+                {
+                    lanes[2 * c]     = in[c][i];
+                    lanes[2 * c + 1] = in[c][i + 1];
+                }
+
+                step(n++);
+            }
+
+            if (i < numIn)
+            {
+                for (int c = 0; c < N; ++c)
+                    g.held[c] = in[c][i];
+
+                g.hasHeld = true;
+            }
+
+            std::copy_n(delay, N, g.delay);
+        }
+    }
+
+    const AllpassLanes<SampleType> allpass;
+    std::vector<GroupState> groups;
+};
+
+// Paso fraccionario L/M con un sinc de 8 puntos (x[b-3] .. x[b+4])
+// y ventana Kaiser. La salida n lee la posicion n * M / L + offset:
+// offset absorbe el retardo de las etapas IIR de antes y despues.
+// Solo hay L fracciones distintas, asi que los pesos se tabulan por
+// fase. Trabaja sobre la señal sobremuestreada x2, donde la banda
+// util llega a 0.21 y la primera imagen empieza en 0.79: con 8
+// puntos la transicion (~0.54) deja ~70 dB, a la par de los IIR.
+template <typename SampleType>
+struct HZDraftResamplerEngine<SampleType>::SincStage final : Stage
+{
+    static constexpr int maxChannels = getChannelsPerGroup<SampleType>();
+    static constexpr int numTaps = 8;
+    static constexpr int tapsBefore = numTaps / 2 - 1;
+
+    struct GroupState
+    {
+        std::vector<std::vector<SampleType>> history;
+        juce::int64 historyStart = 0;   // indice absoluto de history[c][0]
+        juce::int64 base = 0;           // posicion exacta = base + phase / L
+        int phase = 0;
+    };
+
+    SincStage(HZRatio r, double offset, int numGroups)
+        : up(r.up),
+          stepWhole(r.down / r.up),
+          stepFrac(r.down % r.up),
+          offsetWhole((juce::int64) std::floor(offset)),
+          weights((size_t) r.up * numTaps),
+          carry((size_t) r.up),
+          groups((size_t) numGroups)
+    {
+        const double offsetFrac = offset - std::floor(offset);
+        const double beta = 0.1102 * (-draftStopbandDb - 8.7);
+        const double radius = numTaps / 2;
+
+        for (int p = 0; p < up; ++p)
+        {
+            double t = (double) p / (double) up + offsetFrac;
+            carry[(size_t) p] = t >= 1.0 ? 1 : 0;
+            t -= carry[(size_t) p];
+
+            auto* w = weights.data() + (size_t) p * numTaps;
+            double sum = 0.0;
+            double taps[numTaps];
+
+            for (int k = 0; k < numTaps; ++k)
+            {
+                const double d = (double) (k - tapsBefore) - t;
+                const double x = d / radius;
+                const double window = std::abs(x) < 1.0 ? besselI0(beta * std::sqrt(1.0 - x * x)) / besselI0(beta) : 0.0;
+                const double sinc = std::abs(d) < 1.0e-9 ? 1.0 : std::sin(juce::MathConstants<double>::pi * d) / (juce::MathConstants<double>::pi * d);
+
+                taps[k] = sinc * window;
+                sum += taps[k];
+            }
+
+            // Ganancia unitaria en DC en cada fase
+            for (int k = 0; k < numTaps; ++k)
+                w[k] = (SampleType) (taps[k] / sum);
+        }
+
+        reset();
+    }
+
+    void reset() override
+    {
+        for (auto& g : groups)
+        {
+            // x[-3] .. x[-1] en cero
+            g.history.assign((size_t) maxChannels, std::vector<SampleType>((size_t) tapsBefore));
+            g.historyStart = -tapsBefore;
+            g.base = 0;
+            g.phase = 0;
+        }
+    }
+
+    const char* getName() const noexcept override { return "sinc"; }
+
+    void process(int group, const SampleType* const* in, int numGroupChannels, int numIn,
+                 std::vector<SampleType>* const* out) override
+    {
+        auto& g = groups[(size_t) group];
+
+        for (int c = 0; c < numGroupChannels; ++c)
+            g.history[(size_t) c].insert(g.history[(size_t) c].end(), in[c], in[c] + numIn);
+
+        const juce::int64 end = g.historyStart + (juce::int64) g.history.front().size();
+
+        // Salidas que caben en la entrada disponible
+        juce::int64 base = g.base;
+        int phase = g.phase, numOut = 0;
+
+        const auto advance = [this](juce::int64& b, int& p) noexcept
+        {
+            b += stepWhole;
+            p += stepFrac;
+
+            if (p >= up)
+            {
+                p -= up;
+                ++b;
+            }
+        };
+
+        for (; base + offsetWhole + carry[(size_t) phase] + (numTaps - tapsBefore - 1) < end; ++numOut)
+            advance(base, phase);
+
+        SampleType* dest[maxChannels] {};
+
+        for (int c = 0; c < numGroupChannels; ++c)
+        {
+            const size_t first = out[c]->size();
+            out[c]->resize(first + (size_t) numOut);
+            dest[c] = out[c]->data() + first;
+        }
+
+        // Todos los canales del grupo en la misma pasada: la posicion
+        // y los pesos se leen una vez por salida
+        withChannelCount(numGroupChannels, [&](auto count)
+        {
+            constexpr int N = decltype(count)::value;
+
+            if constexpr (N <= maxChannels)
+            {
+                const SampleType* h[N];
+
+                for (int c = 0; c < N; ++c)
+                    h[c] = g.history[(size_t) c].data();
+
+                const juce::int64 shift = offsetWhole - tapsBefore - g.historyStart;
+                juce::int64 b = g.base;
+                int p = g.phase;
+
+                for (int n = 0; n < numOut; ++n)
+                {
+                    const juce::int64 index = b + shift + carry[(size_t) p];
+                    const SampleType* w = weights.data() + (size_t) p * numTaps;
+
+                    for (int c = 0; c < N; ++c)
+                    {
+                        const SampleType* x = h[c] + index;
+                        dest[c][n] = w[0] * x[0] + w[1] * x[1] + w[2] * x[2] + w[3] * x[3]
+                                   + w[4] * x[4] + w[5] * x[5] + w[6] * x[6] + w[7] * x[7];
+                    }
+
+                    advance(b, p);
+                }
+            }
+        });
+
+        g.base = base;
+        g.phase = phase;
+
+        // Conservar desde x[b-3] de la proxima salida. Solo los canales
+        // del grupo: en el ultimo grupo pueden sobrar lanes sin usar
+        const juce::int64 keepFrom = juce::jlimit(g.historyStart, end, g.base + offsetWhole - tapsBefore);
+
+        for (int c = 0; c < numGroupChannels; ++c)
+        {
+            auto& h = g.history[(size_t) c];
+            h.erase(h.begin(), h.begin() + (std::ptrdiff_t) (keepFrom - g.historyStart));
+        }
+
+        g.historyStart = keepFrom;
+    }
+
+    const int up, stepWhole, stepFrac;
+    const juce::int64 offsetWhole;
+    std::vector<SampleType> weights;    // L x numTaps
+    std::vector<int> carry;             // 1 si offset + p / L pasa a la muestra siguiente
+    std::vector<GroupState> groups;
+};
+
+// ==========================================================
+//  Motor
+// ==========================================================
+template <typename SampleType>
+HZDraftResamplerEngine<SampleType>::HZDraftResamplerEngine(double inRate, double outRate, int channels, HZKernelVariant v)
+    : ratio(HZRatio::fromRates(inRate, outRate)),
+      numChannels(channels),
+      numGroups((channels + getChannelsPerGroup<SampleType>() - 1) / getChannelsPerGroup<SampleType>()),
+      variant(v),
+      pending((size_t) channels),
+      scratch((size_t) channels * 2)
+{
+    jassert(supportsRates(inRate, outRate));
+
+    const auto design = juce::dsp::FilterDesign<double>::designIIRLowpassHalfBandPolyphaseAllpassMethod(
+        draftTransitionWidth, draftStopbandDb);
+
+    for (int i = 0; i < design.directPath.size(); ++i)
+        directAlphas.push_back(design.directPath.getObjectPointer(i)->coefficients[0]);
+
+    // El primer elemento de la rama retardada es el retardo puro
+    for (int i = 1; i < design.delayedPath.size(); ++i)
+        delayedAlphas.push_back(design.delayedPath.getObjectPointer(i)->coefficients[0]);
+
+    // Retardo en DC de una etapa x2 o /2, en muestras de la frecuencia alta
+    const double stageDelay = 0.5 * (getBranchDelay(directAlphas) + 1.0 + getBranchDelay(delayedAlphas));
+
+    // Etapas /2 antes y x2 despues del nucleo
+    double rate = inRate;
+    int preDowns = 0, postUps = 0;
+
+    while (rate * 0.5 >= outRate)
+    {
+        rate *= 0.5;
+        ++preDowns;
+    }
+
+    while (outRate / (double) (1 << (postUps + 1)) >= rate)
+        ++postUps;
+
+    const double coreIn  = rate;
+    const double coreOut = outRate / (double) (1 << postUps);
+    const auto coreRatio = HZRatio::fromRates(inRate * (double) (1 << postUps), outRate * (double) (1 << preDowns));
+    const bool hasCore   = coreRatio.up != coreRatio.down;
+
+    // Retardo acumulado (segundos) antes y despues del sinc
+    double delayBefore = 0.0, delayAfter = 0.0;
+
+    for (int s = 0; s < preDowns; ++s)
+    {
+        stages.push_back(std::make_unique<DownStage>(directAlphas, delayedAlphas, numGroups));
+        delayBefore += stageDelay / (inRate / (double) (1 << s));
+    }
+
+    if (hasCore)
+    {
+        // Subiendo, el x2 ya quita las imagenes y el sinc va directo
+        // de 2 * coreIn a coreOut; bajando hace falta el /2 final como
+        // antialias, asi que el sinc trabaja de 2 * coreIn a 2 * coreOut
+        const bool coreUp = coreOut > coreIn;
+        const auto sincRatio = coreUp ? HZRatio::fromRates(2.0 * coreRatio.down, (double) coreRatio.up) : coreRatio;
+
+        delayBefore += stageDelay / (2.0 * coreIn);
+
+        if (! coreUp)
+            delayAfter += stageDelay / (2.0 * coreOut);
+
+        for (int s = 0; s < postUps; ++s)
+            delayAfter += stageDelay / (coreOut * (double) (2 << s));
+
+        const double offset = (delayBefore + delayAfter) * 2.0 * coreIn;
+
+        stages.push_back(std::make_unique<UpStage>(directAlphas, delayedAlphas, numGroups));
+        stages.push_back(std::make_unique<SincStage>(sincRatio, offset, numGroups));
+
+        if (! coreUp)
+            stages.push_back(std::make_unique<DownStage>(directAlphas, delayedAlphas, numGroups));
+    }
+    else
+    {
+        for (int s = 0; s < postUps; ++s)
+            delayBefore += stageDelay / (coreOut * (double) (2 << s));
+    }
+
+    for (int s = 0; s < postUps; ++s)
+        stages.push_back(std::make_unique<UpStage>(directAlphas, delayedAlphas, numGroups));
+
+    // Sin nucleo (2^k) el retardo solo se compensa en frames enteros
+    const double totalDelay = delayBefore + delayAfter;
+    skipFrames = hasCore ? 0 : (juce::int64) std::llround(totalDelay * outRate);
+
+    const double minRate = juce::jmin(inRate, outRate, coreIn);
+    flushLength = (int) std::ceil((totalDelay + 16.0 / minRate) * inRate) + 16;
+
+    reset();
+}
+
+template <typename SampleType>
+HZDraftResamplerEngine<SampleType>::~HZDraftResamplerEngine() = default;
+
+template <typename SampleType>
+bool HZDraftResamplerEngine<SampleType>::supportsRates(double inRate, double outRate) noexcept
+{
+    return inRate >= 1.0 && outRate >= 1.0 && inRate != outRate
+             && inRate == std::floor(inRate) && outRate == std::floor(outRate);
+}
+
+template <typename SampleType>
+void HZDraftResamplerEngine<SampleType>::reset()
+{
+    for (auto& stage : stages)
+        stage->reset();
+
+    for (auto& p : pending)
+        p.clear();
+
+    pendingRead = 0;
+    skipRemaining = skipFrames;
+    inputFrames = 0;
+    outputFrames = 0;
+    flushed = false;
+}
+
+template <typename SampleType>
+int HZDraftResamplerEngine<SampleType>::getInputBlockSize() const noexcept
+{
+    return (int) ((juce::int64) variant.blockSize * ratio.down / ratio.up) + 1;
+}
+
+template <typename SampleType>
+juce::String HZDraftResamplerEngine<SampleType>::getDescription() const
+{
+    juce::StringArray names;
+
+    for (auto& stage : stages)
+        names.add(stage->getName());
+
+    return names.joinIntoString(" ");
+}
+
+template <typename SampleType>
+void HZDraftResamplerEngine<SampleType>::pushInput(const SampleType* const* input, int numFrames)
+{
+    if (numFrames <= 0)
+        return;
+
+    process(input, numFrames);
+    inputFrames += numFrames;
+}
+
+template <typename SampleType>
+void HZDraftResamplerEngine<SampleType>::pushSilence(int numFrames)
+{
+    if (numFrames > 0)
+        process(nullptr, numFrames);
+
+    flushed = true;
+}
+
+template <typename SampleType>
+void HZDraftResamplerEngine<SampleType>::process(const SampleType* const* input, int numFrames)
+{
+    // Los grupos de canales no comparten estado: uno por hilo
+    const int numJobs = threadPool != nullptr && numFrames >= 512
+                          ? juce::jmin(numGroups, threadPool->getNumThreads() + 1)
+                          : 1;
+
+    const auto runGroups = [this, input, numFrames, numJobs](int job)
+    {
+        for (int g = job; g < numGroups; g += numJobs)
+            processGroup(g, input, numFrames);
+    };
+
+    if (numJobs <= 1)
+    {
+        runGroups(0);
+        return;
+    }
+
+    std::atomic<int> remaining { numJobs - 1 };
+    juce::WaitableEvent finished;
+
+    for (int job = 1; job < numJobs; ++job)
+    {
+        threadPool->addJob([&runGroups, &remaining, &finished, job]
+        {
+            runGroups(job);
+
+            if (--remaining == 0)
+                finished.signal();
+        });
+    }
+
+    runGroups(0);
+    finished.wait();
+}
+
+template <typename SampleType>
+void HZDraftResamplerEngine<SampleType>::processGroup(int group, const SampleType* const* input, int numFrames)
+{
+    // La cola de los IIR decae hacia denormales
+    const juce::ScopedNoDenormals noDenormals;
+
+    constexpr int channelsPerGroup = getChannelsPerGroup<SampleType>();
+    const int firstChannel = group * channelsPerGroup;
+    const int numGroupChannels = juce::jmin(channelsPerGroup, numChannels - firstChannel);
+
+    // Dos buffers por canal: la salida de una etapa es la entrada de la siguiente
+    std::vector<SampleType>* a[channelsPerGroup] {};
+    std::vector<SampleType>* b[channelsPerGroup] {};
+    std::vector<SampleType>* last[channelsPerGroup] {};
+    const SampleType* in[channelsPerGroup] {};
+
+    for (int c = 0; c < numGroupChannels; ++c)
+    {
+        const int ch = firstChannel + c;
+        a[c] = &scratch[(size_t) ch * 2];
+        b[c] = &scratch[(size_t) ch * 2 + 1];
+        last[c] = &pending[(size_t) ch];
+
+        if (input != nullptr)
+        {
+            in[c] = input[ch];
+        }
+        else
+        {
+            a[c]->assign((size_t) numFrames, SampleType());
+            in[c] = a[c]->data();
+        }
+    }
+
+    int numIn = numFrames;
+
+    for (size_t s = 0; s < stages.size(); ++s)
+    {
+        const bool isLast = s + 1 == stages.size();
+
+        if (isLast)
+        {
+            stages[s]->process(group, in, numGroupChannels, numIn, last);
+            break;
+        }
+
+        for (int c = 0; c < numGroupChannels; ++c)
+            b[c]->clear();
+
+        stages[s]->process(group, in, numGroupChannels, numIn, b);
+
+        for (int c = 0; c < numGroupChannels; ++c)
+        {
+            in[c] = b[c]->data();
+            std::swap(a[c], b[c]);
+        }
+
+        numIn = (int) a[0]->size();
+    }
+}
+
+template <typename SampleType>
+int HZDraftResamplerEngine<SampleType>::produce(SampleType* const* output, int maxFrames)
+{
+    auto available = (juce::int64) pending.front().size() - (juce::int64) pendingRead;
+
+    // Compensacion del retardo en 2^k: las primeras salidas se descartan
+    const auto skipped = juce::jmin(skipRemaining, available);
+    pendingRead += (size_t) skipped;
+    skipRemaining -= skipped;
+    available -= skipped;
+
+    int count = (int) juce::jmin((juce::int64) maxFrames, available);
+
+    // Tras la cola, el largo exacto del motor general: ceil(N_in * L / M)
+    if (flushed)
+    {
+        const juce::int64 total = (inputFrames * ratio.up + ratio.down - 1) / ratio.down;
+        count = (int) juce::jmin((juce::int64) count, total - outputFrames);
+    }
+
+    if (count <= 0)
+        return 0;
+
+    for (int ch = 0; ch < numChannels; ++ch)
+        std::copy_n(pending[(size_t) ch].data() + pendingRead, (size_t) count, output[ch]);
+
+    pendingRead += (size_t) count;
+    outputFrames += count;
+
+    // Compactar lo ya entregado
+    if (pendingRead == pending.front().size() || pendingRead >= (size_t) variant.blockSize * 4)
+    {
+        for (auto& p : pending)
+            p.erase(p.begin(), p.begin() + (std::ptrdiff_t) pendingRead);
+
+        pendingRead = 0;
+    }
+
+    return count;
+}
+
+template class HZDraftResamplerEngine<float>;
+template class HZDraftResamplerEngine<double>;
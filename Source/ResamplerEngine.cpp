@@ -0,0 +1,1390 @@
+#include "ResamplerEngine.h"
+#include "ResamplerMinPhase.h"
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+#if JUCE_USE_SSE_INTRINSICS
+ #include <immintrin.h>
+#elif JUCE_USE_ARM_NEON
+ #include <arm_neon.h>
+#endif
+
+#if JUCE_USE_SSE_INTRINSICS && (JUCE_GCC || JUCE_CLANG)
+ #define HZ_AVX2_TARGET __attribute__((target("avx2,fma")))
+#else
+ #define HZ_AVX2_TARGET
+#endif
+
+// ==========================================================
+//  Productos escalares
+//
+//  scalar y simd128 usan el mismo orden de acumulacion
+//  (8 sumas parciales, reduccion fija), asi que dan el mismo
+//  resultado bit a bit. avx2 usa FMA y su propio orden.
+// ==========================================================
+namespace
+{
+    template <typename SampleType>
+    SampleType dotScalar(const SampleType* x, const SampleType* h, int numTaps) noexcept
+    {
+        SampleType s[8] = {};
+
+        for (int i = 0; i < numTaps; i += 8)
+            for (int k = 0; k < 8; ++k)
+                s[k] += x[i + k] * h[i + k];
+
+        return ((s[0] + s[4]) + (s[2] + s[6])) + ((s[1] + s[5]) + (s[3] + s[7]));
+    }
+
+   #if JUCE_USE_SSE_INTRINSICS
+    float dotSimd128(const float* x, const float* h, int numTaps) noexcept
+    {
+        __m128 acc0 = _mm_setzero_ps();
+        __m128 acc1 = _mm_setzero_ps();
+
+        for (int i = 0; i < numTaps; i += 8)
+        {
+            acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(x + i),     _mm_loadu_ps(h + i)));
+            acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(x + i + 4), _mm_loadu_ps(h + i + 4)));
+        }
+
+        const __m128 acc = _mm_add_ps(acc0, acc1);
+        const __m128 pairs = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+        return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+    }
+
+    HZ_AVX2_TARGET float dotAvx2(const float* x, const float* h, int numTaps) noexcept
+    {
+        __m256 acc0 = _mm256_setzero_ps();
+        __m256 acc1 = _mm256_setzero_ps();
+        int i = 0;
+
+        for (; i + 16 <= numTaps; i += 16)
+        {
+            acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i),     _mm256_loadu_ps(h + i),     acc0);
+            acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i + 8), _mm256_loadu_ps(h + i + 8), acc1);
+        }
+
+        if (i < numTaps)
+            acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(h + i), acc0);
+
+        const __m256 acc = _mm256_add_ps(acc0, acc1);
+        const __m128 quad = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+        const __m128 pairs = _mm_add_ps(quad, _mm_movehl_ps(quad, quad));
+        return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+    }
+
+    // Doble: 4 acumuladores de 2 lanes = las mismas 8 sumas parciales
+    double dotSimd128(const double* x, const double* h, int numTaps) noexcept
+    {
+        __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+        __m128d acc2 = _mm_setzero_pd(), acc3 = _mm_setzero_pd();
+
+        for (int i = 0; i < numTaps; i += 8)
+        {
+            acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(x + i),     _mm_loadu_pd(h + i)));
+            acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(x + i + 2), _mm_loadu_pd(h + i + 2)));
+            acc2 = _mm_add_pd(acc2, _mm_mul_pd(_mm_loadu_pd(x + i + 4), _mm_loadu_pd(h + i + 4)));
+            acc3 = _mm_add_pd(acc3, _mm_mul_pd(_mm_loadu_pd(x + i + 6), _mm_loadu_pd(h + i + 6)));
+        }
+
+        const __m128d acc = _mm_add_pd(_mm_add_pd(acc0, acc2), _mm_add_pd(acc1, acc3));
+        return _mm_cvtsd_f64(_mm_add_sd(acc, _mm_unpackhi_pd(acc, acc)));
+    }
+
+    HZ_AVX2_TARGET double dotAvx2(const double* x, const double* h, int numTaps) noexcept
+    {
+        __m256d acc0 = _mm256_setzero_pd();
+        __m256d acc1 = _mm256_setzero_pd();
+
+        for (int i = 0; i < numTaps; i += 8)
+        {
+            acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i),     _mm256_loadu_pd(h + i),     acc0);
+            acc1 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 4), _mm256_loadu_pd(h + i + 4), acc1);
+        }
+
+        const __m256d acc = _mm256_add_pd(acc0, acc1);
+        const __m128d pair = _mm_add_pd(_mm256_castpd256_pd128(acc), _mm256_extractf128_pd(acc, 1));
+        return _mm_cvtsd_f64(_mm_add_sd(pair, _mm_unpackhi_pd(pair, pair)));
+    }
+   #elif JUCE_USE_ARM_NEON
+    float dotSimd128(const float* x, const float* h, int numTaps) noexcept
+    {
+        float32x4_t acc0 = vdupq_n_f32(0.0f);
+        float32x4_t acc1 = vdupq_n_f32(0.0f);
+
+        for (int i = 0; i < numTaps; i += 8)
+        {
+            acc0 = vaddq_f32(acc0, vmulq_f32(vld1q_f32(x + i),     vld1q_f32(h + i)));
+            acc1 = vaddq_f32(acc1, vmulq_f32(vld1q_f32(x + i + 4), vld1q_f32(h + i + 4)));
+        }
+
+        const float32x4_t acc = vaddq_f32(acc0, acc1);
+        const float32x2_t pairs = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+        return vget_lane_f32(vpadd_f32(pairs, pairs), 0);
+    }
+
+    double dotSimd128(const double* x, const double* h, int numTaps) noexcept
+    {
+       #if defined (__aarch64__)
+        float64x2_t acc0 = vdupq_n_f64(0.0), acc1 = vdupq_n_f64(0.0);
+        float64x2_t acc2 = vdupq_n_f64(0.0), acc3 = vdupq_n_f64(0.0);
+
+        for (int i = 0; i < numTaps; i += 8)
+        {
+            acc0 = vaddq_f64(acc0, vmulq_f64(vld1q_f64(x + i),     vld1q_f64(h + i)));
+            acc1 = vaddq_f64(acc1, vmulq_f64(vld1q_f64(x + i + 2), vld1q_f64(h + i + 2)));
+            acc2 = vaddq_f64(acc2, vmulq_f64(vld1q_f64(x + i + 4), vld1q_f64(h + i + 4)));
+            acc3 = vaddq_f64(acc3, vmulq_f64(vld1q_f64(x + i + 6), vld1q_f64(h + i + 6)));
+        }
+
+        const float64x2_t acc = vaddq_f64(vaddq_f64(acc0, acc2), vaddq_f64(acc1, acc3));
+        return vgetq_lane_f64(acc, 0) + vgetq_lane_f64(acc, 1);
+       #else
+        return dotScalar(x, h, numTaps); // ARMv7 no tiene NEON en doble
+       #endif
+    }
+   #endif
+
+    // ------------------------------------------------------
+    //  Reparto de [0, count) en tramos contiguos entre el hilo
+    //  que llama y el pool. Cada tramo depende solo de sus
+    //  indices, asi que el reparto no cambia el resultado.
+    // ------------------------------------------------------
+    int getNumSegments(juce::ThreadPool* pool, int count) noexcept
+    {
+        static constexpr int minFramesPerSegment = 512;
+
+        return pool != nullptr ? juce::jlimit(1, pool->getNumThreads() + 1, count / minFramesPerSegment)
+                               : 1;
+    }
+
+    template <typename Function>
+    void runSegments(juce::ThreadPool* pool, int count, int numSegments, Function&& processSegment)
+    {
+        if (numSegments <= 1)
+        {
+            processSegment(0, 0, count);
+            return;
+        }
+
+        std::atomic<int> remaining { numSegments - 1 };
+        juce::WaitableEvent finished;
+
+        const auto segmentStart = [count, numSegments](int s)
+        {
+            return (int) ((juce::int64) count * s / numSegments);
+        };
+
+        for (int s = 1; s < numSegments; ++s)
+        {
+            pool->addJob([&processSegment, &remaining, &finished, s, first = segmentStart(s), last = segmentStart(s + 1)]
+            {
+                processSegment(s, first, last);
+
+                if (--remaining == 0)
+                    finished.signal();
+            });
+        }
+
+        processSegment(0, 0, segmentStart(1));
+        finished.wait();
+    }
+
+    // ------------------------------------------------------
+    //  Interpolacion entre dos fases: dest = h0 + w * (h1 - h0).
+    //  Sin FMA en ninguna ruta: el resultado es igual en todas.
+    // ------------------------------------------------------
+    template <typename SampleType>
+    void lerpTaps(const SampleType* h0, const SampleType* h1, SampleType w, SampleType* dest, int numTaps) noexcept
+    {
+        int i = 0;
+
+       #if JUCE_USE_SSE_INTRINSICS
+        if constexpr (std::is_same_v<SampleType, float>)
+        {
+            const __m128 vw = _mm_set1_ps(w);
+
+            for (; i < numTaps; i += 4)
+            {
+                const __m128 a = _mm_loadu_ps(h0 + i);
+                _mm_storeu_ps(dest + i, _mm_add_ps(a, _mm_mul_ps(vw, _mm_sub_ps(_mm_loadu_ps(h1 + i), a))));
+            }
+        }
+        else
+        {
+            const __m128d vw = _mm_set1_pd(w);
+
+            for (; i < numTaps; i += 2)
+            {
+                const __m128d a = _mm_loadu_pd(h0 + i);
+                _mm_storeu_pd(dest + i, _mm_add_pd(a, _mm_mul_pd(vw, _mm_sub_pd(_mm_loadu_pd(h1 + i), a))));
+            }
+        }
+       #elif JUCE_USE_ARM_NEON
+        if constexpr (std::is_same_v<SampleType, float>)
+        {
+            const float32x4_t vw = vdupq_n_f32(w);
+
+            for (; i < numTaps; i += 4)
+            {
+                const float32x4_t a = vld1q_f32(h0 + i);
+                vst1q_f32(dest + i, vaddq_f32(a, vmulq_f32(vw, vsubq_f32(vld1q_f32(h1 + i), a))));
+            }
+        }
+       #endif
+
+        for (; i < numTaps; ++i)
+            dest[i] = h0[i] + w * (h1[i] - h0[i]);
+    }
+
+    // ------------------------------------------------------
+    //  Ultimo frame con bits distintos de cero (-1 = silencio).
+    //  Barre desde el final de a 32 bytes: con audio normal sale
+    //  en la primera comparacion. -0 cuenta como senal, asi la
+    //  salida de los motores no cambia ni en el signo del cero.
+    // ------------------------------------------------------
+    template <typename SampleType>
+    int findLastNonZero(const SampleType* x, int numFrames) noexcept
+    {
+        int i = numFrames;
+
+       #if JUCE_USE_SSE_INTRINSICS || JUCE_USE_ARM_NEON
+        constexpr int framesPerChunk = 32 / (int) sizeof(SampleType);
+
+        for (; i >= framesPerChunk; i -= framesPerChunk)
+        {
+            const auto* p = reinterpret_cast<const juce::uint8*>(x + i - framesPerChunk);
+
+           #if JUCE_USE_SSE_INTRINSICS
+            const __m128i bits = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)),
+                                              _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16)));
+
+            if (_mm_movemask_epi8(_mm_cmpeq_epi32(bits, _mm_setzero_si128())) != 0xffff)
+                break;
+           #else
+            const uint8x16_t bits = vorrq_u8(vld1q_u8(p), vld1q_u8(p + 16));
+            const uint8x8_t half = vorr_u8(vget_low_u8(bits), vget_high_u8(bits));
+
+            if (vget_lane_u64(vreinterpret_u64_u8(half), 0) != 0)
+                break;
+           #endif
+        }
+       #endif
+
+        for (; i > 0; --i)
+            if (x[i - 1] != SampleType() || std::signbit(x[i - 1]))
+                return i - 1;
+
+        return -1;
+    }
+
+    // Primera salida n (absoluta) con n * num >= bound * den, relativa a
+    // first y limitada a [0, count]: donde empiezan las salidas de silencio
+    int firstAtOrAfter(juce::int64 bound, juce::int64 num, juce::int64 den, juce::int64 first, int count) noexcept
+    {
+        const juce::int64 numer = bound * den;
+        const juce::int64 n = numer >= 0 ? (numer + num - 1) / num : -((-numer) / num);
+
+        return (int) juce::jlimit((juce::int64) 0, (juce::int64) count, n - first);
+    }
+
+    // ------------------------------------------------------
+    //  Diseno del kernel
+    // ------------------------------------------------------
+    struct PresetSpec
+    {
+        int baseTaps;           // taps por fase cuando L >= M
+        double attenuationDb;   // atenuacion en banda de rechazo
+    };
+
+    // Tope inferior del kernel adaptado al contenido: con kernels tan
+    // cortos la formula de Kaiser se queda corta (voz a 8 kHz con 16
+    // taps: -87 dB en standard, con 24: -103 dB)
+    constexpr int minAdaptiveTaps = 24;
+
+    PresetSpec getPresetSpec(HZPreset preset)
+    {
+        switch (preset)
+        {
+            case HZPreset::mastering: return { 192, 120.0 };
+            case HZPreset::draft:     return { 32, 70.0 };    // rutas FIR (ASRC, fase minima, monitoreo)
+            case HZPreset::standard:
+            default:                  return { 64, 90.0 };
+        }
+    }
+
+    double besselI0(double x)
+    {
+        double sum = 1.0, term = 1.0;
+
+        for (int k = 1; k < 64; ++k)
+        {
+            const double t = x / (2.0 * k);
+            term *= t * t;
+            sum += term;
+
+            if (term < 1.0e-14 * sum)
+                break;
+        }
+
+        return sum;
+    }
+
+    // Cada fase a ganancia DC 1
+    template <typename SampleType>
+    void normalizePhase(const std::vector<double>& values, SampleType* phase)
+    {
+        double sum = 0.0;
+
+        for (auto v : values)
+            sum += v;
+
+        for (size_t j = 0; j < values.size(); ++j)
+            phase[j] = (SampleType) (values[j] / sum);
+    }
+
+
+    // Kaiser de T taps (T multiplo de 8) con el corte escalado por
+    // min(1, salida/entrada) para que sirva de antialias al bajar.
+    struct KernelDesign
+    {
+        int numTaps;
+        double half, fc, beta, i0Beta;
+
+        KernelDesign(double ratio, HZPreset preset, double contentBandwidth = 0.0)
+        {
+            const auto spec  = getPresetSpec(preset);
+            const double scale = juce::jmin(1.0, ratio);
+
+            numTaps = (int) std::ceil(spec.baseTaps / scale);
+            numTaps = (numTaps + 7) & ~7;
+
+            const double transition = (spec.attenuationDb - 7.95) / (14.36 * spec.baseTaps);
+            fc = scale * (0.5 - transition * 0.5);
+
+            // Contenido recortado en B: transicion [B, 1 - B] (en la frecuencia
+            // menor), centrada en la mitad, con 10 dB de margen en el largo.
+            // Solo si acorta el kernel
+            const double wide = 1.0 - 2.0 * contentBandwidth;
+
+            if (contentBandwidth > 0.0 && wide > transition)
+            {
+                int taps = (int) std::ceil((spec.attenuationDb + 10.0 - 7.95) / (14.36 * wide) / scale);
+                taps = juce::jmax(minAdaptiveTaps, (taps + 7) & ~7);
+
+                if (taps < numTaps)
+                {
+                    numTaps = taps;
+                    fc = scale * 0.5;
+                }
+            }
+
+            half   = numTaps * 0.5;
+            beta   = 0.1102 * (spec.attenuationDb - 8.7);
+            i0Beta = besselI0(beta);
+        }
+
+        // Kernel continuo k(t) = 2fc * sinc(2fc * t) * kaiser(t), centrado en 0
+        double evaluate(double t) const
+        {
+            const double u = t / half;
+
+            if (std::abs(u) >= 1.0)
+                return 0.0;
+
+            const double x = 2.0 * fc * t;
+            const double sinc = (std::abs(x) < 1.0e-12) ? 1.0
+                                                        : std::sin(juce::MathConstants<double>::pi * x)
+                                                              / (juce::MathConstants<double>::pi * x);
+            return 2.0 * fc * sinc * besselI0(beta * std::sqrt(1.0 - u * u)) / i0Beta;
+        }
+
+        // Fase lineal: k muestreado en t = frac + T/2 - 1 - j
+        template <typename SampleType>
+        void fillPhase(double frac, SampleType* phase) const
+        {
+            std::vector<double> values((size_t) numTaps);
+
+            for (int j = 0; j < numTaps; ++j)
+                values[(size_t) j] = evaluate(frac + half - 1.0 - j);
+
+            normalizePhase(values, phase);
+        }
+    };
+
+
+    // Halfband de Kaiser h(k) = 0.5 * sinc(k / 2) * kaiser(k), |k| <= 2K - 1.
+    // passEdge es relativo a la frecuencia baja; la transicion queda
+    // centrada en su Nyquist. Devuelve los 2K taps impares en el orden
+    // del historial (g[j] = 2 h(2K - 1 - 2j)), normalizados a suma 1.
+    std::vector<double> designHalfband(double passEdge, double attenuationDb)
+    {
+        const double width  = 0.5 - passEdge;   // a la frecuencia alta
+        const double length = (attenuationDb - 7.95) / (14.36 * width) + 1.0;
+
+        // Con transiciones anchas la estimacion de Kaiser se queda corta
+        // (medido): al menos A / 8 taps impares por lado
+        const double minHalf = attenuationDb / 8.0;
+        const int halfLength = ((int) std::ceil(juce::jmax((length + 1.0) / 4.0, minHalf)) + 3) & ~3;   // 2K multiplo de 8
+
+        const double half   = 2.0 * halfLength;
+        const double beta   = 0.1102 * (attenuationDb - 8.7);
+        const double i0Beta = besselI0(beta);
+
+        std::vector<double> taps((size_t) (2 * halfLength));
+        double sum = 0.0;
+
+        for (int j = 0; j < 2 * halfLength; ++j)
+        {
+            const double k = 2.0 * halfLength - 1.0 - 2.0 * j;
+            const double u = k / half;
+            const double x = juce::MathConstants<double>::pi * k * 0.5;
+
+            taps[(size_t) j] = (std::sin(x) / x) * besselI0(beta * std::sqrt(1.0 - u * u)) / i0Beta;
+            sum += taps[(size_t) j];
+        }
+
+        for (auto& t : taps)
+            t /= sum;
+
+        return taps;
+    }
+
+    // Fases de la tabla interpolada: el error de interpolar
+    // linealmente queda por debajo de la atenuacion del preset
+    int getVariablePhaseCount(HZPreset preset)
+    {
+        return preset == HZPreset::mastering ? 2048 : 256;
+    }
+
+    // Piso del modo compacto aunque la tabla pase del presupuesto
+    constexpr int minCompactPhases = 64;
+
+    template <typename SampleType>
+    using DotFunction = SampleType (*)(const SampleType*, const SampleType*, int) noexcept;
+
+    template <typename SampleType>
+    DotFunction<SampleType> selectDot(HZKernelIsa isa)
+    {
+        if (! isIsaAvailable(isa))
+            isa = getCanonicalIsa();
+
+        switch (isa)
+        {
+           #if JUCE_USE_SSE_INTRINSICS
+            case HZKernelIsa::avx2:    return dotAvx2;
+            case HZKernelIsa::simd128: return dotSimd128;
+           #elif JUCE_USE_ARM_NEON
+            case HZKernelIsa::simd128: return dotSimd128;
+           #endif
+            default:                   return dotScalar<SampleType>;
+        }
+    }
+}
+
+// ==========================================================
+//  Nombres (perfil de autotune / log)
+// ==========================================================
+juce::String toString(HZPreset preset)
+{
+    switch (preset)
+    {
+        case HZPreset::mastering: return "mastering";
+        case HZPreset::draft:     return "draft";
+        case HZPreset::standard:
+        default:                  return "standard";
+    }
+}
+
+double getAttenuationDb(HZPreset preset)
+{
+    return getPresetSpec(preset).attenuationDb;
+}
+
+juce::String toString(HZPhaseResponse phase)
+{
+    return phase == HZPhaseResponse::minimum ? "minimum" : "linear";
+}
+
+juce::String toString(HZKernelIsa isa)
+{
+    switch (isa)
+    {
+        case HZKernelIsa::avx2:    return "avx2";
+        case HZKernelIsa::simd128: return "simd128";
+        case HZKernelIsa::scalar:
+        default:                   return "scalar";
+    }
+}
+
+juce::String toString(HZChannelLayout layout)
+{
+    return layout == HZChannelLayout::frameMajor ? "frameMajor" : "planar";
+}
+
+HZPreset presetFromString(const juce::String& s)
+{
+    if (s == "mastering") return HZPreset::mastering;
+    if (s == "draft")     return HZPreset::draft;
+    return HZPreset::standard;
+}
+
+HZKernelIsa isaFromString(const juce::String& s)
+{
+    if (s == "avx2")    return HZKernelIsa::avx2;
+    if (s == "simd128") return HZKernelIsa::simd128;
+    return HZKernelIsa::scalar;
+}
+
+HZChannelLayout layoutFromString(const juce::String& s)
+{
+    return s == "frameMajor" ? HZChannelLayout::frameMajor : HZChannelLayout::planar;
+}
+
+bool isIsaAvailable(HZKernelIsa isa)
+{
+    switch (isa)
+    {
+       #if JUCE_USE_SSE_INTRINSICS
+        case HZKernelIsa::avx2:    return juce::SystemStats::hasAVX2() && juce::SystemStats::hasFMA3();
+        case HZKernelIsa::simd128: return true;
+       #elif JUCE_USE_ARM_NEON
+        case HZKernelIsa::avx2:    return false;
+        case HZKernelIsa::simd128: return true;
+       #else
+        case HZKernelIsa::avx2:
+        case HZKernelIsa::simd128: return false;
+       #endif
+        case HZKernelIsa::scalar:
+        default:                   return true;
+    }
+}
+
+HZKernelIsa getCanonicalIsa()
+{
+    return isIsaAvailable(HZKernelIsa::simd128) ? HZKernelIsa::simd128 : HZKernelIsa::scalar;
+}
+
+// ==========================================================
+//  Ratio
+// ==========================================================
+HZRatio HZRatio::fromRates(double inRate, double outRate)
+{
+    const int in  = juce::roundToInt(inRate);
+    const int out = juce::roundToInt(outRate);
+
+    if (in <= 0 || out <= 0)
+        return { 0, 0 };
+
+    const int g = std::gcd(in, out);
+    return { out / g, in / g };
+}
+
+// ==========================================================
+//  Tabla polifasica: fase p = kernel en frac = p / L
+// ==========================================================
+template <typename SampleType>
+HZPolyphaseFilter<SampleType>::HZPolyphaseFilter(HZRatio r, HZPreset preset, HZPhaseResponse phase,
+                                                 double contentBandwidth)
+    : ratio(r)
+{
+    jassert(ratio.isValid());
+
+    const KernelDesign design(ratio.toDouble(), preset, contentBandwidth);
+    const int up = ratio.up;
+    numTaps = design.numTaps;
+    coeffs.resize((size_t) up * (size_t) numTaps);
+
+    if (phase == HZPhaseResponse::linear)
+    {
+        lookahead = numTaps / 2;
+
+        for (int p = 0; p < up; ++p)
+            design.fillPhase((double) p / (double) up, coeffs.data() + (size_t) p * (size_t) numTaps);
+
+        return;
+    }
+
+    // Fase minima: prototipo completo a L veces la frecuencia de entrada
+    // (h[n] = k(n / L - T/2)), convertido por cepstrum. El kernel queda
+    // causal: la fase p, tap j usa t = p / L + T - 1 - j, n = L * t.
+    std::vector<double> prototype((size_t) up * (size_t) numTaps);
+
+    for (size_t n = 0; n < prototype.size(); ++n)
+        prototype[n] = design.evaluate((double) n / (double) up - design.half);
+
+    const auto minimum = makeMinimumPhase(prototype);
+    std::vector<double> values((size_t) numTaps);
+
+    for (int p = 0; p < up; ++p)
+    {
+        for (int j = 0; j < numTaps; ++j)
+            values[(size_t) j] = minimum[(size_t) (p + up * (numTaps - 1 - j))];
+
+        normalizePhase(values, coeffs.data() + (size_t) p * (size_t) numTaps);
+    }
+
+    lookahead  = 0;
+    groupDelay = getGroupDelayAtDc(minimum) / (double) up;
+}
+
+template <typename SampleType>
+size_t HZPolyphaseFilter<SampleType>::getTableBytes(HZRatio r, HZPreset preset)
+{
+    const KernelDesign design(r.toDouble(), preset);
+    return (size_t) r.up * (size_t) design.numTaps * sizeof(SampleType);
+}
+
+// ==========================================================
+//  Tabla interpolada: fase p = kernel en frac = p / P, p <= P
+// ==========================================================
+template <typename SampleType>
+HZVariablePolyphaseFilter<SampleType>::HZVariablePolyphaseFilter(double nominalRatio, HZPreset preset,
+                                                                 size_t maxTableBytes, double contentBandwidth)
+    : numPhases(getVariablePhaseCount(preset))
+{
+    jassert(nominalRatio > 0.0);
+
+    const KernelDesign design(nominalRatio, preset, contentBandwidth);
+    numTaps = design.numTaps;
+
+    // Modo compacto: P + 1 fases dentro del presupuesto. El error de la
+    // interpolacion lineal baja con P^2: en 256 KB queda a ~ -107 dB de
+    // la tabla exacta en standard y ~ -120 dB en mastering
+    if (maxTableBytes > 0)
+    {
+        const auto bytesPerPhase = (size_t) numTaps * sizeof(SampleType);
+        const int fitting = (int) (maxTableBytes / bytesPerPhase) - 1;
+        numPhases = juce::jlimit(minCompactPhases, numPhases, fitting);
+    }
+
+    coeffs.resize((size_t) (numPhases + 1) * (size_t) numTaps);
+
+    for (int p = 0; p <= numPhases; ++p)
+        design.fillPhase((double) p / (double) numPhases, coeffs.data() + (size_t) p * (size_t) numTaps);
+}
+
+// ==========================================================
+//  Historial de entrada
+// ==========================================================
+template <typename SampleType>
+HZInputHistory<SampleType>::HZInputHistory(int numChannels)
+    : data((size_t) numChannels)
+{
+}
+
+template <typename SampleType>
+void HZInputHistory<SampleType>::reset(int numLeadingZeros)
+{
+    start = -(juce::int64) numLeadingZeros;
+    size  = numLeadingZeros;
+    silenceStart = start;
+
+    for (auto& h : data)
+        h.assign((size_t) juce::jmax(size, 1), SampleType());
+}
+
+template <typename SampleType>
+void HZInputHistory<SampleType>::discardBefore(juce::int64 firstNeeded)
+{
+    const int drop = (int) juce::jlimit((juce::int64) 0, (juce::int64) size, firstNeeded - start);
+
+    if (drop <= 0)
+        return;
+
+    for (auto& h : data)
+        std::copy(h.begin() + drop, h.begin() + size, h.begin());
+
+    start += drop;
+    size  -= drop;
+}
+
+template <typename SampleType>
+void HZInputHistory<SampleType>::push(const SampleType* const* input, int numFrames)
+{
+    if (numFrames <= 0)
+        return;
+
+    const auto needed = (size_t) (size + numFrames);
+
+    for (size_t ch = 0; ch < data.size(); ++ch)
+    {
+        auto& h = data[ch];
+
+        if (h.size() < needed)
+            h.resize(needed);
+
+        if (input != nullptr)
+            std::copy(input[ch], input[ch] + numFrames, h.begin() + size);
+        else
+            std::fill(h.begin() + size, h.begin() + size + numFrames, SampleType());
+    }
+
+    // Los ceros agregados solo alargan el tramo de silencio
+    if (input != nullptr)
+    {
+        int last = -1;
+
+        for (size_t ch = 0; ch < data.size() && last < numFrames - 1; ++ch)
+            last = juce::jmax(last, findLastNonZero(input[ch], numFrames));
+
+        if (last >= 0)
+            silenceStart = getEnd() + last + 1;
+    }
+
+    size += numFrames;
+}
+
+// ==========================================================
+//  Motor en streaming
+// ==========================================================
+template <typename SampleType>
+HZResamplerEngine<SampleType>::HZResamplerEngine(const HZPolyphaseFilter<SampleType>& f, int channels, HZKernelVariant v)
+    : filter(f),
+      numChannels(channels),
+      variant(v),
+      numTaps(f.getNumTaps()),
+      lookahead(f.getLookahead()),
+      pastTaps(f.getNumTaps() - f.getLookahead()),
+      stepWhole(f.getRatio().down / f.getRatio().up),
+      stepFrac(f.getRatio().down % f.getRatio().up),
+      dot(selectDot<SampleType>(v.isa)),
+      history(channels)
+{
+    reset();
+}
+
+template <typename SampleType>
+void HZResamplerEngine<SampleType>::reset()
+{
+    // La salida 0 necesita pastTaps - 1 muestras previas (ceros)
+    history.reset(pastTaps - 1);
+    nextOutput = 0;
+}
+
+template <typename SampleType>
+void HZResamplerEngine<SampleType>::positionOf(juce::int64 n, juce::int64& base, int& phase) const noexcept
+{
+    const auto r = filter.getRatio();
+    const juce::int64 m = n * r.down;
+
+    base  = m / r.up;
+    phase = (int) (m % r.up);
+}
+
+template <typename SampleType>
+int HZResamplerEngine<SampleType>::getInputBlockSize() const noexcept
+{
+    const auto r = filter.getRatio();
+    return (int) ((juce::int64) variant.blockSize * r.down / r.up) + 1;
+}
+
+template <typename SampleType>
+void HZResamplerEngine<SampleType>::discardConsumed()
+{
+    juce::int64 nextBase;
+    int nextPhase;
+    positionOf(nextOutput, nextBase, nextPhase);
+
+    history.discardBefore(nextBase - pastTaps + 1);
+}
+
+template <typename SampleType>
+void HZResamplerEngine<SampleType>::pushInput(const SampleType* const* input, int numFrames)
+{
+    discardConsumed();
+    history.push(input, numFrames);
+}
+
+template <typename SampleType>
+void HZResamplerEngine<SampleType>::pushSilence(int numFrames)
+{
+    discardConsumed();
+    history.push(nullptr, numFrames);
+}
+
+template <typename SampleType>
+int HZResamplerEngine<SampleType>::countAvailable(int maxFrames) const noexcept
+{
+    // La salida con base b necesita la entrada hasta b + lookahead
+    const auto r = filter.getRatio();
+    juce::int64 nextBase;
+    int nextPhase;
+    positionOf(nextOutput, nextBase, nextPhase);
+
+    const juce::int64 lastBase = history.getEnd() - 1 - lookahead;
+    const juce::int64 numer = (lastBase + 1 - nextBase) * r.up - nextPhase;
+
+    if (numer <= 0)
+        return 0;
+
+    return (int) juce::jmin((juce::int64) maxFrames, (numer + r.down - 1) / r.down);
+}
+
+template <typename SampleType>
+int HZResamplerEngine<SampleType>::produce(SampleType* const* output, int maxFrames)
+{
+    const int count = countAvailable(maxFrames);
+
+    if (count <= 0)
+        return 0;
+
+    // Silencio digital: desde la salida cuya ventana (base - pastTaps + 1)
+    // empieza en el tramo final de ceros, todo es +0 sin convolucion
+    const auto r = filter.getRatio();
+    const int computed = firstAtOrAfter(history.getSilenceStart() + pastTaps - 1, r.down, r.up, nextOutput, count);
+
+    // Tramos contiguos de salida; cada uno recalcula su fase desde el indice absoluto
+    runSegments(threadPool, computed, getNumSegments(threadPool, computed), [this, output](int, int first, int last)
+    {
+        processRange(output, first, last);
+    });
+
+    for (int ch = 0; ch < numChannels; ++ch)
+        std::fill(output[ch] + computed, output[ch] + count, SampleType());
+
+    nextOutput += count;
+    return count;
+}
+
+template <typename SampleType>
+void HZResamplerEngine<SampleType>::processRange(SampleType* const* output, int first, int last) const noexcept
+{
+    const int up = filter.getRatio().up;
+
+    const auto advance = [this, up](juce::int64& b, int& p) noexcept
+    {
+        b += stepWhole;
+        p += stepFrac;
+
+        if (p >= up)
+        {
+            p -= up;
+            ++b;
+        }
+    };
+
+    juce::int64 firstBase;
+    int firstPhase;
+    positionOf(nextOutput + first, firstBase, firstPhase);
+
+    if (variant.layout == HZChannelLayout::planar)
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            SampleType* out = output[ch];
+            auto base  = firstBase;
+            auto phase = firstPhase;
+
+            for (int i = first; i < last; ++i)
+            {
+                out[i] = dot(history.getPointer(ch, base - pastTaps + 1), filter.getPhase(phase), numTaps);
+                advance(base, phase);
+            }
+        }
+    }
+    else
+    {
+        auto base  = firstBase;
+        auto phase = firstPhase;
+
+        for (int i = first; i < last; ++i)
+        {
+            const SampleType* h = filter.getPhase(phase);
+            const auto start = base - pastTaps + 1;
+
+            for (int ch = 0; ch < numChannels; ++ch)
+                output[ch][i] = dot(history.getPointer(ch, start), h, numTaps);
+
+            advance(base, phase);
+        }
+    }
+}
+
+// ==========================================================
+//  Motor de ratio variable
+// ==========================================================
+template <typename SampleType>
+HZVariableResamplerEngine<SampleType>::HZVariableResamplerEngine(const HZVariablePolyphaseFilter<SampleType>& f,
+                                                                 int channels, HZKernelVariant v, double inputStep)
+    : filter(f),
+      numChannels(channels),
+      variant(v),
+      numTaps(f.getNumTaps()),
+      halfTaps(f.getNumTaps() / 2),
+      dot(selectDot<SampleType>(v.isa)),
+      history(channels),
+      exactRatio { 0, 1 },
+      initialStep(inputStep)
+{
+    jassert(inputStep > 0.0);
+    reset();
+}
+
+template <typename SampleType>
+HZVariableResamplerEngine<SampleType>::HZVariableResamplerEngine(const HZVariablePolyphaseFilter<SampleType>& f,
+                                                                 int channels, HZKernelVariant v, HZRatio ratio)
+    : filter(f),
+      numChannels(channels),
+      variant(v),
+      numTaps(f.getNumTaps()),
+      halfTaps(f.getNumTaps() / 2),
+      dot(selectDot<SampleType>(v.isa)),
+      history(channels),
+      exactRatio(ratio),
+      initialStep(1.0 / ratio.toDouble())
+{
+    jassert(ratio.isValid());
+    reset();
+}
+
+template <typename SampleType>
+void HZVariableResamplerEngine<SampleType>::reset()
+{
+    history.reset(halfTaps - 1);
+
+    base = 0;
+    frac = 0.0;
+    remainder = 0;
+    step = targetStep = initialStep;
+    stepDelta = 0.0;
+    rampRemaining = 0;
+}
+
+template <typename SampleType>
+void HZVariableResamplerEngine<SampleType>::setInputStep(double newStep, juce::int64 rampFrames) noexcept
+{
+    jassert(newStep > 0.0);
+    jassert(exactRatio.up == 0);
+
+    targetStep = newStep;
+    rampRemaining = juce::jmax((juce::int64) 0, rampFrames);
+
+    if (rampRemaining == 0)
+        step = newStep;
+    else
+        stepDelta = (newStep - step) / (double) rampRemaining;
+}
+
+template <typename SampleType>
+int HZVariableResamplerEngine<SampleType>::getInputBlockSize() const noexcept
+{
+    return (int) std::ceil(variant.blockSize * juce::jmax(step, targetStep)) + 1;
+}
+
+template <typename SampleType>
+void HZVariableResamplerEngine<SampleType>::pushInput(const SampleType* const* input, int numFrames)
+{
+    history.discardBefore(base - halfTaps + 1);
+    history.push(input, numFrames);
+}
+
+template <typename SampleType>
+void HZVariableResamplerEngine<SampleType>::pushSilence(int numFrames)
+{
+    history.discardBefore(base - halfTaps + 1);
+    history.push(nullptr, numFrames);
+}
+
+template <typename SampleType>
+int HZVariableResamplerEngine<SampleType>::produce(SampleType* const* output, int maxFrames)
+{
+    // Posiciones en secuencia (la rampa depende de la salida anterior)
+    const juce::int64 lastBase = history.getEnd() - 1 - halfTaps;
+    const int numPhases = filter.getNumPhases();
+
+    if (positions.size() < (size_t) maxFrames)
+        positions.resize((size_t) maxFrames);
+
+    int count = 0;
+
+    if (exactRatio.up > 0)
+    {
+        // Paso racional: la posicion es exacta y solo los coeficientes
+        // se interpolan (fraccion remainder / L llevada a [0, P])
+        const int up = exactRatio.up;
+        const int stepWhole = exactRatio.down / up;
+        const int stepFrac  = exactRatio.down % up;
+        const double phaseScale = (double) numPhases / (double) up;
+
+        for (; count < maxFrames && base <= lastBase; ++count)
+        {
+            const double f = remainder * phaseScale;
+            const int phase = juce::jmin((int) f, numPhases - 1);
+            positions[(size_t) count] = { base, phase, (SampleType) (f - phase) };
+
+            base += stepWhole;
+            remainder += stepFrac;
+
+            if (remainder >= up)
+            {
+                remainder -= up;
+                ++base;
+            }
+        }
+    }
+    else
+    {
+        for (; count < maxFrames && base <= lastBase; ++count)
+        {
+            const double f = frac * numPhases;
+            const int phase = juce::jmin((int) f, numPhases - 1);
+            positions[(size_t) count] = { base, phase, (SampleType) (f - phase) };
+
+            frac += step;
+            const double whole = std::floor(frac);
+            base += (juce::int64) whole;
+            frac -= whole;
+
+            if (rampRemaining > 0)
+                step = --rampRemaining > 0 ? step + stepDelta : targetStep;
+        }
+    }
+
+    if (count <= 0)
+        return 0;
+
+    // Silencio digital: las ventanas que empiezan en el tramo final de
+    // ceros van al final del bloque (las bases no bajan)
+    const juce::int64 silentBase = history.getSilenceStart() + halfTaps - 1;
+    int computed = count;
+
+    while (computed > 0 && positions[(size_t) computed - 1].base >= silentBase)
+        --computed;
+
+    const int numSegments = getNumSegments(threadPool, computed);
+    scratch.resize((size_t) numSegments * (size_t) numTaps);
+
+    runSegments(threadPool, computed, numSegments, [this, output](int segment, int first, int last)
+    {
+        processRange(output, first, last, scratch.data() + (size_t) segment * (size_t) numTaps);
+    });
+
+    for (int ch = 0; ch < numChannels; ++ch)
+        std::fill(output[ch] + computed, output[ch] + count, SampleType());
+
+    return count;
+}
+
+template <typename SampleType>
+void HZVariableResamplerEngine<SampleType>::processRange(SampleType* const* output, int first, int last,
+                                                         SampleType* coeffs) const noexcept
+{
+    for (int i = first; i < last; ++i)
+    {
+        const auto& pos = positions[(size_t) i];
+        lerpTaps(filter.getPhase(pos.phase), filter.getPhase(pos.phase + 1), pos.weight, coeffs, numTaps);
+
+        const auto start = pos.base - halfTaps + 1;
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            output[ch][i] = dot(history.getPointer(ch, start), coeffs, numTaps);
+    }
+}
+
+// ==========================================================
+//  Cascada halfband (ratios 2^k)
+// ==========================================================
+template <typename SampleType>
+struct HZHalfbandResamplerEngine<SampleType>::Stage
+{
+    Stage(bool up, const std::vector<double>& taps, int channels, DotFunction<SampleType> d)
+        : upsample(up),
+          numTaps((int) taps.size()),
+          halfLength((int) taps.size() / 2),
+          coeffs(taps.begin(), taps.end()),
+          dot(d),
+          even(channels),
+          odd(channels),
+          split((size_t) (2 * channels)),
+          splitPointers((size_t) (2 * channels))
+    {
+        reset();
+    }
+
+    // Interpolar: even = entrada completa. Diezmar: pares / impares.
+    void reset()
+    {
+        if (upsample)
+        {
+            even.reset(halfLength - 1);
+        }
+        else
+        {
+            even.reset(0);
+            odd.reset(halfLength);
+        }
+
+        received = 0;
+        nextOutput = 0;
+    }
+
+    /** Muestras de entrada de la etapa que necesita por delante. */
+    int getLookahead() const noexcept
+    {
+        return upsample ? halfLength : numTaps - 1;
+    }
+
+    void push(const SampleType* const* input, int numFrames)
+    {
+        if (numFrames <= 0)
+            return;
+
+        if (upsample)
+        {
+            even.discardBefore((nextOutput >> 1) + 1 - halfLength);
+            even.push(input, numFrames);
+            received += numFrames;
+            return;
+        }
+
+        even.discardBefore(nextOutput);
+        odd.discardBefore(nextOutput - halfLength);
+
+        // La paridad se toma del indice absoluto de entrada
+        const int firstOdd = (int) (received & 1);
+        const int numEven  = (numFrames + 1 - firstOdd) / 2;
+        const int numOdd   = numFrames - numEven;
+        const int numChannels = (int) split.size() / 2;
+
+        if (input != nullptr)
+        {
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                auto& e = split[(size_t) ch];
+                auto& o = split[(size_t) (numChannels + ch)];
+                e.resize((size_t) numEven);
+                o.resize((size_t) numOdd);
+
+                const SampleType* in = input[ch];
+
+                for (int i = 0; i < numEven; ++i)
+                    e[(size_t) i] = in[firstOdd + 2 * i];
+
+                for (int i = 0; i < numOdd; ++i)
+                    o[(size_t) i] = in[1 - firstOdd + 2 * i];
+
+                splitPointers[(size_t) ch] = e.data();
+                splitPointers[(size_t) (numChannels + ch)] = o.data();
+            }
+        }
+
+        even.push(input != nullptr ? splitPointers.data() : nullptr, numEven);
+        odd.push(input != nullptr ? splitPointers.data() + numChannels : nullptr, numOdd);
+        received += numFrames;
+    }
+
+    int countAvailable() const noexcept
+    {
+        const juce::int64 limit = upsample ? 2 * (even.getEnd() - halfLength)
+                                           : juce::jmin(even.getEnd(), odd.getEnd() - halfLength + 1);
+
+        return (int) juce::jlimit((juce::int64) 0, (juce::int64) std::numeric_limits<int>::max(), limit - nextOutput);
+    }
+
+    /** Salidas calculadas antes del silencio: en las siguientes todas
+        las muestras que se leen son ceros. */
+    int countBeforeSilence(int count) const noexcept
+    {
+        if (upsample)
+            return firstAtOrAfter(even.getSilenceStart() + halfLength - 1, 1, 2, nextOutput, count);
+
+        return firstAtOrAfter(juce::jmax(even.getSilenceStart(), odd.getSilenceStart() + halfLength),
+                              1, 1, nextOutput, count);
+    }
+
+    void produce(SampleType* const* output, int numChannels, int count, juce::ThreadPool* pool)
+    {
+        const int computed = countBeforeSilence(count);
+
+        runSegments(pool, computed, getNumSegments(pool, computed), [this, output, numChannels](int, int first, int last)
+        {
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                SampleType* out = output[ch];
+
+                for (int i = first; i < last; ++i)
+                {
+                    const juce::int64 n = nextOutput + i;
+
+                    if (! upsample)
+                    {
+                        out[i] = (SampleType) 0.5 * (*even.getPointer(ch, n)
+                                                       + dot(odd.getPointer(ch, n - halfLength), coeffs.data(), numTaps));
+                    }
+                    else if ((n & 1) == 0)
+                    {
+                        out[i] = *even.getPointer(ch, n >> 1);
+                    }
+                    else
+                    {
+                        out[i] = dot(even.getPointer(ch, (n >> 1) + 1 - halfLength), coeffs.data(), numTaps);
+                    }
+                }
+            }
+        });
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            std::fill(output[ch] + computed, output[ch] + count, SampleType());
+
+        nextOutput += count;
+    }
+
+    const bool upsample;
+    const int numTaps, halfLength;   // 2K taps impares, K por lado
+    const std::vector<SampleType> coeffs;
+    const DotFunction<SampleType> dot;
+
+    HZInputHistory<SampleType> even, odd;
+    juce::int64 received = 0;
+    juce::int64 nextOutput = 0;
+
+    std::vector<std::vector<SampleType>> split;
+    std::vector<const SampleType*> splitPointers;
+};
+
+template <typename SampleType>
+HZHalfbandResamplerEngine<SampleType>::HZHalfbandResamplerEngine(HZRatio r, HZPreset preset, int channels, HZKernelVariant v,
+                                                                 double contentBandwidth)
+    : ratio(r),
+      numChannels(channels),
+      variant(v)
+{
+    jassert(supportsRatio(ratio));
+
+    const bool upsample = ratio.up > ratio.down;
+    const int numStages = juce::roundToInt(std::log2((double) juce::jmax(ratio.up, ratio.down)));
+
+    // Misma banda de paso que el kernel general del preset, o la del
+    // contenido si es menor (un 96k subido de 44.1k no pasa de 22 kHz)
+    const auto spec = getPresetSpec(preset);
+    const double transition = (spec.attenuationDb - 7.95) / (14.36 * spec.baseTaps);
+    double passEdge = 0.5 - transition * 0.5;
+
+    if (contentBandwidth > 0.0)
+        passEdge = juce::jmin(passEdge, contentBandwidth);
+    const auto dot = selectDot<SampleType>(variant.isa);
+
+    for (int s = 0; s < numStages; ++s)
+    {
+        // Frecuencia baja de la etapa = base * 2^octave
+        const int octave = upsample ? s : numStages - 1 - s;
+        const auto taps = designHalfband(passEdge / (double) (1 << octave), spec.attenuationDb);
+
+        stages.push_back(std::make_unique<Stage>(upsample, taps, numChannels, dot));
+
+        // Cola de ceros que alcanza a la ultima etapa, en muestras de entrada
+        const double inputScale = upsample ? 1.0 / (double) (1 << s) : (double) (1 << s);
+        flushLength += (int) std::ceil(stages.back()->getLookahead() * inputScale) + (1 << s);
+    }
+
+    between.resize((size_t) juce::jmax(0, numStages - 1),
+                   std::vector<std::vector<SampleType>>((size_t) numChannels));
+}
+
+template <typename SampleType>
+HZHalfbandResamplerEngine<SampleType>::~HZHalfbandResamplerEngine() = default;
+
+template <typename SampleType>
+bool HZHalfbandResamplerEngine<SampleType>::supportsRatio(HZRatio r) noexcept
+{
+    return r.isValid() && juce::jmin(r.up, r.down) == 1 && juce::jmax(r.up, r.down) > 1
+             && juce::isPowerOfTwo(juce::jmax(r.up, r.down));
+}
+
+template <typename SampleType>
+void HZHalfbandResamplerEngine<SampleType>::reset()
+{
+    for (auto& stage : stages)
+        stage->reset();
+
+    inputFrames = 0;
+    outputFrames = 0;
+    flushed = false;
+}
+
+template <typename SampleType>
+int HZHalfbandResamplerEngine<SampleType>::getInputBlockSize() const noexcept
+{
+    return (int) ((juce::int64) variant.blockSize * ratio.down / ratio.up) + 1;
+}
+
+template <typename SampleType>
+int HZHalfbandResamplerEngine<SampleType>::getStageTaps(int stage) const noexcept
+{
+    return juce::isPositiveAndBelow(stage, (int) stages.size()) ? stages[(size_t) stage]->numTaps : 0;
+}
+
+template <typename SampleType>
+void HZHalfbandResamplerEngine<SampleType>::pushInput(const SampleType* const* input, int numFrames)
+{
+    stages.front()->push(input, numFrames);
+    inputFrames += juce::jmax(0, numFrames);
+}
+
+template <typename SampleType>
+void HZHalfbandResamplerEngine<SampleType>::pushSilence(int numFrames)
+{
+    stages.front()->push(nullptr, numFrames);
+    flushed = true;
+}
+
+template <typename SampleType>
+int HZHalfbandResamplerEngine<SampleType>::produce(SampleType* const* output, int maxFrames)
+{
+    // Etapas intermedias: todo lo disponible pasa a la siguiente
+    for (size_t s = 0; s + 1 < stages.size(); ++s)
+    {
+        const int count = stages[s]->countAvailable();
+
+        if (count <= 0)
+            continue;
+
+        std::vector<SampleType*> pointers((size_t) numChannels);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            auto& data = between[s][(size_t) ch];
+
+            if (data.size() < (size_t) count)
+                data.resize((size_t) count);
+
+            pointers[(size_t) ch] = data.data();
+        }
+
+        stages[s]->produce(pointers.data(), numChannels, count, threadPool);
+        stages[s + 1]->push(pointers.data(), count);
+    }
+
+    int count = juce::jmin(maxFrames, stages.back()->countAvailable());
+
+    // Tras la cola, el largo exacto del motor general: ceil(N_in * L / M)
+    if (flushed)
+    {
+        const juce::int64 total = (inputFrames * ratio.up + ratio.down - 1) / ratio.down;
+        count = (int) juce::jmin((juce::int64) count, total - outputFrames);
+    }
+
+    if (count <= 0)
+        return 0;
+
+    stages.back()->produce(output, numChannels, count, threadPool);
+    outputFrames += count;
+    return count;
+}
+
+template class HZPolyphaseFilter<float>;
+template class HZPolyphaseFilter<double>;
+template class HZVariablePolyphaseFilter<float>;
+template class HZVariablePolyphaseFilter<double>;
+template class HZInputHistory<float>;
+template class HZInputHistory<double>;
+template class HZResamplerEngine<float>;
+template class HZResamplerEngine<double>;
+template class HZVariableResamplerEngine<float>;
+template class HZVariableResamplerEngine<double>;
+template class HZHalfbandResamplerEngine<float>;
+template class HZHalfbandResamplerEngine<double>;
@@ -0,0 +1,423 @@
+#pragma once
+#include "JuceHeader.h"
+#include <vector>
+
+// ==========================================================
+//  Motor polifasico (sinc con ventana Kaiser) para ratios
+//  racionales L/M, y variante de ratio variable (ASRC) con
+//  tabla interpolada. Las tablas son de solo lectura y se
+//  comparten entre canales; cada canal guarda su historial.
+// ==========================================================
+
+/** Calidad del kernel: define numero de taps y atenuacion. */
+enum class HZPreset
+{
+    standard,
+    mastering,
+    draft       // previews: IIR polifasico + sinc corto (ver ResamplerDraft.h)
+};
+
+/** Respuesta de fase del kernel. */
+enum class HZPhaseResponse
+{
+    linear,     // simetrico, centrado: latencia T/2 (offline / mastering)
+    minimum     // fase minima por cepstrum: latencia de pocas muestras (monitoreo)
+};
+
+/** Implementacion del producto escalar (nivel de ISA). */
+enum class HZKernelIsa
+{
+    scalar,
+    simd128,    // SSE2 / NEON
+    avx2        // AVX2 + FMA (solo x86)
+};
+
+/** Orden en que se recorren canales y muestras de salida. */
+enum class HZChannelLayout
+{
+    planar,     // un canal completo por bloque, luego el siguiente
+    frameMajor  // todos los canales por cada muestra (fase compartida)
+};
+
+struct HZKernelVariant
+{
+    HZKernelIsa isa = HZKernelIsa::simd128;
+    HZChannelLayout layout = HZChannelLayout::planar;
+    int blockSize = 8192;   // frames de salida por bloque
+};
+
+juce::String toString(HZPreset preset);
+juce::String toString(HZPhaseResponse phase);
+juce::String toString(HZKernelIsa isa);
+juce::String toString(HZChannelLayout layout);
+
+/** Atenuacion de banda de rechazo del kernel FIR del preset, en dB. */
+double getAttenuationDb(HZPreset preset);
+
+HZPreset presetFromString(const juce::String& s);
+HZKernelIsa isaFromString(const juce::String& s);
+HZChannelLayout layoutFromString(const juce::String& s);
+
+/** True si la CPU actual puede ejecutar esa variante. */
+bool isIsaAvailable(HZKernelIsa isa);
+
+/** ISA con el orden de acumulacion canonico (scalar == simd128 bit a bit),
+    usada por el modo determinista. */
+HZKernelIsa getCanonicalIsa();
+
+// ==========================================================
+//  Ratio racional salida/entrada (up = L, down = M)
+// ==========================================================
+struct HZRatio
+{
+    int up = 1;
+    int down = 1;
+
+    static HZRatio fromRates(double inRate, double outRate);
+
+    bool isValid() const noexcept { return up > 0 && down > 0; }
+    double toDouble() const noexcept { return (double) up / (double) down; }
+    juce::String toString() const { return juce::String(up) + "/" + juce::String(down); }
+};
+
+// ==========================================================
+//  Tabla polifasica: L fases x T taps (T multiplo de 8).
+//  SampleType = float o double (ruta de precision doble).
+// ==========================================================
+/** Tabla exacta mas grande que se usa tal cual (una L2 tipica); por
+    encima, modo compacto con hzCompactTableBytes como tope. Con la
+    tabla en cache el modo compacto cuesta ~1.5x (interpola los
+    coeficientes por salida); gana cuando la exacta sale de cache y
+    se construye 20-30x mas rapido con L grande. */
+constexpr size_t hzExactTableLimitBytes = 512 * 1024;
+constexpr size_t hzCompactTableBytes    = 256 * 1024;
+
+template <typename SampleType>
+class HZPolyphaseFilter
+{
+public:
+    /** contentBandwidth: ancho de banda util de la entrada como fraccion
+        de la frecuencia menor (B / min(in, out)); 0 = banda completa.
+        Con contenido recortado la transicion se ensancha a [B, min - B]
+        (ni alias ni imagenes caen sobre el contenido) y el kernel se
+        acorta con la misma atenuacion. */
+    HZPolyphaseFilter(HZRatio ratio, HZPreset preset, HZPhaseResponse phase = HZPhaseResponse::linear,
+                      double contentBandwidth = 0.0);
+
+    /** Bytes de la tabla de L fases, sin construirla (44100 -> 47952
+        tiene L = 1332: ~1 MB en mastering). */
+    static size_t getTableBytes(HZRatio ratio, HZPreset preset);
+
+    HZRatio getRatio() const noexcept { return ratio; }
+    int getNumPhases() const noexcept { return ratio.up; }
+    int getNumTaps() const noexcept { return numTaps; }
+
+    /** Muestras de entrada posteriores a la posicion de salida que usa
+        el kernel (T/2 en fase lineal, 0 en fase minima). */
+    int getLookahead() const noexcept { return lookahead; }
+
+    /** Retardo de grupo en DC, en muestras de entrada (0 en fase lineal). */
+    double getGroupDelay() const noexcept { return groupDelay; }
+
+    /** Coeficientes de la fase p, en el mismo orden que el historial. */
+    const SampleType* getPhase(int p) const noexcept
+    {
+        return coeffs.data() + (size_t) p * (size_t) numTaps;
+    }
+
+private:
+    HZRatio ratio;
+    int numTaps = 0;
+    int lookahead = 0;
+    double groupDelay = 0.0;
+    std::vector<SampleType> coeffs;
+};
+
+// ==========================================================
+//  Tabla interpolada para ratios arbitrarios (ASRC): P + 1
+//  fases equiespaciadas en [0, 1]; la fase de una posicion
+//  fraccionaria se obtiene interpolando linealmente entre
+//  las dos vecinas. P depende del preset.
+//
+//  Con maxTableBytes la tabla se acota (P baja hasta que
+//  entra): es el modo compacto para ratios racionales cuya
+//  tabla exacta de L fases no cabe en cache.
+// ==========================================================
+template <typename SampleType>
+class HZVariablePolyphaseFilter
+{
+public:
+    /** nominalRatio = salida/entrada; fija el corte del kernel.
+        maxTableBytes = 0: sin limite (P del preset).
+        contentBandwidth: como en HZPolyphaseFilter. */
+    HZVariablePolyphaseFilter(double nominalRatio, HZPreset preset, size_t maxTableBytes = 0,
+                              double contentBandwidth = 0.0);
+
+    int getNumPhases() const noexcept { return numPhases; }
+    int getNumTaps() const noexcept { return numTaps; }
+
+    /** Fase p en [0, P] (la P es la fase 0 desplazada una muestra). */
+    const SampleType* getPhase(int p) const noexcept
+    {
+        return coeffs.data() + (size_t) p * (size_t) numTaps;
+    }
+
+private:
+    int numPhases = 0;
+    int numTaps = 0;
+    std::vector<SampleType> coeffs;
+};
+
+// ==========================================================
+//  Historial de entrada por canal, direccionado por indice
+//  absoluto de frame (compartido por ambos motores).
+//
+//  Cada push barre el bloque (SIMD, desde el final) y lleva
+//  donde empieza el tramo final de silencio digital: una
+//  ventana del kernel que cae entera ahi da +0 exacto y los
+//  motores la escriben sin convolucion.
+// ==========================================================
+template <typename SampleType>
+class HZInputHistory
+{
+public:
+    explicit HZInputHistory(int numChannels);
+
+    /** Vacia el historial con numLeadingZeros ceros antes del frame 0. */
+    void reset(int numLeadingZeros);
+
+    /** input == nullptr agrega ceros. */
+    void push(const SampleType* const* input, int numFrames);
+
+    /** Libera los frames anteriores a firstNeeded. */
+    void discardBefore(juce::int64 firstNeeded);
+
+    juce::int64 getEnd() const noexcept { return start + size; }
+
+    /** Desde este indice hasta getEnd() todos los canales son ceros
+        (bit a bit: -0 no cuenta como silencio). */
+    juce::int64 getSilenceStart() const noexcept { return silenceStart; }
+
+    const SampleType* getPointer(int channel, juce::int64 index) const noexcept
+    {
+        return data[(size_t) channel].data() + (index - start);
+    }
+
+private:
+    std::vector<std::vector<SampleType>> data;
+    juce::int64 start = 0;   // indice absoluto de data[ch][0]
+    int size = 0;
+    juce::int64 silenceStart = 0;
+};
+
+// ==========================================================
+//  Resampler en streaming multicanal
+//
+//  La salida n se calcula a partir de la posicion exacta
+//  n * M / L (aritmetica entera), con el kernel centrado:
+//  no hay desplazamiento temporal entre entrada y salida.
+//
+//  Cada muestra de salida depende solo de su indice absoluto
+//  y de la ISA del producto escalar, no del tamaño de bloque
+//  ni de como se reparte el trabajo entre hilos.
+// ==========================================================
+template <typename SampleType>
+class HZResamplerEngine
+{
+public:
+    HZResamplerEngine(const HZPolyphaseFilter<SampleType>& filter, int numChannels, HZKernelVariant variant);
+
+    void reset();
+
+    /** Reparte cada produce() entre los hilos del pool (nullptr = un solo hilo). */
+    void setThreadPool(juce::ThreadPool* pool) noexcept { threadPool = pool; }
+
+    /** Agrega entrada (planar). */
+    void pushInput(const SampleType* const* input, int numFrames);
+
+    /** Agrega ceros; al final del archivo usar getFlushLength(). */
+    void pushSilence(int numFrames);
+
+    /** Genera hasta maxFrames con la entrada disponible. Devuelve los frames generados. */
+    int produce(SampleType* const* output, int maxFrames);
+
+    int getFlushLength() const noexcept { return lookahead; }
+    int getNumChannels() const noexcept { return numChannels; }
+    HZKernelVariant getVariant() const noexcept { return variant; }
+
+    /** Frames de entrada que conviene leer por cada bloque de salida. */
+    int getInputBlockSize() const noexcept;
+
+private:
+    using DotFunction = SampleType (*)(const SampleType*, const SampleType*, int) noexcept;
+
+    const HZPolyphaseFilter<SampleType>& filter;
+    const int numChannels;
+    const HZKernelVariant variant;
+    const int numTaps, lookahead;
+    const int pastTaps;              // taps en o antes de la posicion: T - lookahead
+    const int stepWhole, stepFrac;   // M = stepWhole * L + stepFrac
+    DotFunction dot = nullptr;
+    juce::ThreadPool* threadPool = nullptr;
+
+    HZInputHistory<SampleType> history;
+    juce::int64 nextOutput = 0;     // indice absoluto de la proxima salida
+
+    void positionOf(juce::int64 n, juce::int64& base, int& phase) const noexcept;
+    void discardConsumed();
+    int countAvailable(int maxFrames) const noexcept;
+    void processRange(SampleType* const* output, int first, int last) const noexcept;
+};
+
+// ==========================================================
+//  Resampler de ratio variable (ASRC)
+//
+//  Para ratios no racionales o que cambian con el tiempo
+//  (deriva de reloj, pull-up/pull-down de video). La posicion
+//  de entrada avanza inputStep frames por salida; el paso
+//  puede cambiar con una rampa lineal sin saltos de fase.
+//
+//  Por salida se interpolan los coeficientes una vez y se
+//  reutilizan en todos los canales: coste T * (1 + canales),
+//  contra T * canales del motor racional. El layout de la
+//  variante no aplica (siempre frame a frame).
+//
+//  Las posiciones se acumulan en secuencia antes de repartir
+//  el bloque entre hilos, asi el resultado no depende del
+//  numero de hilos ni del tamaño de bloque.
+//
+//  Con un HZRatio el paso es exacto (M/L en aritmetica
+//  entera, como el motor racional) y solo los coeficientes
+//  salen de la tabla interpolada: modo compacto.
+// ==========================================================
+template <typename SampleType>
+class HZVariableResamplerEngine
+{
+public:
+    HZVariableResamplerEngine(const HZVariablePolyphaseFilter<SampleType>& filter, int numChannels,
+                              HZKernelVariant variant, double inputStep);
+
+    /** Paso racional fijo: la salida n cae en n * M / L exacto. */
+    HZVariableResamplerEngine(const HZVariablePolyphaseFilter<SampleType>& filter, int numChannels,
+                              HZKernelVariant variant, HZRatio ratio);
+
+    void reset();
+
+    void setThreadPool(juce::ThreadPool* pool) noexcept { threadPool = pool; }
+
+    /** Nuevo paso (frames de entrada por frame de salida), alcanzado
+        linealmente en rampFrames salidas (0 = inmediato). No aplica
+        con paso racional. */
+    void setInputStep(double newStep, juce::int64 rampFrames = 0) noexcept;
+
+    double getInputStep() const noexcept { return step; }
+
+    void pushInput(const SampleType* const* input, int numFrames);
+    void pushSilence(int numFrames);
+    int produce(SampleType* const* output, int maxFrames);
+
+    int getFlushLength() const noexcept { return halfTaps; }
+    int getNumChannels() const noexcept { return numChannels; }
+    HZKernelVariant getVariant() const noexcept { return variant; }
+    int getInputBlockSize() const noexcept;
+
+private:
+    using DotFunction = SampleType (*)(const SampleType*, const SampleType*, int) noexcept;
+
+    struct Position
+    {
+        juce::int64 base;   // indice de entrada entero
+        int phase;          // fase inferior de la tabla
+        SampleType weight;  // peso de la fase superior
+    };
+
+    const HZVariablePolyphaseFilter<SampleType>& filter;
+    const int numChannels;
+    const HZKernelVariant variant;
+    const int numTaps, halfTaps;
+    DotFunction dot = nullptr;
+    juce::ThreadPool* threadPool = nullptr;
+
+    HZInputHistory<SampleType> history;
+
+    // Posicion de la proxima salida = base + frac
+    // (paso racional: base + remainder / L)
+    juce::int64 base = 0;
+    double frac = 0.0;
+    const HZRatio exactRatio;       // up = 0 sin paso racional
+    int remainder = 0;
+    const double initialStep;
+    double step = 1.0, targetStep = 1.0, stepDelta = 0.0;
+    juce::int64 rampRemaining = 0;
+
+    std::vector<Position> positions;
+    std::vector<SampleType> scratch;   // coeficientes interpolados, uno por tramo
+
+    void processRange(SampleType* const* output, int first, int last, SampleType* coeffs) const noexcept;
+};
+
+// ==========================================================
+//  Ratios 2^k (48k <-> 96k, 44.1k <-> 88.2k, 96k <-> 192k)
+//
+//  Cascada de etapas halfband x2. En un halfband todos los
+//  taps pares son cero salvo el central, asi que:
+//   - interpolar: la salida par es la entrada tal cual y la
+//     impar un producto escalar con solo los 2K taps impares;
+//   - diezmar: la entrada se separa en pares e impares y cada
+//     salida es 0.5 * (par + dot(impares, g)).
+//  Usa el mismo producto escalar (y la misma ISA) que el
+//  motor general; la salida n cae en la misma posicion n*M/L.
+//  Cada etapa se diseña para la banda que le llega: la mas
+//  exigente es la de menor frecuencia.
+// ==========================================================
+template <typename SampleType>
+class HZHalfbandResamplerEngine
+{
+public:
+    /** ratio = 2^k / 1 o 1 / 2^k (ver supportsRatio). contentBandwidth
+        como en HZPolyphaseFilter: por debajo de la banda de paso del
+        preset, la transicion de las etapas se ensancha hasta B. */
+    HZHalfbandResamplerEngine(HZRatio ratio, HZPreset preset, int numChannels, HZKernelVariant variant,
+                              double contentBandwidth = 0.0);
+    ~HZHalfbandResamplerEngine();
+
+    static bool supportsRatio(HZRatio ratio) noexcept;
+
+    void reset();
+
+    void setThreadPool(juce::ThreadPool* pool) noexcept { threadPool = pool; }
+
+    void pushInput(const SampleType* const* input, int numFrames);
+
+    /** Al final del archivo: ceros de cola y a partir de ahi la salida
+        se corta en ceil(N_in * L / M), igual que el motor general. */
+    void pushSilence(int numFrames);
+
+    int produce(SampleType* const* output, int maxFrames);
+
+    int getFlushLength() const noexcept { return flushLength; }
+    int getNumChannels() const noexcept { return numChannels; }
+    HZKernelVariant getVariant() const noexcept { return variant; }
+    int getInputBlockSize() const noexcept;
+
+    int getNumStages() const noexcept { return (int) stages.size(); }
+
+    /** Taps distintos de cero (los que se multiplican) de la etapa s. */
+    int getStageTaps(int stage) const noexcept;
+
+private:
+    struct Stage;
+
+    const HZRatio ratio;
+    const int numChannels;
+    const HZKernelVariant variant;
+    juce::ThreadPool* threadPool = nullptr;
+
+    std::vector<std::unique_ptr<Stage>> stages;
+    std::vector<std::vector<std::vector<SampleType>>> between;   // salida de cada etapa intermedia
+    int flushLength = 0;
+
+    juce::int64 inputFrames = 0;    // entrada real (sin la cola de ceros)
+    juce::int64 outputFrames = 0;
+    bool flushed = false;
+};
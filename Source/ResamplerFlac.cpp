@@ -0,0 +1,2131 @@
+#include "ResamplerFlac.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#if JUCE_MSVC
+ #include <intrin.h>
+#endif
+
+namespace
+{
+    constexpr int frameSamples      = 4096;
+    constexpr int framesPerThread   = 4;     // frames por hilo en cada lote
+    constexpr int maxFixedOrder     = 4;
+    constexpr int maxLpcOrder       = 8;
+    constexpr int maxPartitionOrder = 8;
+    constexpr int maxChannels       = 8;
+
+    // ------------------------------------------------------
+    //  CRC del frame: 8 bits sobre la cabecera (x^8+x^2+x+1)
+    //  y 16 bits sobre el frame entero (x^16+x^15+x^2+1), de
+    //  a 8 bytes: crc16[k] es un byte seguido de k ceros
+    // ------------------------------------------------------
+    struct CrcTables
+    {
+        juce::uint8 crc8[256];
+        juce::uint16 crc16[8][256];
+
+        CrcTables() noexcept
+        {
+            for (juce::uint32 i = 0; i < 256; ++i)
+            {
+                juce::uint32 c8 = i, c16 = i << 8;
+
+                for (int b = 0; b < 8; ++b)
+                {
+                    c8  = (c8 & 0x80) != 0 ? (c8 << 1) ^ 0x07 : c8 << 1;
+                    c16 = (c16 & 0x8000) != 0 ? (c16 << 1) ^ 0x8005 : c16 << 1;
+                }
+
+                crc8[i]     = (juce::uint8) c8;
+                crc16[0][i] = (juce::uint16) c16;
+            }
+
+            for (int k = 1; k < 8; ++k)
+                for (int i = 0; i < 256; ++i)
+                    crc16[k][i] = (juce::uint16) ((crc16[k - 1][i] << 8) ^ crc16[0][crc16[k - 1][i] >> 8]);
+        }
+    };
+
+    const CrcTables& getCrcTables() noexcept
+    {
+        static const CrcTables tables;
+        return tables;
+    }
+
+    juce::uint8 computeCrc8(const juce::uint8* data, size_t numBytes) noexcept
+    {
+        const auto& tables = getCrcTables();
+        juce::uint8 crc = 0;
+
+        for (size_t i = 0; i < numBytes; ++i)
+            crc = tables.crc8[crc ^ data[i]];
+
+        return crc;
+    }
+
+    juce::uint16 computeCrc16(const juce::uint8* data, size_t numBytes) noexcept
+    {
+        const auto& t = getCrcTables().crc16;
+        juce::uint32 crc = 0;
+
+        for (; numBytes >= 8; data += 8, numBytes -= 8)
+        {
+            crc ^= (juce::uint32) ((data[0] << 8) | data[1]);
+            crc = (juce::uint32) (t[7][crc >> 8] ^ t[6][crc & 0xff] ^ t[5][data[2]] ^ t[4][data[3]]
+                                ^ t[3][data[4]] ^ t[2][data[5]] ^ t[1][data[6]] ^ t[0][data[7]]);
+        }
+
+        for (size_t i = 0; i < numBytes; ++i)
+            crc = ((crc << 8) ^ t[0][(crc >> 8) ^ data[i]]) & 0xffff;
+
+        return (juce::uint16) crc;
+    }
+
+    // ------------------------------------------------------
+    //  Escritura de bits (MSB primero) en un buffer que ya
+    //  tiene el tamaño maximo del frame: de a 32 bits
+    // ------------------------------------------------------
+    class BitWriter
+    {
+    public:
+        explicit BitWriter(juce::uint8* dest) noexcept : out(dest) {}
+
+        /** numBits <= 32 */
+        void put(juce::uint32 value, int numBits) noexcept
+        {
+            if (numBits == 0)
+                return;
+
+            const auto mask = numBits == 32 ? 0xffffffffu : (1u << numBits) - 1;
+            accumulator = (accumulator << numBits) | (value & mask);
+            used += numBits;
+
+            if (used >= 32)
+            {
+                used -= 32;
+                const auto word = (juce::uint32) (accumulator >> used);
+                out[0] = (juce::uint8) (word >> 24);
+                out[1] = (juce::uint8) (word >> 16);
+                out[2] = (juce::uint8) (word >> 8);
+                out[3] = (juce::uint8) word;
+                out += 4;
+            }
+        }
+
+        void putSigned(int value, int numBits) noexcept { put((juce::uint32) value, numBits); }
+
+        /** q = u >> k en unario (q ceros y un 1) y los k bits bajos. */
+        void putRice(juce::uint32 u, int k) noexcept
+        {
+            auto q = u >> k;
+
+            for (; q >= 32; q -= 32)
+                put(0, 32);
+
+            const auto low = u & ((1u << k) - 1);
+
+            if ((int) q + 1 + k <= 32)
+            {
+                put((1u << k) | low, (int) q + 1 + k);
+            }
+            else
+            {
+                put(1, (int) q + 1);
+                put(low, k);
+            }
+        }
+
+        /** Completa el byte con ceros; devuelve el final de lo escrito. */
+        juce::uint8* flush() noexcept
+        {
+            if ((used & 7) != 0)
+                put(0, 8 - (used & 7));
+
+            for (; used >= 8; out++)
+            {
+                used -= 8;
+                *out = (juce::uint8) (accumulator >> used);
+            }
+
+            return out;
+        }
+
+    private:
+        juce::uint8* out;
+        juce::uint64 accumulator = 0;
+        int used = 0;
+    };
+
+    // ------------------------------------------------------
+    //  Subframe elegido para un canal (o el lado / medio)
+    // ------------------------------------------------------
+    struct Subframe
+    {
+        enum class Type { constant, verbatim, fixed, lpc };
+
+        Type type = Type::verbatim;
+        int order = 0;
+        int precision = 0, shift = 0;
+        int coefs[maxLpcOrder] {};
+
+        int partitionOrder = 0;
+        bool wideParams = false;          // metodo 1: parametros Rice de 5 bits
+        int riceParams[1 << maxPartitionOrder] {};
+
+        juce::int64 bits = 0;             // tamaño total, cabecera incluida
+        const int* residual = nullptr;    // n - order valores
+    };
+
+    // Buffers de un hilo: se reusan entre frames
+    struct Scratch
+    {
+        std::vector<int> channels[maxChannels];   // justificado a la derecha
+        std::vector<int> side, mid;
+        std::vector<int> residual[maxChannels];    // uno por subframe candidato
+        std::vector<int> trial;                     // residuo del LPC en prueba
+        std::vector<juce::uint32> folded;
+        std::vector<juce::uint64> sums;
+        std::vector<double> windowed;
+
+        void prepare()
+        {
+            if (! folded.empty())
+                return;
+
+            for (auto& c : channels)
+                c.resize((size_t) frameSamples);
+
+            for (auto& r : residual)
+                r.resize((size_t) frameSamples);
+
+            trial.resize((size_t) frameSamples);
+            side.resize((size_t) frameSamples);
+            mid.resize((size_t) frameSamples);
+            folded.resize((size_t) frameSamples);
+            sums.resize((size_t) 1 << maxPartitionOrder);
+            windowed.resize((size_t) frameSamples);
+        }
+    };
+
+    // ------------------------------------------------------
+    //  Residuo en Rice particionado: el orden de particion y
+    //  los parametros salen de la suma de cada particion
+    //  (n * (k + 1) + suma >> k); los bits devueltos son los
+    //  exactos con esos parametros.
+    // ------------------------------------------------------
+    int chooseRiceParameter(juce::uint64 sum, int count, juce::int64& estimate) noexcept
+    {
+        int k = 0;
+
+        if (count > 0)
+            while (k < 30 && ((juce::uint64) count << (k + 1)) <= sum)
+                ++k;
+
+        estimate = (juce::int64) count * (k + 1) + (juce::int64) (sum >> k);
+
+        // La estimacion por suma favorece un k menos
+        if (k > 0)
+        {
+            const auto lower = (juce::int64) count * k + (juce::int64) (sum >> (k - 1));
+
+            if (lower < estimate)
+            {
+                estimate = lower;
+                --k;
+            }
+        }
+
+        return k;
+    }
+
+    juce::int64 planResidual(const int* residual, int blockSize, int order, Subframe& sf, Scratch& scratch)
+    {
+        const int count = blockSize - order;
+        auto* folded = scratch.folded.data();
+
+        for (int i = 0; i < count; ++i)
+            folded[i] = ((juce::uint32) residual[i] << 1) ^ (juce::uint32) (residual[i] >> 31);
+
+        int maxOrder = maxPartitionOrder;
+
+        while (maxOrder > 0 && ((blockSize & ((1 << maxOrder) - 1)) != 0 || (blockSize >> maxOrder) <= order))
+            --maxOrder;
+
+        // Sumas en el orden mas fino; los mas gruesos se arman de a pares
+        auto* sums = scratch.sums.data();
+        const int finest = blockSize >> maxOrder;
+
+        for (int p = 0, start = 0; p < (1 << maxOrder); ++p)
+        {
+            const int end = (p + 1) * finest - order;
+            juce::uint64 sum = 0;
+
+            for (int i = start; i < end; ++i)
+                sum += folded[i];
+
+            sums[p] = sum;
+            start = end;
+        }
+
+        juce::int64 bestBits = std::numeric_limits<juce::int64>::max();
+        int params[1 << maxPartitionOrder];
+
+        for (int partitionOrder = maxOrder; partitionOrder >= 0; --partitionOrder)
+        {
+            const int numPartitions = 1 << partitionOrder;
+            const int partitionSize = blockSize >> partitionOrder;
+            juce::int64 bits = 0;
+            bool wide = false;
+
+            for (int p = 0; p < numPartitions; ++p)
+            {
+                juce::int64 estimate;
+                params[p] = chooseRiceParameter(sums[p], partitionSize - (p == 0 ? order : 0), estimate);
+                bits += estimate;
+                wide = wide || params[p] > 14;
+            }
+
+            bits += 6 + (juce::int64) numPartitions * (wide ? 5 : 4);
+
+            if (bits < bestBits)
+            {
+                bestBits = bits;
+                sf.partitionOrder = partitionOrder;
+                sf.wideParams = wide;
+                std::copy(params, params + numPartitions, sf.riceParams);
+            }
+
+            for (int p = 0; p < numPartitions / 2; ++p)
+                sums[p] = sums[2 * p] + sums[2 * p + 1];
+        }
+
+        // Bits exactos con los parametros elegidos
+        const int numPartitions = 1 << sf.partitionOrder;
+        const int partitionSize = blockSize >> sf.partitionOrder;
+        juce::int64 bits = 6 + (juce::int64) numPartitions * (sf.wideParams ? 5 : 4);
+
+        for (int p = 0, start = 0; p < numPartitions; ++p)
+        {
+            const int end = (p + 1) * partitionSize - order;
+            const int k = sf.riceParams[p];
+            juce::int64 quotients = 0;
+
+            for (int i = start; i < end; ++i)
+                quotients += folded[i] >> k;
+
+            bits += quotients + (juce::int64) (end - start) * (k + 1);
+            start = end;
+        }
+
+        return bits;
+    }
+
+    // ------------------------------------------------------
+    //  Predictor fijo: el orden con menor suma de |residuo|.
+    //  Con 25 bits como mucho (el lado de 24 bits) el residuo
+    //  de orden 4 entra en 29: todo en int32
+    // ------------------------------------------------------
+    int chooseFixedOrder(const int* x, int n) noexcept
+    {
+        juce::uint64 sums[maxFixedOrder + 1] {};
+
+        if (n <= maxFixedOrder)
+            return 0;
+
+        for (int i = maxFixedOrder; i < n; ++i)
+        {
+            const int e0 = x[i];
+            const int e1 = x[i] - x[i - 1];
+            const int e2 = x[i] - 2 * x[i - 1] + x[i - 2];
+            const int e3 = x[i] - 3 * x[i - 1] + 3 * x[i - 2] - x[i - 3];
+            const int e4 = x[i] - 4 * x[i - 1] + 6 * x[i - 2] - 4 * x[i - 3] + x[i - 4];
+
+            sums[0] += (juce::uint32) std::abs(e0);
+            sums[1] += (juce::uint32) std::abs(e1);
+            sums[2] += (juce::uint32) std::abs(e2);
+            sums[3] += (juce::uint32) std::abs(e3);
+            sums[4] += (juce::uint32) std::abs(e4);
+        }
+
+        return (int) (std::min_element(sums, sums + maxFixedOrder + 1) - sums);
+    }
+
+    void computeFixedResidual(const int* x, int n, int order, int* residual) noexcept
+    {
+        auto* r = residual - order;
+
+        switch (order)
+        {
+            case 0:  std::copy(x, x + n, r); break;
+            case 1:  for (int i = 1; i < n; ++i) r[i] = x[i] - x[i - 1]; break;
+            case 2:  for (int i = 2; i < n; ++i) r[i] = x[i] - 2 * x[i - 1] + x[i - 2]; break;
+            case 3:  for (int i = 3; i < n; ++i) r[i] = x[i] - 3 * x[i - 1] + 3 * x[i - 2] - x[i - 3]; break;
+            default: for (int i = 4; i < n; ++i) r[i] = x[i] - 4 * x[i - 1] + 6 * x[i - 2] - 4 * x[i - 3] + x[i - 4]; break;
+        }
+    }
+    // ------------------------------------------------------
+    //  LPC: autocorrelacion con ventana de Tukey (0.5),
+    //  Levinson-Durbin y el orden con menos bits estimados
+    //  por el error de prediccion. Los coeficientes se
+    //  cuantizan como en libFLAC (precision segun bits y
+    //  tamaño de bloque, error arrastrado entre coeficientes).
+    // ------------------------------------------------------
+    int getLpcPrecision(int bitsPerSample, int blockSize) noexcept
+    {
+        if (bitsPerSample < 16)
+            return juce::jmax(5, 2 + bitsPerSample / 2);
+
+        if (bitsPerSample == 16)
+        {
+            if (blockSize <= 192)  return 7;
+            if (blockSize <= 384)  return 8;
+            if (blockSize <= 576)  return 9;
+            if (blockSize <= 1152) return 10;
+            if (blockSize <= 2304) return 11;
+            if (blockSize <= 4608) return 12;
+            return 13;
+        }
+
+        return blockSize <= 384 ? 13 : (blockSize <= 1152 ? 14 : 15);
+    }
+
+    void fillTukeyWindow(double* window, int n) noexcept
+    {
+        const int taper = n / 4;   // Tukey 0.5: un cuarto del bloque en cada punta
+
+        for (int i = 0; i < n; ++i)
+        {
+            window[i] = 1.0;
+
+            if (i < taper)
+                window[i] = 0.5 - 0.5 * std::cos(juce::MathConstants<double>::pi * i / taper);
+            else if (i >= n - taper)
+                window[i] = 0.5 - 0.5 * std::cos(juce::MathConstants<double>::pi * (n - 1 - i) / taper);
+        }
+    }
+
+    bool computeLpc(const int* x, int n, int bitsPerSample, Subframe& sf, Scratch& scratch)
+    {
+        // La ventana del bloque completo se calcula una vez; la del ultimo
+        // frame (mas corto) en el momento
+        static const auto fullWindow = []
+        {
+            std::vector<double> w((size_t) frameSamples);
+            fillTukeyWindow(w.data(), frameSamples);
+            return w;
+        }();
+
+        auto* windowed = scratch.windowed.data();
+
+        if (n != frameSamples)
+            fillTukeyWindow(windowed, n);
+
+        const auto* window = n == frameSamples ? fullWindow.data() : windowed;
+
+        for (int i = 0; i < n; ++i)
+            windowed[i] = x[i] * window[i];
+
+        // Todos los lags en la misma pasada (acumuladores independientes)
+        double autoc[maxLpcOrder + 1] {};
+
+        for (int i = 0; i < maxLpcOrder; ++i)
+            for (int lag = 0; lag <= i; ++lag)
+                autoc[lag] += windowed[i] * windowed[i - lag];
+
+        for (int i = maxLpcOrder; i < n; ++i)
+            for (int lag = 0; lag <= maxLpcOrder; ++lag)
+                autoc[lag] += windowed[i] * windowed[i - lag];
+
+        if (autoc[0] <= 0.0)
+            return false;
+
+        // Levinson-Durbin: coeficientes y error de cada orden
+        double lpc[maxLpcOrder] {}, coefsByOrder[maxLpcOrder][maxLpcOrder] {}, error[maxLpcOrder] {};
+        double err = autoc[0];
+        int maxOrder = maxLpcOrder;
+
+        for (int i = 0; i < maxLpcOrder; ++i)
+        {
+            double r = -autoc[i + 1];
+
+            for (int j = 0; j < i; ++j)
+                r -= lpc[j] * autoc[i - j];
+
+            r /= err;
+            lpc[i] = r;
+
+            int j = 0;
+
+            for (; j < (i >> 1); ++j)
+            {
+                const double tmp = lpc[j];
+                lpc[j] += r * lpc[i - 1 - j];
+                lpc[i - 1 - j] += r * tmp;
+            }
+
+            if ((i & 1) != 0)
+                lpc[j] += lpc[j] * r;
+
+            err *= 1.0 - r * r;
+
+            for (j = 0; j <= i; ++j)
+                coefsByOrder[i][j] = -lpc[j];
+
+            error[i] = err;
+
+            if (err <= 0.0)
+            {
+                maxOrder = i + 1;
+                break;
+            }
+        }
+
+        const int precision = getLpcPrecision(bitsPerSample, n);
+        int order = 1;
+        double bestBits = std::numeric_limits<double>::max();
+
+        for (int o = 1; o <= juce::jmin(maxOrder, n - 1); ++o)
+        {
+            const int count = n - o;
+            const double perSample = error[o - 1] > 0.0
+                                       ? juce::jmax(0.0, 0.5 * std::log2(0.5 * error[o - 1] / count))
+                                       : 0.0;
+            const double bits = perSample * count + o * (precision + bitsPerSample);
+
+            if (bits < bestBits)
+            {
+                bestBits = bits;
+                order = o;
+            }
+        }
+
+        // Cuantizacion: shift para que el mayor coeficiente use la precision
+        const auto* coefs = coefsByOrder[order - 1];
+        double cmax = 0.0;
+
+        for (int i = 0; i < order; ++i)
+            cmax = juce::jmax(cmax, std::abs(coefs[i]));
+
+        if (cmax <= 0.0)
+            return false;
+
+        int log2cmax;
+        std::frexp(cmax, &log2cmax);
+
+        const int shift = juce::jmin(15, precision - 1 - (log2cmax - 1) - 1);
+
+        if (shift < 0)
+            return false;
+
+        const int qmax = (1 << (precision - 1)) - 1;
+        double carried = 0.0;
+
+        for (int i = 0; i < order; ++i)
+        {
+            carried += coefs[i] * (double) (1 << shift);
+            const int q = juce::jlimit(-qmax - 1, qmax, (int) std::lround(carried));
+            carried -= q;
+            sf.coefs[i] = q;
+        }
+
+        sf.order = order;
+        sf.precision = precision;
+        sf.shift = shift;
+        return true;
+    }
+
+    // Con bits + precision + log2(orden) <= 32 la suma entra en int32 (como
+    // en libFLAC); si no, en int64. El orden fijo deja desenrollar la suma
+    template <int order, typename Accumulator>
+    void predictLpc(const int* x, int n, const int* coefs, int shift, int* residual,
+                    juce::int64& lowest, juce::int64& highest) noexcept
+    {
+        for (int i = order; i < n; ++i)
+        {
+            Accumulator sum = 0;
+
+            for (int j = 0; j < order; ++j)
+                sum += (Accumulator) coefs[j] * x[i - 1 - j];
+
+            const auto e = (juce::int64) x[i] - (juce::int64) (sum >> shift);
+            residual[i - order] = (int) e;
+            lowest  = juce::jmin(lowest, e);
+            highest = juce::jmax(highest, e);
+        }
+    }
+
+    template <typename Accumulator>
+    void predictLpc(const int* x, int n, const Subframe& sf, int* residual,
+                    juce::int64& lowest, juce::int64& highest) noexcept
+    {
+        switch (sf.order)
+        {
+            case 1:  predictLpc<1, Accumulator>(x, n, sf.coefs, sf.shift, residual, lowest, highest); break;
+            case 2:  predictLpc<2, Accumulator>(x, n, sf.coefs, sf.shift, residual, lowest, highest); break;
+            case 3:  predictLpc<3, Accumulator>(x, n, sf.coefs, sf.shift, residual, lowest, highest); break;
+            case 4:  predictLpc<4, Accumulator>(x, n, sf.coefs, sf.shift, residual, lowest, highest); break;
+            case 5:  predictLpc<5, Accumulator>(x, n, sf.coefs, sf.shift, residual, lowest, highest); break;
+            case 6:  predictLpc<6, Accumulator>(x, n, sf.coefs, sf.shift, residual, lowest, highest); break;
+            case 7:  predictLpc<7, Accumulator>(x, n, sf.coefs, sf.shift, residual, lowest, highest); break;
+            default: predictLpc<8, Accumulator>(x, n, sf.coefs, sf.shift, residual, lowest, highest); break;
+        }
+    }
+
+    bool computeLpcResidual(const int* x, int n, int bitsPerSample, const Subframe& sf, int* residual) noexcept
+    {
+        juce::int64 lowest = 0, highest = 0;
+
+        if (bitsPerSample + sf.precision + juce::findHighestSetBit((juce::uint32) sf.order) + 1 <= 32)
+            predictLpc<int>(x, n, sf, residual, lowest, highest);
+        else
+            predictLpc<juce::int64>(x, n, sf, residual, lowest, highest);
+
+        // El residuo tiene que entrar en 32 bits con signo
+        return lowest > std::numeric_limits<int>::min() && highest <= std::numeric_limits<int>::max();
+    }
+
+    // ------------------------------------------------------
+    //  Mejor subframe para una señal: constante, fijo o LPC
+    //  (bits exactos de cada uno), verbatim si ninguno gana
+    // ------------------------------------------------------
+    void analyzeSubframe(const int* x, int n, int bitsPerSample, Subframe& sf, int* residual, int* trial,
+                         Scratch& scratch)
+    {
+        if (std::all_of(x + 1, x + n, [x](int v) { return v == x[0]; }))
+        {
+            sf.type = Subframe::Type::constant;
+            sf.order = 0;
+            sf.bits = 8 + bitsPerSample;
+            return;
+        }
+
+        sf.type = Subframe::Type::verbatim;
+        sf.order = 0;
+        sf.bits = 8 + (juce::int64) bitsPerSample * n;
+
+        if (n <= maxFixedOrder)
+            return;
+
+        Subframe fixed;
+        fixed.type = Subframe::Type::fixed;
+        fixed.order = chooseFixedOrder(x, n);
+        computeFixedResidual(x, n, fixed.order, residual);
+        fixed.bits = 8 + (juce::int64) fixed.order * bitsPerSample + planResidual(residual, n, fixed.order, fixed, scratch);
+        fixed.residual = residual;
+
+        if (fixed.bits < sf.bits)
+            sf = fixed;
+
+        if (n <= 4 * maxLpcOrder)
+            return;
+
+        Subframe lpc;
+        lpc.type = Subframe::Type::lpc;
+
+        if (computeLpc(x, n, bitsPerSample, lpc, scratch) && computeLpcResidual(x, n, bitsPerSample, lpc, trial))
+        {
+            lpc.bits = 8 + (juce::int64) lpc.order * bitsPerSample + 4 + 5 + (juce::int64) lpc.order * lpc.precision
+                         + planResidual(trial, n, lpc.order, lpc, scratch);
+
+            if (lpc.bits < sf.bits)
+            {
+                // El residuo ganador queda en el buffer del subframe
+                std::copy(trial, trial + (n - lpc.order), residual);
+                lpc.residual = residual;
+                sf = lpc;
+            }
+        }
+    }
+
+    void writeSubframe(BitWriter& bits, const Subframe& sf, const int* x, int n, int bitsPerSample)
+    {
+        bits.put(0, 1);
+
+        switch (sf.type)
+        {
+            case Subframe::Type::constant:
+                bits.put(0, 6);
+                bits.put(0, 1);
+                bits.putSigned(x[0], bitsPerSample);
+                return;
+
+            case Subframe::Type::verbatim:
+                bits.put(1, 6);
+                bits.put(0, 1);
+
+                for (int i = 0; i < n; ++i)
+                    bits.putSigned(x[i], bitsPerSample);
+
+                return;
+
+            case Subframe::Type::fixed:
+                bits.put((juce::uint32) (8 | sf.order), 6);
+                bits.put(0, 1);
+
+                for (int i = 0; i < sf.order; ++i)
+                    bits.putSigned(x[i], bitsPerSample);
+
+                break;
+
+            case Subframe::Type::lpc:
+                bits.put((juce::uint32) (32 | (sf.order - 1)), 6);
+                bits.put(0, 1);
+
+                for (int i = 0; i < sf.order; ++i)
+                    bits.putSigned(x[i], bitsPerSample);
+
+                bits.put((juce::uint32) (sf.precision - 1), 4);
+                bits.putSigned(sf.shift, 5);
+
+                for (int i = 0; i < sf.order; ++i)
+                    bits.putSigned(sf.coefs[i], sf.precision);
+
+                break;
+        }
+
+        // Residuo: metodo, orden de particion y cada particion con su parametro
+        bits.put(sf.wideParams ? 1 : 0, 2);
+        bits.put((juce::uint32) sf.partitionOrder, 4);
+
+        const int partitionSize = n >> sf.partitionOrder;
+
+        for (int p = 0, start = 0; p < (1 << sf.partitionOrder); ++p)
+        {
+            const int end = (p + 1) * partitionSize - sf.order;
+            const int k = sf.riceParams[p];
+            bits.put((juce::uint32) k, sf.wideParams ? 5 : 4);
+
+            for (int i = start; i < end; ++i)
+                bits.putRice(((juce::uint32) sf.residual[i] << 1) ^ (juce::uint32) (sf.residual[i] >> 31), k);
+
+            start = end;
+        }
+    }
+
+    // ------------------------------------------------------
+    //  Cabecera del frame (bloque fijo: numero de frame en
+    //  UTF-8 extendido)
+    // ------------------------------------------------------
+    int getBlockSizeCode(int n) noexcept
+    {
+        if (n == 192)
+            return 1;
+
+        for (int code = 2; code <= 5; ++code)
+            if (n == 576 << (code - 2))
+                return code;
+
+        for (int code = 8; code <= 15; ++code)
+            if (n == 256 << (code - 8))
+                return code;
+
+        return n <= 256 ? 6 : 7;
+    }
+
+    int getSampleRateCode(int rate) noexcept
+    {
+        switch (rate)
+        {
+            case 88200:  return 1;
+            case 176400: return 2;
+            case 192000: return 3;
+            case 8000:   return 4;
+            case 16000:  return 5;
+            case 22050:  return 6;
+            case 24000:  return 7;
+            case 32000:  return 8;
+            case 44100:  return 9;
+            case 48000:  return 10;
+            case 96000:  return 11;
+            default:     break;
+        }
+
+        if (rate % 1000 == 0 && rate / 1000 <= 255)
+            return 12;
+
+        if (rate <= 65535)
+            return 13;
+
+        return rate % 10 == 0 && rate / 10 <= 65535 ? 14 : 0;   // 0: el del STREAMINFO
+    }
+
+    void writeFrameHeader(std::vector<juce::uint8>& out, juce::int64 frameNumber, int n, int rate,
+                          int channelAssignment, int bitsPerSample)
+    {
+        const int blockSizeCode  = getBlockSizeCode(n);
+        const int sampleRateCode = getSampleRateCode(rate);
+
+        out.push_back(0xff);
+        out.push_back(0xf8);
+        out.push_back((juce::uint8) ((blockSizeCode << 4) | sampleRateCode));
+        out.push_back((juce::uint8) ((channelAssignment << 4) | ((bitsPerSample == 16 ? 4 : 6) << 1)));
+
+        const auto number = (juce::uint64) frameNumber;
+
+        if (number < 0x80)
+        {
+            out.push_back((juce::uint8) number);
+        }
+        else
+        {
+            int extra = 1;
+
+            while (extra < 6 && number >= (juce::uint64) 1 << (6 + 5 * extra))
+                ++extra;
+
+            out.push_back((juce::uint8) ((0xff00 >> (extra + 1)) | (number >> (6 * extra))));
+
+            for (int i = extra; --i >= 0;)
+                out.push_back((juce::uint8) (0x80 | ((number >> (6 * i)) & 0x3f)));
+        }
+
+        if (blockSizeCode == 6)
+        {
+            out.push_back((juce::uint8) (n - 1));
+        }
+        else if (blockSizeCode == 7)
+        {
+            out.push_back((juce::uint8) ((n - 1) >> 8));
+            out.push_back((juce::uint8) (n - 1));
+        }
+
+        if (sampleRateCode == 12)
+        {
+            out.push_back((juce::uint8) (rate / 1000));
+        }
+        else if (sampleRateCode >= 13)
+        {
+            const int value = sampleRateCode == 13 ? rate : rate / 10;
+            out.push_back((juce::uint8) (value >> 8));
+            out.push_back((juce::uint8) value);
+        }
+
+        out.push_back(computeCrc8(out.data(), out.size()));
+    }
+
+    // ------------------------------------------------------
+    //  Lectura: cabecera del frame. Valida todo lo que se
+    //  puede sin decodificar (los campos tienen que coincidir
+    //  con el STREAMINFO), porque tambien sirve para buscar
+    //  frames por el sync en medio del audio
+    // ------------------------------------------------------
+    struct FrameHeader
+    {
+        int blockSize = 0;
+        int channelAssignment = 0;
+        int numBytes = 0;
+        juce::int64 firstSample = 0;
+    };
+
+    bool parseFrameHeader(const juce::uint8* start, const juce::uint8* end,
+                          const HZFlacReader::StreamInfo& info, FrameHeader& header) noexcept
+    {
+        static constexpr int bitsPerSampleCodes[8] = { 0, 8, 12, 0, 16, 20, 24, 32 };
+
+        if (end - start < 6 || start[0] != 0xff || (start[1] & 0xfe) != 0xf8
+             || (start[1] & 1) != (info.variableBlockSize ? 1 : 0))
+            return false;
+
+        const int blockSizeCode    = start[2] >> 4;
+        const int sampleRateCode   = start[2] & 15;
+        const int channelCode      = start[3] >> 4;
+        const int bitsPerSampleCode = (start[3] >> 1) & 7;
+
+        if (blockSizeCode == 0 || sampleRateCode == 15 || channelCode > 10 || bitsPerSampleCode == 3
+             || (start[3] & 1) != 0)
+            return false;
+
+        if ((channelCode < 8 ? channelCode + 1 : 2) != info.numChannels
+             || (bitsPerSampleCode != 0 && bitsPerSampleCodes[bitsPerSampleCode] != info.bitsPerSample))
+            return false;
+
+        // Numero de frame (o de muestra) en UTF-8 extendido
+        const auto* p = start + 4;
+        juce::uint64 number = *p++;
+
+        if (number >= 0x80)
+        {
+            if ((number & 0xc0) == 0x80 || number == 0xff)
+                return false;
+
+            int extra = 0;
+
+            while ((number & (0x40u >> extra)) != 0)
+                ++extra;
+
+            number &= 0x3fu >> extra;
+
+            if (end - p < extra)
+                return false;
+
+            for (int i = 0; i < extra; ++i, ++p)
+            {
+                if ((*p & 0xc0) != 0x80)
+                    return false;
+
+                number = (number << 6) | (juce::uint64) (*p & 0x3f);
+            }
+        }
+
+        const int extraBytes = (blockSizeCode == 6 ? 1 : blockSizeCode == 7 ? 2 : 0)
+                             + (sampleRateCode == 12 ? 1 : sampleRateCode >= 13 ? 2 : 0);
+
+        if (end - p < extraBytes + 1)
+            return false;
+
+        int blockSize;
+
+        switch (blockSizeCode)
+        {
+            case 1:  blockSize = 192; break;
+            case 6:  blockSize = p[0] + 1; break;
+            case 7:  blockSize = ((p[0] << 8) | p[1]) + 1; break;
+            default: blockSize = blockSizeCode < 6 ? 576 << (blockSizeCode - 2) : 256 << (blockSizeCode - 8); break;
+        }
+
+        p += extraBytes;
+
+        if (computeCrc8(start, (size_t) (p - start)) != *p || blockSize > info.maxBlockSize)
+            return false;
+
+        // Bloque fijo: el numero es de frame (todos del tamaño del STREAMINFO
+        // menos el ultimo; si no lo dice, el del frame, como libFLAC)
+        const int fixedBlockSize = info.minBlockSize == info.maxBlockSize ? info.maxBlockSize : blockSize;
+        const auto firstSample = info.variableBlockSize ? (juce::int64) number
+                                                        : (juce::int64) number * fixedBlockSize;
+
+        if (number >= ((juce::uint64) 1 << 36) || firstSample + blockSize > info.totalSamples)
+            return false;
+
+        header.blockSize = blockSize;
+        header.channelAssignment = channelCode;
+        header.numBytes = (int) (p + 1 - start);
+        header.firstSample = firstSample;
+        return true;
+    }
+
+    // ------------------------------------------------------
+    //  Lectura de bits (MSB primero): cache de 64 bits, los
+    //  bits validos arriba y ceros abajo
+    // ------------------------------------------------------
+    inline int countLeadingZeros(juce::uint64 value) noexcept
+    {
+       #if JUCE_MSVC
+        unsigned long index;
+        _BitScanReverse64(&index, value);
+        return 63 - (int) index;
+       #else
+        return __builtin_clzll(value);
+       #endif
+    }
+
+    class BitReader
+    {
+    public:
+        BitReader(const juce::uint8* start, const juce::uint8* end) noexcept : next(start), limit(end) {}
+
+        /** numBits <= 32 */
+        juce::uint32 read(int numBits) noexcept
+        {
+            if (numBits == 0)
+                return 0;
+
+            if (available < numBits)
+            {
+                refill();
+
+                if (available < numBits)
+                {
+                    overrun = true;
+                    return 0;
+                }
+            }
+
+            const auto value = (juce::uint32) (cache >> (64 - numBits));
+            cache <<= numBits;
+            available -= numBits;
+            return value;
+        }
+
+        int readSigned(int numBits) noexcept
+        {
+            if (numBits == 0)
+                return 0;
+
+            return (int) (read(numBits) << (32 - numBits)) >> (32 - numBits);
+        }
+
+        /** Ceros hasta el primer 1 (que se consume) */
+        juce::uint32 readUnary() noexcept
+        {
+            juce::uint32 zeros = 0;
+
+            for (;;)
+            {
+                if (cache != 0)
+                {
+                    const int n = countLeadingZeros(cache) + 1;
+                    cache = n < 64 ? cache << n : 0;
+                    available -= n;
+                    return zeros + (juce::uint32) n - 1;
+                }
+
+                zeros += (juce::uint32) available;
+                available = 0;
+                refill();
+
+                if (available == 0)
+                {
+                    overrun = true;
+                    return 0;
+                }
+            }
+        }
+
+        /** Un valor Rice con parametro k (< 32), ya sin plegar */
+        int readRice(int k) noexcept
+        {
+            if (available < 40)
+                refill();
+
+            // Camino corto: cociente y resto ya en la cache
+            if (cache != 0)
+            {
+                const int zeros = countLeadingZeros(cache);
+
+                if (zeros + 1 + k <= available)
+                {
+                    const auto rest = cache << zeros << 1;
+                    const auto folded = ((juce::uint32) zeros << k) | (k > 0 ? (juce::uint32) (rest >> (64 - k)) : 0u);
+                    const int used = zeros + 1 + k;
+                    cache = used < 64 ? cache << used : 0;
+                    available -= used;
+                    return (int) (folded >> 1) ^ -(int) (folded & 1);
+                }
+            }
+
+            const auto folded = (readUnary() << k) | read(k);
+            return (int) (folded >> 1) ^ -(int) (folded & 1);
+        }
+
+        void alignToByte() noexcept     { read(available & 7); }
+
+        /** Solo alineado a byte */
+        const juce::uint8* getPosition() const noexcept { return next - available / 8; }
+
+        bool hasOverrun() const noexcept { return overrun; }
+
+    private:
+        void refill() noexcept
+        {
+            if (limit - next >= 8)
+            {
+                // Los bytes enteros que entran; los bits de mas se limpian
+                const int numBytes = (64 - available) >> 3;
+                cache |= juce::ByteOrder::bigEndianInt64(next) >> available;
+                next += numBytes;
+                available += numBytes * 8;
+                cache &= available == 64 ? ~(juce::uint64) 0 : ~(~(juce::uint64) 0 >> available);
+                return;
+            }
+
+            while (available <= 56 && next < limit)
+            {
+                cache |= (juce::uint64) *next++ << (56 - available);
+                available += 8;
+            }
+        }
+
+        const juce::uint8* next;
+        const juce::uint8* const limit;
+        juce::uint64 cache = 0;
+        int available = 0;
+        bool overrun = false;
+    };
+
+    // ------------------------------------------------------
+    //  Lectura: subframes
+    // ------------------------------------------------------
+    bool readResidual(BitReader& bits, int* residual, int n, int order) noexcept
+    {
+        const auto method = bits.read(2);
+
+        if (method > 1)
+            return false;
+
+        const int parameterBits = method == 0 ? 4 : 5;
+        const auto escapeCode   = method == 0 ? 15u : 31u;
+        const int partitionOrder = (int) bits.read(4);
+        const int partitionSize  = n >> partitionOrder;
+
+        if ((partitionSize << partitionOrder) != n || partitionSize < order)
+            return false;
+
+        for (int p = 0; p < (1 << partitionOrder); ++p)
+        {
+            const int count = partitionSize - (p == 0 ? order : 0);
+            const auto parameter = bits.read(parameterBits);
+
+            if (parameter == escapeCode)
+            {
+                const int rawBits = (int) bits.read(5);
+
+                for (int i = 0; i < count; ++i)
+                    residual[i] = bits.readSigned(rawBits);
+            }
+            else
+            {
+                for (int i = 0; i < count; ++i)
+                    residual[i] = bits.readRice((int) parameter);
+            }
+
+            if (bits.hasOverrun())
+                return false;
+
+            residual += count;
+        }
+
+        return true;
+    }
+
+    void restoreFixed(int* x, int n, int order) noexcept
+    {
+        switch (order)
+        {
+            case 1: for (int i = 1; i < n; ++i) x[i] += x[i - 1]; break;
+            case 2: for (int i = 2; i < n; ++i) x[i] = (int) (x[i] + 2 * (juce::int64) x[i - 1] - x[i - 2]); break;
+            case 3: for (int i = 3; i < n; ++i) x[i] = (int) (x[i] + 3 * ((juce::int64) x[i - 1] - x[i - 2]) + x[i - 3]); break;
+            case 4: for (int i = 4; i < n; ++i) x[i] = (int) (x[i] + 4 * ((juce::int64) x[i - 1] + x[i - 3]) - 6 * (juce::int64) x[i - 2] - x[i - 4]); break;
+            default: break;
+        }
+    }
+
+    template <int order, typename Accumulator>
+    void restoreLpc(int* x, int n, const int* coefficients, int shift) noexcept
+    {
+        for (int i = order; i < n; ++i)
+        {
+            Accumulator sum = 0;
+
+            for (int j = 0; j < order; ++j)
+                sum += (Accumulator) coefficients[j] * x[i - 1 - j];
+
+            x[i] += (int) (sum >> shift);
+        }
+    }
+
+    template <typename Accumulator>
+    void restoreLpc(int* x, int n, int order, const int* coefficients, int shift) noexcept
+    {
+        switch (order)
+        {
+            case 1:  restoreLpc<1, Accumulator>(x, n, coefficients, shift); break;
+            case 2:  restoreLpc<2, Accumulator>(x, n, coefficients, shift); break;
+            case 3:  restoreLpc<3, Accumulator>(x, n, coefficients, shift); break;
+            case 4:  restoreLpc<4, Accumulator>(x, n, coefficients, shift); break;
+            case 5:  restoreLpc<5, Accumulator>(x, n, coefficients, shift); break;
+            case 6:  restoreLpc<6, Accumulator>(x, n, coefficients, shift); break;
+            case 7:  restoreLpc<7, Accumulator>(x, n, coefficients, shift); break;
+            case 8:  restoreLpc<8, Accumulator>(x, n, coefficients, shift); break;
+            case 12: restoreLpc<12, Accumulator>(x, n, coefficients, shift); break;
+            default:
+                for (int i = order; i < n; ++i)
+                {
+                    Accumulator sum = 0;
+
+                    for (int j = 0; j < order; ++j)
+                        sum += (Accumulator) coefficients[j] * x[i - 1 - j];
+
+                    x[i] += (int) (sum >> shift);
+                }
+                break;
+        }
+    }
+
+    bool readSubframe(BitReader& bits, int* x, int n, int bitsPerSample) noexcept
+    {
+        if (bits.read(1) != 0)
+            return false;
+
+        const int type = (int) bits.read(6);
+        int wasted = 0;
+
+        if (bits.read(1) != 0)
+            wasted = (int) bits.readUnary() + 1;
+
+        if (wasted >= bitsPerSample)
+            return false;
+
+        const int sampleBits = bitsPerSample - wasted;
+
+        if (type == 0)
+        {
+            std::fill(x, x + n, bits.readSigned(sampleBits));
+        }
+        else if (type == 1)
+        {
+            for (int i = 0; i < n; ++i)
+                x[i] = bits.readSigned(sampleBits);
+        }
+        else if (type >= 8 && type <= 8 + maxFixedOrder)
+        {
+            const int order = type - 8;
+
+            if (order > n)
+                return false;
+
+            for (int i = 0; i < order; ++i)
+                x[i] = bits.readSigned(sampleBits);
+
+            if (! readResidual(bits, x + order, n, order))
+                return false;
+
+            restoreFixed(x, n, order);
+        }
+        else if (type >= 32)
+        {
+            const int order = type - 31;
+            int coefficients[32];
+
+            if (order > n)
+                return false;
+
+            for (int i = 0; i < order; ++i)
+                x[i] = bits.readSigned(sampleBits);
+
+            const int precision = (int) bits.read(4) + 1;
+            const int shift = bits.readSigned(5);
+
+            if (precision == 16 || shift < 0)
+                return false;
+
+            for (int i = 0; i < order; ++i)
+                coefficients[i] = bits.readSigned(precision);
+
+            if (! readResidual(bits, x + order, n, order))
+                return false;
+
+            // Acumulador de 32 bits si no se puede pasar (como en el encoder)
+            if (sampleBits + precision + juce::findHighestSetBit((juce::uint32) order) + 1 <= 32)
+                restoreLpc<int>(x, n, order, coefficients, shift);
+            else
+                restoreLpc<juce::int64>(x, n, order, coefficients, shift);
+        }
+        else
+        {
+            return false;
+        }
+
+        if (wasted > 0)
+            for (int i = 0; i < n; ++i)
+                x[i] = (int) ((juce::uint32) x[i] << wasted);
+
+        return ! bits.hasOverrun();
+    }
+
+    /** El frame de header (ya leida en pos): subframes, CRC-16 y
+        decorrelacion estereo. pos queda en el frame siguiente. */
+    bool readFrame(const juce::uint8*& pos, const juce::uint8* end, const HZFlacReader::StreamInfo& info,
+                   const FrameHeader& header, int* const* channels) noexcept
+    {
+        BitReader bits(pos + header.numBytes, end);
+        const int assignment = header.channelAssignment;
+        const int n = header.blockSize;
+
+        for (int ch = 0; ch < info.numChannels; ++ch)
+        {
+            // El canal lado lleva un bit mas
+            const bool isSide = (assignment == 8 && ch == 1) || (assignment == 9 && ch == 0)
+                             || (assignment == 10 && ch == 1);
+
+            if (! readSubframe(bits, channels[ch], n, info.bitsPerSample + (isSide ? 1 : 0)))
+                return false;
+        }
+
+        bits.alignToByte();
+        const auto* frameEnd = bits.getPosition();
+
+        if (bits.read(16) != computeCrc16(pos, (size_t) (frameEnd - pos)) || bits.hasOverrun())
+            return false;
+
+        auto* left  = channels[0];
+        auto* right = channels[info.numChannels > 1 ? 1 : 0];
+
+        switch (assignment)
+        {
+            case 8:   // izq / lado
+                for (int i = 0; i < n; ++i)
+                    right[i] = left[i] - right[i];
+                break;
+
+            case 9:   // lado / der
+                for (int i = 0; i < n; ++i)
+                    left[i] += right[i];
+                break;
+
+            case 10:  // medio / lado
+                for (int i = 0; i < n; ++i)
+                {
+                    const int side = right[i];
+                    const int mid = (int) (((juce::uint32) left[i] << 1) | (juce::uint32) (side & 1));
+                    left[i]  = (mid + side) >> 1;
+                    right[i] = (mid - side) >> 1;
+                }
+                break;
+
+            default:
+                break;
+        }
+
+        pos = frameEnd + 2;
+        return true;
+    }
+
+    // ------------------------------------------------------
+    //  Lectura: segmentos y escala (la de JUCE)
+    // ------------------------------------------------------
+    constexpr int segmentSamples = 1 << 16;             // objetivo por segmento (por canal)
+    constexpr int maxSegmentSamples = 4 * segmentSamples;
+
+    template <typename SampleType>
+    void toSamples(const int* src, SampleType* dest, int numSamples, int shift) noexcept
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto v = (int) ((juce::uint32) src[i] << shift);
+
+            if constexpr (std::is_same_v<SampleType, float>)
+                dest[i] = (float) v * (1.0f / (float) 0x7fffffff);
+            else
+                dest[i] = v * (1.0 / 2147483648.0);
+        }
+    }
+}
+
+// ==========================================================
+//  MD5 incremental (RFC 1321) para el STREAMINFO: juce::MD5
+//  solo calcula de una vez sobre un bloque entero
+// ==========================================================
+struct HZFlacWriter::Md5
+{
+    juce::uint32 state[4] { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476 };
+    juce::uint8 buffer[64] {};
+    juce::uint64 length = 0;
+
+    void update(const juce::uint8* data, size_t numBytes) noexcept
+    {
+        auto used = (size_t) (length & 63);
+        length += numBytes;
+
+        if (used > 0)
+        {
+            const auto n = juce::jmin(numBytes, 64 - used);
+            std::memcpy(buffer + used, data, n);
+            data += n;
+            numBytes -= n;
+            used += n;
+
+            if (used < 64)
+                return;
+
+            transform(buffer);
+        }
+
+        for (; numBytes >= 64; data += 64, numBytes -= 64)
+            transform(data);
+
+        std::memcpy(buffer, data, numBytes);
+    }
+
+    void finish(juce::uint8* digest) noexcept
+    {
+        const auto bitLength = length * 8;
+        const juce::uint8 padding[64] { 0x80 };
+
+        update(padding, 1 + ((55 - (size_t) (length & 63)) & 63));
+
+        juce::uint8 tail[8];
+
+        for (int i = 0; i < 8; ++i)
+            tail[i] = (juce::uint8) (bitLength >> (8 * i));
+
+        update(tail, 8);
+
+        for (int i = 0; i < 16; ++i)
+            digest[i] = (juce::uint8) (state[i / 4] >> (8 * (i % 4)));
+    }
+
+    void transform(const juce::uint8* block) noexcept
+    {
+        static constexpr int shifts[16] = { 7, 12, 17, 22, 5, 9, 14, 20, 4, 11, 16, 23, 6, 10, 15, 21 };
+        static const auto constants = []
+        {
+            std::array<juce::uint32, 64> k {};
+
+            for (int i = 0; i < 64; ++i)
+                k[(size_t) i] = (juce::uint32) (juce::uint64) std::floor(std::abs(std::sin(i + 1.0)) * 4294967296.0);
+
+            return k;
+        }();
+
+        juce::uint32 m[16];
+
+        for (int i = 0; i < 16; ++i)
+            m[i] = juce::ByteOrder::littleEndianInt(block + 4 * i);
+
+        auto a = state[0], b = state[1], c = state[2], d = state[3];
+
+        for (int i = 0; i < 64; ++i)
+        {
+            juce::uint32 f;
+            int g;
+
+            switch (i / 16)
+            {
+                case 0:  f = (b & c) | (~b & d); g = i; break;
+                case 1:  f = (d & b) | (~d & c); g = (5 * i + 1) & 15; break;
+                case 2:  f = b ^ c ^ d;          g = (3 * i + 5) & 15; break;
+                default: f = c ^ (b | ~d);       g = (7 * i) & 15; break;
+            }
+
+            f += a + constants[(size_t) i] + m[g];
+            a = d;
+            d = c;
+            c = b;
+
+            const int s = shifts[(i / 16) * 4 + (i & 3)];
+            b += (f << s) | (f >> (32 - s));
+        }
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+    }
+};
+
+// ==========================================================
+//  HZFlacWriter
+// ==========================================================
+HZFlacWriter::HZFlacWriter(std::unique_ptr<juce::OutputStream> stream, double rate, int channels,
+                           HZSampleFormat sampleFormat, HZDitherMode dither, int numThreads)
+    : output(std::move(stream)),
+      sampleRate(rate),
+      numChannels(channels),
+      format(sampleFormat),
+      bitsPerSample(getBitsPerSample(sampleFormat)),
+      headerPosition(output != nullptr ? output->getPosition() : 0),
+      md5(std::make_unique<Md5>())
+{
+    jassert(supportsFormat(format) && numChannels <= maxChannels);
+
+    quantizer = std::make_unique<HZQuantizer>(numChannels, bitsPerSample, dither);
+
+    const int threads = juce::jmax(1, numThreads);
+
+    if (threads > 1)
+        pool = std::make_unique<juce::ThreadPool>(threads);
+
+    framesPerBatch = threads * framesPerThread;
+    batchCapacity  = framesPerBatch * frameSamples;
+
+    for (auto& batch : batches)
+    {
+        batch.samples.malloc((size_t) batchCapacity * (size_t) numChannels);
+        batch.frames.resize((size_t) framesPerBatch);
+    }
+
+    quantizeChannels.resize((size_t) numChannels);
+    floatChunk.resize((size_t) numChannels);
+    doubleChunk.resize((size_t) numChannels);
+
+    if (output != nullptr && ! writeStreamInfo(nullptr))
+        failed = true;
+}
+
+HZFlacWriter::~HZFlacWriter()
+{
+    finish();
+}
+
+bool HZFlacWriter::supportsFormat(HZSampleFormat sampleFormat) noexcept
+{
+    return sampleFormat == HZSampleFormat::int16 || sampleFormat == HZSampleFormat::int24;
+}
+
+template <typename SampleType>
+bool HZFlacWriter::writeSamples(const SampleType* const* input, int numFrames)
+{
+    if (! isOk() || finished)
+        return false;
+
+    auto& chunk = [this]() -> auto&
+    {
+        if constexpr (std::is_same_v<SampleType, float>)
+            return floatChunk;
+        else
+            return doubleChunk;
+    }();
+
+    // El cuantizador escribe directo en el lote (planar)
+    for (int done = 0; done < numFrames;)
+    {
+        auto& batch = batches[current];
+        const int n = juce::jmin(numFrames - done, batchCapacity - batch.numFrames);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            chunk[(size_t) ch] = input[ch] + done;
+            quantizeChannels[(size_t) ch] = batch.samples + (size_t) ch * (size_t) batchCapacity + (size_t) batch.numFrames;
+        }
+
+        quantizer->process(chunk.data(), quantizeChannels.data(), n);
+
+        batch.numFrames += n;
+        done += n;
+
+        if (batch.numFrames == batchCapacity && ! submitBatch())
+            return false;
+    }
+
+    return true;
+}
+
+void HZFlacWriter::setProgressiveHeader(double intervalSeconds)
+{
+    progressive = intervalSeconds > 0.0;
+
+    if (isOk())
+        output->flush();
+}
+
+bool HZFlacWriter::submitBatch()
+{
+    auto& batch = batches[current];
+
+    // El MD5 es secuencial: el lote anterior tiene que estar cerrado
+    if (batches[current ^ 1].active && ! completeBatch(batches[current ^ 1]))
+        return false;
+
+    if (batch.numFrames == 0)
+        return true;
+
+    const int count = (batch.numFrames + frameSamples - 1) / frameSamples;
+    batch.firstFrame = nextFrame;
+    batch.active = true;
+    nextFrame += count;
+    totalSamples += batch.numFrames;
+    current ^= 1;
+
+    if (pool == nullptr)
+    {
+        updateChecksum(batch);
+
+        for (int i = 0; i < count; ++i)
+            encodeFrame(batch, i);
+
+        return true;
+    }
+
+    batch.pending = count + 1;
+
+    const auto finishJob = [&batch]
+    {
+        if (--batch.pending == 0)
+            batch.done.signal();
+    };
+
+    pool->addJob([this, &batch, finishJob]
+    {
+        updateChecksum(batch);
+        finishJob();
+    });
+
+    for (int i = 0; i < count; ++i)
+    {
+        pool->addJob([this, &batch, i, finishJob]
+        {
+            encodeFrame(batch, i);
+            finishJob();
+        });
+    }
+
+    return true;
+}
+
+bool HZFlacWriter::completeBatch(Batch& batch)
+{
+    if (pool != nullptr)
+        batch.done.wait();
+
+    const int count = (batch.numFrames + frameSamples - 1) / frameSamples;
+    batch.active = false;
+    batch.numFrames = 0;
+
+    if (failed)
+        return false;
+
+    for (int i = 0; i < count; ++i)
+    {
+        const auto& frame = batch.frames[(size_t) i];
+        const auto numBytes = (juce::uint32) frame.size();
+
+        if (! output->write(frame.data(), frame.size()))
+        {
+            failed = true;
+            return false;
+        }
+
+        minFrameBytes = minFrameBytes == 0 ? numBytes : juce::jmin(minFrameBytes, numBytes);
+        maxFrameBytes = juce::jmax(maxFrameBytes, numBytes);
+    }
+
+    if (progressive)
+        output->flush();
+
+    return true;
+}
+
+void HZFlacWriter::encodeFrame(Batch& batch, int index) const
+{
+    thread_local Scratch scratch;
+    scratch.prepare();
+
+    const int offset = index * frameSamples;
+    const int n = juce::jmin(frameSamples, batch.numFrames - offset);
+    const int shift = 32 - bitsPerSample;
+
+    // Subframes candidatos: cada canal y, en estereo, lado (un bit mas) y medio
+    Subframe candidates[maxChannels];
+    const int* signals[maxChannels];
+    int signalBits[maxChannels];
+    int numCandidates = numChannels;
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        const int* src = batch.samples + (size_t) ch * (size_t) batchCapacity + (size_t) offset;
+        auto* dst = scratch.channels[ch].data();
+
+        for (int i = 0; i < n; ++i)
+            dst[i] = src[i] >> shift;
+
+        signals[ch] = dst;
+        signalBits[ch] = bitsPerSample;
+    }
+
+    if (numChannels == 2)
+    {
+        auto* side = scratch.side.data();
+        auto* mid  = scratch.mid.data();
+
+        for (int i = 0; i < n; ++i)
+        {
+            side[i] = signals[0][i] - signals[1][i];
+            mid[i]  = (signals[0][i] + signals[1][i]) >> 1;
+        }
+
+        signals[2] = side;
+        signals[3] = mid;
+        signalBits[2] = bitsPerSample + 1;
+        signalBits[3] = bitsPerSample;
+        numCandidates = 4;
+    }
+
+    for (int c = 0; c < numCandidates; ++c)
+        analyzeSubframe(signals[c], n, signalBits[c], candidates[c], scratch.residual[c].data(),
+                        scratch.trial.data(), scratch);
+
+    int chosen[maxChannels];
+    int channelAssignment = numChannels - 1;
+
+    for (int ch = 0; ch < numChannels; ++ch)
+        chosen[ch] = ch;
+
+    if (numChannels == 2)
+    {
+        // izq/der, izq/lado, lado/der, medio/lado: el par mas chico
+        static constexpr int pairs[4][2] = { { 0, 1 }, { 0, 2 }, { 2, 1 }, { 3, 2 } };
+        auto smallest = std::numeric_limits<juce::int64>::max();
+
+        for (int p = 0; p < 4; ++p)
+        {
+            const auto size = candidates[pairs[p][0]].bits + candidates[pairs[p][1]].bits;
+
+            if (size < smallest)
+            {
+                smallest = size;
+                chosen[0] = pairs[p][0];
+                chosen[1] = pairs[p][1];
+                channelAssignment = p == 0 ? 1 : 7 + p;
+            }
+        }
+    }
+
+    auto& out = batch.frames[(size_t) index];
+    out.clear();
+    writeFrameHeader(out, batch.firstFrame + index, n, (int) sampleRate, channelAssignment, bitsPerSample);
+
+    // Cada subframe ocupa a lo sumo lo mismo que su verbatim
+    const auto headerBytes = out.size();
+    size_t maxBytes = headerBytes + 2 + 8;
+
+    for (int ch = 0; ch < numChannels; ++ch)
+        maxBytes += (size_t) ((8 + (juce::int64) signalBits[chosen[ch]] * n + 7) / 8);
+
+    out.resize(maxBytes);
+
+    BitWriter bits(out.data() + headerBytes);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+        writeSubframe(bits, candidates[chosen[ch]], signals[chosen[ch]], n, signalBits[chosen[ch]]);
+
+    out.resize((size_t) (bits.flush() - out.data()));
+
+    const auto crc = computeCrc16(out.data(), out.size());
+    out.push_back((juce::uint8) (crc >> 8));
+    out.push_back((juce::uint8) crc);
+}
+
+void HZFlacWriter::updateChecksum(const Batch& batch)
+{
+    // Muestras intercaladas en little endian, con los bytes justos
+    const int bytesPerSample = bitsPerSample / 8;
+    const int shift = 32 - bitsPerSample;
+    constexpr int chunkFrames = 1024;
+
+    md5Scratch.resize((size_t) chunkFrames * (size_t) numChannels * (size_t) bytesPerSample);
+
+    for (int start = 0; start < batch.numFrames; start += chunkFrames)
+    {
+        const int n = juce::jmin(chunkFrames, batch.numFrames - start);
+        auto* dst = md5Scratch.data();
+
+        for (int i = start; i < start + n; ++i)
+        {
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                const int v = batch.samples[(size_t) ch * (size_t) batchCapacity + (size_t) i] >> shift;
+
+                for (int b = 0; b < bytesPerSample; ++b)
+                    *dst++ = (juce::uint8) (v >> (8 * b));
+            }
+        }
+
+        md5->update(md5Scratch.data(), (size_t) (dst - md5Scratch.data()));
+    }
+}
+
+bool HZFlacWriter::finish()
+{
+    if (output == nullptr || finished)
+        return isOk();
+
+    finished = true;
+
+    // El lote a medio llenar (el ultimo frame puede ser mas corto); con un
+    // error igual hay que esperar los trabajos que sigan en el pool
+    bool ok = ! failed && submitBatch();
+
+    for (auto& batch : batches)
+        if (batch.active)
+            ok = completeBatch(batch) && ok;
+
+    if (ok)
+    {
+        juce::uint8 digest[16];
+        md5->finish(digest);
+        ok = writeStreamInfo(digest);
+    }
+
+    failed = ! ok;
+    output->flush();
+    return isOk();
+}
+
+bool HZFlacWriter::writeStreamInfo(const juce::uint8* digest)
+{
+    const auto endPosition = output->getPosition();
+
+    if (endPosition != headerPosition && ! output->setPosition(headerPosition))
+        return false;
+
+    // "fLaC" + STREAMINFO (ultimo bloque de metadatos, 34 bytes)
+    juce::uint8 header[42] {};
+    std::memcpy(header, "fLaC", 4);
+    header[4] = 0x80;
+    header[7] = 34;
+
+    auto* info = header + 8;
+    info[0] = (juce::uint8) (frameSamples >> 8);
+    info[1] = (juce::uint8) frameSamples;
+    info[2] = (juce::uint8) (frameSamples >> 8);
+    info[3] = (juce::uint8) frameSamples;
+
+    for (int i = 0; i < 3; ++i)
+    {
+        info[4 + i] = (juce::uint8) (minFrameBytes >> (16 - 8 * i));
+        info[7 + i] = (juce::uint8) (maxFrameBytes >> (16 - 8 * i));
+    }
+
+    // Frecuencia (20 bits), canales - 1 (3), bits - 1 (5), total (36)
+    const auto packed = ((juce::uint64) (juce::uint32) sampleRate << 44)
+                      | ((juce::uint64) (numChannels - 1) << 41)
+                      | ((juce::uint64) (bitsPerSample - 1) << 36)
+                      | ((juce::uint64) totalSamples & 0xfffffffffull);
+
+    for (int i = 0; i < 8; ++i)
+        info[10 + i] = (juce::uint8) (packed >> (56 - 8 * i));
+
+    // Sin MD5 (ceros) mientras se escribe: "no calculado"
+    if (digest != nullptr)
+        std::memcpy(info + 18, digest, 16);
+
+    if (! output->write(header, sizeof(header)))
+        return false;
+
+    return endPosition == headerPosition || output->setPosition(endPosition);
+}
+
+template bool HZFlacWriter::writeSamples<float>(const float* const*, int);
+template bool HZFlacWriter::writeSamples<double>(const double* const*, int);
+
+// ==========================================================
+//  HZFlacReader
+// ==========================================================
+std::unique_ptr<HZFlacReader> HZFlacReader::create(juce::AudioFormatReader& reader, int numThreads)
+{
+    auto* fileStream = dynamic_cast<juce::FileInputStream*>(reader.input);
+
+    if (fileStream == nullptr || reader.getFormatName() != "FLAC file")
+        return nullptr;
+
+    auto map = std::make_unique<juce::MemoryMappedFile>(fileStream->getFile(), juce::MemoryMappedFile::readOnly);
+    const auto* data = static_cast<const juce::uint8*>(map->getData());
+    const auto size = (juce::int64) map->getSize();
+
+    if (data == nullptr || size < 42 || std::memcmp(data, "fLaC", 4) != 0)
+        return nullptr;
+
+    // Bloques de metadatos: STREAMINFO (siempre el primero) y SEEKTABLE
+    StreamInfo info;
+    std::vector<std::pair<juce::int64, juce::int64>> seekTable;   // (muestra, offset)
+    juce::int64 pos = 4;
+    bool last = false, hasStreamInfo = false;
+
+    while (! last)
+    {
+        if (pos + 4 > size)
+            return nullptr;
+
+        const auto* block = data + pos;
+        const int type = block[0] & 0x7f;
+        const auto length = (juce::int64) ((block[1] << 16) | (block[2] << 8) | block[3]);
+        last = (block[0] & 0x80) != 0;
+        pos += 4;
+
+        if (pos + length > size)
+            return nullptr;
+
+        const auto* body = data + pos;
+
+        if (type == 0 && length >= 34)
+        {
+            info.minBlockSize  = (body[0] << 8) | body[1];
+            info.maxBlockSize  = (body[2] << 8) | body[3];
+            info.numChannels   = ((body[12] >> 1) & 7) + 1;
+            info.bitsPerSample = (((body[12] & 1) << 4) | (body[13] >> 4)) + 1;
+            info.totalSamples  = ((juce::int64) (body[13] & 15) << 32)
+                               | (juce::int64) juce::ByteOrder::bigEndianInt(body + 14);
+            hasStreamInfo = true;
+        }
+        else if (type == 3)
+        {
+            for (juce::int64 i = 0; i + 18 <= length; i += 18)
+            {
+                const auto sample = (juce::int64) juce::ByteOrder::bigEndianInt64(body + i);
+
+                if (sample >= 0)   // los de reserva son 0xffff...
+                    seekTable.emplace_back(sample, (juce::int64) juce::ByteOrder::bigEndianInt64(body + i + 8));
+            }
+        }
+
+        pos += length;
+    }
+
+    // Lo mismo que el reader de JUCE, y con total conocido (sin total
+    // no se puede saber de antemano donde termina cada segmento)
+    if (! hasStreamInfo
+         || info.totalSamples <= 0 || info.totalSamples != reader.lengthInSamples
+         || info.numChannels != (int) reader.numChannels || info.numChannels > maxChannels
+         || info.bitsPerSample != (int) reader.bitsPerSample
+         || info.bitsPerSample < 4 || info.bitsPerSample > 24
+         || info.maxBlockSize < 16 || info.minBlockSize > info.maxBlockSize
+         || pos + 2 > size)
+        return nullptr;
+
+    info.variableBlockSize = (data[pos + 1] & 1) != 0;
+
+    std::unique_ptr<HZFlacReader> flac(new HZFlacReader(std::move(map), info, numThreads));
+
+    if (! flac->buildSegments(pos, seekTable))
+        return nullptr;
+
+    return flac;
+}
+
+HZFlacReader::HZFlacReader(std::unique_ptr<juce::MemoryMappedFile> file, const StreamInfo& streamInfo, int numThreads)
+    : map(std::move(file)),
+      data(static_cast<const juce::uint8*>(map->getData())),
+      dataSize((juce::int64) map->getSize()),
+      info(streamInfo)
+{
+    const int threads = juce::jmax(1, numThreads);
+
+    if (threads > 1)
+        pool = std::make_unique<juce::ThreadPool>(threads);
+
+    // Cola: el segmento que se lee y los que se decodifican por adelantado
+    slots.resize((size_t) juce::jmax(2, threads * 2));
+
+    for (auto& slot : slots)
+        slot = std::make_unique<Slot>();
+}
+
+HZFlacReader::~HZFlacReader()
+{
+    for (auto& slot : slots)
+        wait(*slot);
+}
+
+bool HZFlacReader::buildSegments(juce::int64 firstFrame, const std::vector<std::pair<juce::int64, juce::int64>>& seekTable)
+{
+    const auto* end = data + dataSize;
+    FrameHeader header;
+
+    // Un corte es bueno si ahi hay un frame entero: cabecera y CRC-16
+    std::vector<int> scratch((size_t) info.maxBlockSize * (size_t) info.numChannels);
+    int* channels[maxChannels];
+
+    for (int ch = 0; ch < info.numChannels; ++ch)
+        channels[ch] = scratch.data() + (size_t) ch * (size_t) info.maxBlockSize;
+
+    const auto isFrame = [&](const juce::uint8* p)
+    {
+        return parseFrameHeader(p, end, info, header) && readFrame(p, end, info, header, channels);
+    };
+
+    if (! isFrame(data + firstFrame) || header.firstSample != 0)
+        return false;
+
+    // El primer frame valido desde offset (sin pasar de limit) que empiece
+    // despues de afterSample
+    const auto findFrame = [&](juce::int64 offset, juce::int64 limit, juce::int64 afterSample, juce::int64& frameSample)
+    {
+        for (auto* p = data + offset; p + 1 < data + limit;)
+        {
+            p = static_cast<const juce::uint8*>(std::memchr(p, 0xff, (size_t) (data + limit - 1 - p)));
+
+            if (p == nullptr)
+                break;
+
+            if (parseFrameHeader(p, end, info, header) && header.firstSample > afterSample && isFrame(p))
+            {
+                frameSample = header.firstSample;
+                return (juce::int64) (p - data);
+            }
+
+            ++p;
+        }
+
+        return (juce::int64) -1;
+    };
+
+    // Anclas: primer frame, puntos del SEEKTABLE que caen en un frame con
+    // esa muestra y el final del archivo
+    std::vector<std::pair<juce::int64, juce::int64>> anchors { { 0, firstFrame } };   // (muestra, offset)
+
+    for (const auto& [sample, offset] : seekTable)
+    {
+        const auto position = firstFrame + offset;
+
+        if (sample > anchors.back().first && position > anchors.back().second && position < dataSize
+             && isFrame(data + position) && header.firstSample == sample)
+        {
+            anchors.emplace_back(sample, position);
+        }
+    }
+
+    anchors.emplace_back(info.totalSamples, dataSize);
+
+    // Entre anclas, cortes en bytes proporcionales; los puntos del
+    // SEEKTABLE mas cerca que medio segmento se saltean
+    std::vector<std::pair<juce::int64, juce::int64>> boundaries { anchors.front() };
+
+    for (size_t a = 1; a < anchors.size(); ++a)
+    {
+        const auto& from = anchors[a - 1];
+        const auto& to   = anchors[a];
+        const auto pieces = juce::jmax((juce::int64) 1, (to.first - from.first + segmentSamples / 2) / segmentSamples);
+
+        for (juce::int64 j = 1; j < pieces; ++j)
+        {
+            const auto guess = from.second + (to.second - from.second) * j / pieces;
+            juce::int64 sample = 0;
+            const auto offset = findFrame(juce::jmax(guess, boundaries.back().second + 1), to.second,
+                                          boundaries.back().first, sample);
+
+            if (offset >= 0 && sample < to.first)
+                boundaries.emplace_back(sample, offset);
+        }
+
+        if (a + 1 < anchors.size() && to.first - boundaries.back().first >= segmentSamples / 2)
+        {
+            boundaries.push_back(to);
+            ++seekPointsUsed;
+        }
+    }
+
+    boundaries.push_back(anchors.back());
+
+    // Un buffer alcanza para el segmento mas largo (si la busqueda no
+    // encontro cortes puede ser el archivo entero: mejor JUCE)
+    juce::int64 longest = 0;
+
+    for (size_t i = 0; i + 1 < boundaries.size(); ++i)
+    {
+        Segment segment;
+        segment.offset      = boundaries[i].second;
+        segment.end         = boundaries[i + 1].second;
+        segment.firstSample = boundaries[i].first;
+        segment.numSamples  = boundaries[i + 1].first - boundaries[i].first;
+        segments.push_back(segment);
+        longest = juce::jmax(longest, segment.numSamples);
+    }
+
+    if (longest > maxSegmentSamples)
+        return false;
+
+    segmentCapacity = (int) longest;
+
+    for (auto& slot : slots)
+        slot->samples.malloc((size_t) segmentCapacity * (size_t) info.numChannels);
+
+    return true;
+}
+
+bool HZFlacReader::decodeSegment(const Segment& segment, int* samples) const
+{
+    const auto* pos = data + segment.offset;
+    const auto* end = data + segment.end;
+    int* channels[maxChannels];
+    juce::int64 sample = segment.firstSample;
+    FrameHeader header;
+
+    while (sample < segment.firstSample + segment.numSamples)
+    {
+        // Cada frame sigue al anterior: un corte falso no llega hasta aca
+        if (! parseFrameHeader(pos, end, info, header) || header.firstSample != sample
+             || sample + header.blockSize > segment.firstSample + segment.numSamples)
+            return false;
+
+        const auto offset = (size_t) (sample - segment.firstSample);
+
+        for (int ch = 0; ch < info.numChannels; ++ch)
+            channels[ch] = samples + (size_t) ch * (size_t) segmentCapacity + offset;
+
+        if (! readFrame(pos, end, info, header, channels))
+            return false;
+
+        sample += header.blockSize;
+    }
+
+    // El ultimo puede tener algo despues (tags): los demas terminan justo
+    // donde empieza el siguiente
+    return pos == end || segment.end == dataSize;
+}
+
+HZFlacReader::Slot& HZFlacReader::request(int segment)
+{
+    auto& slot = *slots[(size_t) segment % slots.size()];
+
+    if (slot.segment == segment)
+        return slot;
+
+    wait(slot);
+    slot.segment = segment;
+
+    if (pool == nullptr)
+    {
+        slot.ok = decodeSegment(segments[(size_t) segment], slot.samples);
+        return slot;
+    }
+
+    slot.inFlight = true;
+
+    pool->addJob([this, &slot, segment]
+    {
+        slot.ok = decodeSegment(segments[(size_t) segment], slot.samples);
+        slot.done.signal();
+    });
+
+    return slot;
+}
+
+void HZFlacReader::wait(Slot& slot)
+{
+    if (slot.inFlight)
+    {
+        slot.done.wait();
+        slot.inFlight = false;
+    }
+}
+
+template <typename SampleType>
+bool HZFlacReader::read(SampleType* const* dest, int numChannels, juce::int64 start, int numFrames)
+{
+    jassert(numChannels == info.numChannels);
+
+    const int shift = 32 - info.bitsPerSample;
+    const int available = (int) juce::jlimit((juce::int64) 0, (juce::int64) numFrames, info.totalSamples - start);
+
+    for (int done = 0; done < available;)
+    {
+        const auto position = start + done;
+        const auto next = std::upper_bound(segments.begin(), segments.end(), position,
+                                           [](juce::int64 p, const Segment& s) { return p < s.firstSample; });
+        const int index = (int) (next - segments.begin()) - 1;
+
+        // El que hace falta y los siguientes, en orden
+        auto& slot = request(index);
+
+        for (int ahead = 1; ahead < (int) slots.size() && index + ahead < (int) segments.size(); ++ahead)
+            request(index + ahead);
+
+        wait(slot);
+
+        if (! slot.ok)
+            return false;
+
+        const auto& segment = segments[(size_t) index];
+        const int offset = (int) (position - segment.firstSample);
+        const int n = (int) juce::jmin((juce::int64) (available - done), segment.numSamples - offset);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            toSamples(slot.samples + (size_t) ch * (size_t) segmentCapacity + (size_t) offset, dest[ch] + done, n, shift);
+
+        done += n;
+    }
+
+    for (int ch = 0; ch < numChannels; ++ch)
+        std::fill(dest[ch] + available, dest[ch] + numFrames, SampleType());
+
+    return true;
+}
+
+template bool HZFlacReader::read<float>(float* const*, int, juce::int64, int);
+template bool HZFlacReader::read<double>(double* const*, int, juce::int64, int);
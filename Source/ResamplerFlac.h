@@ -0,0 +1,190 @@
+#pragma once
+#include "JuceHeader.h"
+#include "ResamplerPcm.h"
+#include <atomic>
+
+// ==========================================================
+//  Escritura de FLAC en paralelo
+//
+//  El encoder de libFLAC codifica un frame detras de otro en
+//  un solo hilo. Los frames FLAC son independientes (ninguno
+//  usa muestras del anterior), asi que aca la salida del
+//  motor se cuantiza en lotes de frames de 4096 muestras y
+//  cada frame se codifica en un hilo del pool propio. Al
+//  terminar el lote los frames se escriben en orden, mientras
+//  el motor ya llena el lote siguiente (doble buffer).
+//
+//  Por frame: en estereo, izq/der, izq/lado, lado/der o
+//  medio/lado, el que ocupe menos. Por subframe: constante,
+//  predictor fijo de orden 0 a 4 o LPC hasta orden 8 (ventana
+//  de Tukey, Levinson-Durbin, coeficientes cuantizados), con
+//  el residuo en Rice particionado; verbatim si nada comprime.
+//
+//  El MD5 del STREAMINFO (muestras intercaladas en little
+//  endian) es secuencial: va como un trabajo mas de cada lote
+//  y corre a la par de los frames. Al cerrar se reescribe el
+//  STREAMINFO con el total de muestras, los tamaños minimo y
+//  maximo de frame y el MD5.
+// ==========================================================
+class HZFlacWriter : public HZAudioWriter
+{
+public:
+    /** format: int16 o int24 (lo mismo que el FlacAudioFormat de JUCE).
+        numThreads: hilos para codificar (1 = en el hilo que escribe).
+        El stream tiene que poder volver atras para el STREAMINFO. */
+    HZFlacWriter(std::unique_ptr<juce::OutputStream> stream, double sampleRate, int numChannels,
+                 HZSampleFormat format, HZDitherMode dither, int numThreads);
+
+    /** Llama a finish(). */
+    ~HZFlacWriter() override;
+
+    static bool supportsFormat(HZSampleFormat format) noexcept;
+
+    bool isOk() const noexcept override { return output != nullptr && ! failed; }
+    HZSampleFormat getFormat() const noexcept override { return format; }
+
+    bool write(const float* const* input, int numFrames) override  { return writeSamples(input, numFrames); }
+    bool write(const double* const* input, int numFrames) override { return writeSamples(input, numFrames); }
+
+    /** Los frames van al disco al terminar cada lote. Sin total (0 =
+        desconocido) el FLAC a medio escribir ya se puede decodificar. */
+    void setProgressiveHeader(double intervalSeconds) override;
+
+    /** Codifica el lote pendiente (el ultimo frame puede ser mas corto)
+        y reescribe el STREAMINFO. */
+    bool finish() override;
+
+private:
+    // Muestras de un lote (planar, int32 justificado a la izquierda,
+    // como las deja HZQuantizer) y los frames codificados
+    struct Batch
+    {
+        juce::HeapBlock<int> samples;
+        std::vector<std::vector<juce::uint8>> frames;
+        int numFrames = 0;                   // en muestras por canal
+        juce::int64 firstFrame = 0;          // numero del primer frame FLAC
+        bool active = false;                 // hay trabajos en el pool
+        std::atomic<int> pending { 0 };
+        juce::WaitableEvent done;
+    };
+
+    template <typename SampleType>
+    bool writeSamples(const SampleType* const* input, int numFrames);
+
+    /** Espera el lote anterior (y lo escribe) y lanza el actual. */
+    bool submitBatch();
+    bool completeBatch(Batch& batch);
+    void encodeFrame(Batch& batch, int index) const;
+    void updateChecksum(const Batch& batch);
+    bool writeStreamInfo(const juce::uint8* md5);
+
+    std::unique_ptr<juce::OutputStream> output;
+    const double sampleRate;
+    const int numChannels;
+    const HZSampleFormat format;
+    const int bitsPerSample;
+    const juce::int64 headerPosition;
+
+    std::unique_ptr<HZQuantizer> quantizer;
+    std::unique_ptr<juce::ThreadPool> pool;   // nullptr con un solo hilo
+
+    int framesPerBatch = 0, batchCapacity = 0;   // frames FLAC / muestras por canal
+    Batch batches[2];
+    int current = 0;
+    std::vector<int*> quantizeChannels;
+    std::vector<const float*> floatChunk;     // entrada del tramo (punteros desplazados)
+    std::vector<const double*> doubleChunk;
+
+    struct Md5;
+    std::unique_ptr<Md5> md5;
+    std::vector<juce::uint8> md5Scratch;
+
+    juce::int64 totalSamples = 0, nextFrame = 0;
+    juce::uint32 minFrameBytes = 0, maxFrameBytes = 0;
+    bool progressive = false, failed = false, finished = false;
+};
+
+// ==========================================================
+//  Lectura de FLAC en paralelo
+//
+//  El FlacReader de JUCE decodifica con libFLAC en un solo
+//  hilo, frame a frame. Aca el archivo (mapeado en memoria)
+//  se parte en segmentos de ~64k muestras que empiezan en un
+//  frame: los puntos del SEEKTABLE si hay, y entre ellos (o
+//  sin tabla) el primer frame desde una posicion en bytes,
+//  buscando el sync y validando la cabecera (CRC-8, campos
+//  iguales al STREAMINFO, numero de muestra en rango).
+//
+//  Cada segmento se decodifica en un hilo del pool propio a
+//  un buffer de una cola circular: read() pide el segmento
+//  que necesita y los siguientes (lectura anticipada, en
+//  orden) y espera solo si el suyo todavia no esta. Cada
+//  frame se verifica (CRC-16 y numero de muestra seguido al
+//  anterior): un limite falso o un archivo dañado es un error
+//  de lectura, no audio corrido.
+//
+//  Mismo resultado que el reader de JUCE (int32 justificado a
+//  la izquierda, misma escala a float / double).
+// ==========================================================
+class HZFlacReader
+{
+public:
+    /** nullptr si no aplica: el reader no es FLAC de un archivo, el
+        STREAMINFO no tiene el total de muestras o el stream tiene mas
+        de 24 bits u 8 canales. numThreads: hilos para decodificar. */
+    static std::unique_ptr<HZFlacReader> create(juce::AudioFormatReader& reader, int numThreads);
+
+    /** Espera los segmentos que sigan en el pool. */
+    ~HZFlacReader();
+
+    /** Como AudioFormatReader::read: numFrames desde start, en planar
+        (mas alla del final, ceros). */
+    template <typename SampleType>
+    bool read(SampleType* const* dest, int numChannels, juce::int64 start, int numFrames);
+
+    int getNumSegments() const noexcept { return (int) segments.size(); }
+    int getNumSeekPoints() const noexcept { return seekPointsUsed; }
+
+    struct StreamInfo
+    {
+        int minBlockSize = 0, maxBlockSize = 0;
+        int numChannels = 0, bitsPerSample = 0;
+        juce::int64 totalSamples = 0;
+        bool variableBlockSize = false;
+    };
+
+private:
+    struct Segment
+    {
+        juce::int64 offset = 0, end = 0;           // bytes (end: donde empieza el siguiente)
+        juce::int64 firstSample = 0, numSamples = 0;
+    };
+
+    // Un segmento decodificado: planar, justificado a la derecha
+    struct Slot
+    {
+        int segment = -1;
+        bool inFlight = false, ok = false;
+        juce::HeapBlock<int> samples;
+        juce::WaitableEvent done;
+    };
+
+    HZFlacReader(std::unique_ptr<juce::MemoryMappedFile> map, const StreamInfo& info, int numThreads);
+
+    bool buildSegments(juce::int64 firstFrame, const std::vector<std::pair<juce::int64, juce::int64>>& seekTable);
+    Slot& request(int segment);
+    void wait(Slot& slot);
+    bool decodeSegment(const Segment& segment, int* samples) const;
+
+    std::unique_ptr<juce::MemoryMappedFile> map;
+    const juce::uint8* data = nullptr;
+    juce::int64 dataSize = 0;
+    const StreamInfo info;
+
+    std::vector<Segment> segments;
+    int seekPointsUsed = 0;
+    int segmentCapacity = 0;                  // muestras por canal de cada buffer
+
+    std::unique_ptr<juce::ThreadPool> pool;   // nullptr con un solo hilo
+    std::vector<std::unique_ptr<Slot>> slots;
+};
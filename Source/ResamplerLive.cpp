@@ -0,0 +1,106 @@
+#include "ResamplerLive.h"
+#include <cmath>
+
+void HZLiveResampler::prepare(double hostRate, double targetRate, int maxBlockSize, int channels,
+                              HZPreset preset, HZPhaseResponse phase)
+{
+    toHost.reset();
+    toTarget.reset();
+
+    const auto down = HZRatio::fromRates(hostRate, targetRate);
+    const auto up   = HZRatio::fromRates(targetRate, hostRate);
+
+    if (! down.isValid() || channels <= 0 || maxBlockSize <= 0)
+        return;
+
+    numChannels = channels;
+    maxBlock    = maxBlockSize;
+
+    toTargetFilter = std::make_unique<HZPolyphaseFilter<float>>(down, preset, phase);
+    toHostFilter   = std::make_unique<HZPolyphaseFilter<float>>(up, preset, phase);
+
+    // Un solo hilo: el trabajo por bloque es chico y estamos en el hilo de audio
+    HZKernelVariant variant;
+    variant.isa = getCanonicalIsa();
+    variant.layout = HZChannelLayout::frameMajor;
+
+    toTarget = std::make_unique<HZResamplerEngine<float>>(*toTargetFilter, numChannels, variant);
+    toHost   = std::make_unique<HZResamplerEngine<float>>(*toHostFilter, numChannels, variant);
+
+    // Tras E muestras de entrada la cadena entrega al menos
+    // E - (lookA + (lookB + 1) / r + 1), con r = destino / host
+    const double r = down.toDouble();
+    primeFrames = (int) std::ceil(toTargetFilter->getLookahead() + (toHostFilter->getLookahead() + 1) / r) + 2;
+
+    latency = primeFrames + juce::roundToInt(toTargetFilter->getGroupDelay() + toHostFilter->getGroupDelay() / r);
+
+    const int targetCapacity = (int) std::ceil(maxBlock * r) + 2;
+    targetBuffer.setSize(numChannels, targetCapacity);
+    fifo.setSize(numChannels, primeFrames + 2 * maxBlock + 8);
+    inputPointers.malloc((size_t) numChannels);
+    fifoPointers.malloc((size_t) numChannels);
+
+    // Llenar los historiales una vez para que push() no reserve en el hilo de audio
+    toTarget->pushSilence(2 * (maxBlock + toTargetFilter->getNumTaps()));
+    toHost->pushSilence(2 * (targetCapacity + toHostFilter->getNumTaps()));
+
+    reset();
+}
+
+void HZLiveResampler::reset() noexcept
+{
+    if (! isPrepared())
+        return;
+
+    toTarget->reset();
+    toHost->reset();
+
+    fifo.clear();
+    fifoCount = primeFrames;
+}
+
+void HZLiveResampler::process(juce::AudioBuffer<float>& buffer) noexcept
+{
+    if (! isPrepared() || buffer.getNumChannels() != numChannels)
+        return;
+
+    const int total = buffer.getNumSamples();
+
+    for (int start = 0; start < total; start += maxBlock)
+        processChunk(buffer, start, juce::jmin(maxBlock, total - start));
+}
+
+void HZLiveResampler::processChunk(juce::AudioBuffer<float>& buffer, int start, int numFrames) noexcept
+{
+    for (int ch = 0; ch < numChannels; ++ch)
+        inputPointers[ch] = buffer.getReadPointer(ch, start);
+
+    // host -> destino
+    toTarget->pushInput(inputPointers.get(), numFrames);
+    const int targetFrames = toTarget->produce(targetBuffer.getArrayOfWritePointers(), targetBuffer.getNumSamples());
+
+    // destino -> host, a continuacion de lo que ya hay en la FIFO
+    toHost->pushInput(targetBuffer.getArrayOfReadPointers(), targetFrames);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+        fifoPointers[ch] = fifo.getWritePointer(ch, fifoCount);
+
+    fifoCount += toHost->produce(fifoPointers.get(), fifo.getNumSamples() - fifoCount);
+
+    // Sacar numFrames del frente; con el colchon inicial no deberia faltar nada
+    const int available = juce::jmin(numFrames, fifoCount);
+    jassert(available == numFrames);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        float* data = fifo.getWritePointer(ch);
+        buffer.copyFrom(ch, start, data, available);
+
+        if (available < numFrames)
+            buffer.clear(ch, start + available, numFrames - available);
+
+        std::copy(data + available, data + fifoCount, data);
+    }
+
+    fifoCount -= available;
+}
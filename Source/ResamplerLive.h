@@ -0,0 +1,52 @@
+#pragma once
+#include "JuceHeader.h"
+#include "ResamplerEngine.h"
+
+// ==========================================================
+//  Monitoreo en vivo dentro de processBlock
+//
+//  Lleva el audio del host a la frecuencia destino y de vuelta
+//  (host -> destino -> host) para escuchar la conversion en
+//  una sesion de grabacion. Con kernels de fase minima la
+//  latencia total es de unas pocas muestras; se reporta al
+//  host con getLatencySamples().
+// ==========================================================
+class HZLiveResampler
+{
+public:
+    /** Fuera del hilo de audio: diseña los kernels y reserva toda la memoria. */
+    void prepare(double hostRate, double targetRate, int maxBlockSize, int numChannels,
+                 HZPreset preset = HZPreset::standard,
+                 HZPhaseResponse phase = HZPhaseResponse::minimum);
+
+    /** Vacia historiales y vuelve a cargar el retardo inicial (sin reservas). */
+    void reset() noexcept;
+
+    bool isPrepared() const noexcept { return toHost != nullptr; }
+
+    /** In-place, en el hilo de audio. Con otra cantidad de canales
+        que la de prepare() el buffer pasa sin cambios. */
+    void process(juce::AudioBuffer<float>& buffer) noexcept;
+
+    /** Retardo total en muestras del host: colchon de la FIFO mas el
+        retardo de grupo de ambas etapas. */
+    int getLatencySamples() const noexcept { return latency; }
+
+private:
+    std::unique_ptr<HZPolyphaseFilter<float>> toTargetFilter, toHostFilter;
+    std::unique_ptr<HZResamplerEngine<float>> toTarget, toHost;
+
+    juce::AudioBuffer<float> targetBuffer;   // salida de la primera etapa
+    juce::AudioBuffer<float> fifo;           // salida a la frecuencia del host
+    int fifoCount = 0;
+
+    juce::HeapBlock<const float*> inputPointers;
+    juce::HeapBlock<float*> fifoPointers;
+
+    int numChannels = 0;
+    int maxBlock = 0;
+    int primeFrames = 0;   // ceros iniciales: cubren la entrada futura que piden los kernels
+    int latency = 0;
+
+    void processChunk(juce::AudioBuffer<float>& buffer, int start, int numFrames) noexcept;
+};
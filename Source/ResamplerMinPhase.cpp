@@ -0,0 +1,118 @@
+#include "ResamplerMinPhase.h"
+#include <cmath>
+#include <complex>
+
+namespace
+{
+    using Complex = std::complex<double>;
+
+    // FFT radix-2 en doble precision: juce::dsp::FFT es solo float y
+    // su ruido limita la atenuacion del kernel de mastering (120 dB).
+    void fft(std::vector<Complex>& data, bool inverse)
+    {
+        const size_t n = data.size();
+        jassert(juce::isPowerOfTwo(n));
+
+        for (size_t i = 1, j = 0; i < n; ++i)
+        {
+            size_t bit = n >> 1;
+
+            for (; (j & bit) != 0; bit >>= 1)
+                j ^= bit;
+
+            j |= bit;
+
+            if (i < j)
+                std::swap(data[i], data[j]);
+        }
+
+        const double sign = inverse ? 1.0 : -1.0;
+
+        for (size_t len = 2; len <= n; len <<= 1)
+        {
+            const double angle = sign * 2.0 * juce::MathConstants<double>::pi / (double) len;
+
+            for (size_t k = 0; k < len / 2; ++k)
+            {
+                const Complex w = std::polar(1.0, angle * (double) k);
+
+                for (size_t i = k; i < n; i += len)
+                {
+                    const Complex u = data[i];
+                    const Complex v = data[i + len / 2] * w;
+                    data[i]           = u + v;
+                    data[i + len / 2] = u - v;
+                }
+            }
+        }
+
+        if (inverse)
+            for (auto& x : data)
+                x /= (double) n;
+    }
+}
+
+std::vector<double> makeMinimumPhase(const std::vector<double>& linearPhase)
+{
+    const size_t length = linearPhase.size();
+
+    if (length < 2)
+        return linearPhase;
+
+    // Relleno amplio: el cepstrum de un kernel con ceros en la banda
+    // de rechazo decae lento y se solapa (aliasing) con FFT cortas
+    const size_t size = juce::nextPowerOfTwo((int) length) * (size_t) 8;
+    std::vector<Complex> spectrum(size);
+
+    for (size_t i = 0; i < length; ++i)
+        spectrum[i] = linearPhase[i];
+
+    fft(spectrum, false);
+
+    // log|H| con piso muy por debajo de la atenuacion de cualquier preset
+    double peak = 0.0;
+
+    for (const auto& x : spectrum)
+        peak = juce::jmax(peak, std::abs(x));
+
+    const double floor = peak * 1.0e-10;
+
+    for (auto& x : spectrum)
+        x = std::log(juce::jmax(floor, std::abs(x)));
+
+    fft(spectrum, true);   // cepstrum real
+
+    // Plegado: parte causal x2, anticausal a cero
+    for (size_t i = 1; i < size / 2; ++i)
+        spectrum[i] *= 2.0;
+
+    for (size_t i = size / 2 + 1; i < size; ++i)
+        spectrum[i] = 0.0;
+
+    fft(spectrum, false);
+
+    for (auto& x : spectrum)
+        x = std::exp(x);
+
+    fft(spectrum, true);
+
+    std::vector<double> result(length);
+
+    for (size_t i = 0; i < length; ++i)
+        result[i] = spectrum[i].real();
+
+    return result;
+}
+
+double getGroupDelayAtDc(const std::vector<double>& h)
+{
+    double moment = 0.0, sum = 0.0;
+
+    for (size_t i = 0; i < h.size(); ++i)
+    {
+        moment += (double) i * h[i];
+        sum    += h[i];
+    }
+
+    return sum != 0.0 ? moment / sum : 0.0;
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include "JuceHeader.h"
+#include <vector>
+
+// ==========================================================
+//  Conversion de FIR de fase lineal a fase minima
+//
+//  Metodo del cepstrum real: se conserva la magnitud y se
+//  reconstruye la fase minima a partir de log|H|. Solo se usa
+//  al construir la tabla (fuera del hilo de audio).
+// ==========================================================
+
+/** Mismo largo y misma respuesta de magnitud que linearPhase,
+    con la energia concentrada al principio. */
+std::vector<double> makeMinimumPhase(const std::vector<double>& linearPhase);
+
+/** Retardo de grupo en DC (en muestras): sum(n * h[n]) / sum(h[n]). */
+double getGroupDelayAtDc(const std::vector<double>& h);
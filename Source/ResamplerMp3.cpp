@@ -0,0 +1,515 @@
+#include "ResamplerMp3.h"
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+namespace
+{
+    constexpr int segmentSamples      = 1 << 17;   // muestras por segmento (aprox.)
+    constexpr int minWarmupFrames     = 2;
+    constexpr int trailingFrames      = 2;
+    constexpr int layer3DecoderDelay  = 529;
+
+    // ------------------------------------------------------
+    //  Cabecera de frame MPEG-1 / 2 / 2.5, capas I a III
+    // ------------------------------------------------------
+    constexpr short bitRates[2][3][16] =
+    {
+        { { 0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448, 0 },
+          { 0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384, 0 },
+          { 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 0 } },
+        { { 0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256, 0 },
+          { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160, 0 },
+          { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160, 0 } }
+    };
+
+    constexpr int sampleRates[3][3] =
+    {
+        { 44100, 48000, 32000 },   // MPEG-1
+        { 22050, 24000, 16000 },   // MPEG-2
+        { 11025, 12000, 8000 }     // MPEG-2.5
+    };
+
+    struct FrameHeader
+    {
+        int version = 0;           // 0: MPEG-1, 1: MPEG-2, 2: MPEG-2.5
+        int layer = 0;
+        int sampleRateIndex = 0;
+        int numChannels = 0;
+        int numBytes = 0;
+        bool crc = false;
+
+        bool isLsf() const noexcept { return version != 0; }
+        int getSampleRate() const noexcept { return sampleRates[version][sampleRateIndex]; }
+
+        int getSamplesPerFrame() const noexcept
+        {
+            return layer == 1 ? 384 : (layer == 3 && isLsf() ? 576 : 1152);
+        }
+
+        // Side info de capa III (sin la cabecera ni el CRC)
+        int getSideInfoBytes() const noexcept
+        {
+            return isLsf() ? (numChannels == 1 ? 9 : 17) : (numChannels == 1 ? 17 : 32);
+        }
+
+        bool isSameFormat(const FrameHeader& other) const noexcept
+        {
+            return version == other.version && layer == other.layer
+                && sampleRateIndex == other.sampleRateIndex && numChannels == other.numChannels;
+        }
+    };
+
+    // Las mismas reglas que el decoder de JUCE, sin bitrate libre
+    // (sin bitrate no hay tamaño de frame para saltar)
+    bool parseFrameHeader(const juce::uint8* p, FrameHeader& header) noexcept
+    {
+        const auto word = juce::ByteOrder::bigEndianInt(p);
+        const int versionBits  = (int) (word >> 19) & 3;
+        const int layerBits    = (int) (word >> 17) & 3;
+        const int bitRateIndex = (int) (word >> 12) & 15;
+        const int rateIndex    = (int) (word >> 10) & 3;
+
+        if ((word & 0xffe00000) != 0xffe00000 || versionBits == 1 || layerBits == 0
+             || bitRateIndex == 0 || bitRateIndex == 15 || rateIndex == 3 || (word & 3) == 2)
+            return false;
+
+        header.version         = versionBits == 3 ? 0 : (versionBits == 2 ? 1 : 2);
+        header.layer           = 4 - layerBits;
+        header.sampleRateIndex = rateIndex;
+        header.numChannels     = ((word >> 6) & 3) == 3 ? 1 : 2;
+        header.crc             = (word & 0x10000) == 0;
+
+        const int bitRate = bitRates[header.isLsf() ? 1 : 0][header.layer - 1][bitRateIndex] * 1000;
+        const int rate    = header.getSampleRate();
+        const int padding = (int) (word >> 9) & 1;
+
+        if (header.layer == 1)
+            header.numBytes = (12 * bitRate / rate + padding) * 4;
+        else if (header.layer == 2 || ! header.isLsf())
+            header.numBytes = 144 * bitRate / rate + padding;
+        else
+            header.numBytes = 72 * bitRate / rate + padding;
+
+        return true;
+    }
+
+    // main_data_begin: bytes del reservorio que usa el frame (capa III)
+    int getMainDataBegin(const juce::uint8* frame, const FrameHeader& header) noexcept
+    {
+        const auto* side = frame + 4 + (header.crc ? 2 : 0);
+        return header.isLsf() ? side[0] : ((side[0] << 1) | (side[1] >> 7));
+    }
+
+    // Datos del frame (capa III): lo que sigue a la cabecera, el CRC y el side info
+    int getMainDataOffset(const FrameHeader& header) noexcept
+    {
+        return 4 + (header.crc ? 2 : 0) + header.getSideInfoBytes();
+    }
+
+    // Lo que puede venir despues del ultimo frame: tags o un frame cortado
+    bool isStreamEnd(const juce::uint8* p, juce::int64 remaining, const FrameHeader& format) noexcept
+    {
+        const auto startsWith = [&](const char* tag)
+        {
+            const auto length = (juce::int64) std::strlen(tag);
+            return remaining >= length && std::memcmp(p, tag, (size_t) length) == 0;
+        };
+
+        FrameHeader header;
+
+        return remaining == 0 || startsWith("TAG") || startsWith("APETAGEX") || startsWith("LYRICS")
+            || startsWith("ID3")
+            || (remaining >= 4 && parseFrameHeader(p, header) && header.isSameFormat(format)
+                 && header.numBytes > remaining);
+    }
+
+    // ------------------------------------------------------
+    //  Tag Xing / Info (primer frame, sin audio) y LAME:
+    //  retardo del encoder y relleno, 12 bits cada uno
+    // ------------------------------------------------------
+    bool readXingTag(const juce::uint8* frame, const FrameHeader& header, int& encoderDelay, int& padding) noexcept
+    {
+        encoderDelay = padding = -1;
+
+        // Donde lo busca JUCE: despues del side info, sin contar el CRC
+        const int tagOffset = 4 + header.getSideInfoBytes();
+
+        if (header.layer != 3 || header.numBytes < tagOffset + 8)
+            return false;
+
+        const auto* tag = frame + tagOffset;
+
+        if (std::memcmp(tag, "Xing", 4) != 0 && std::memcmp(tag, "Info", 4) != 0)
+            return false;
+
+        const auto flags = juce::ByteOrder::bigEndianInt(tag + 4);
+        const int lameOffset = tagOffset + 8 + ((flags & 1) != 0 ? 4 : 0) + ((flags & 2) != 0 ? 4 : 0)
+                             + ((flags & 4) != 0 ? 100 : 0) + ((flags & 8) != 0 ? 4 : 0);
+
+        if (lameOffset + 24 <= header.numBytes)
+        {
+            const auto* lame = frame + lameOffset;
+
+            if (std::memcmp(lame, "LAME", 4) == 0 || std::memcmp(lame, "Lavf", 4) == 0
+                 || std::memcmp(lame, "Lavc", 4) == 0)
+            {
+                encoderDelay = (lame[21] << 4) | (lame[22] >> 4);
+                padding      = ((lame[22] & 15) << 8) | lame[23];
+            }
+        }
+
+        return true;
+    }
+}
+
+// ==========================================================
+//  HZMp3Reader
+// ==========================================================
+std::unique_ptr<HZMp3Reader> HZMp3Reader::create(juce::AudioFormatReader& reader, int numThreads)
+{
+   #if JUCE_USE_MP3AUDIOFORMAT
+    auto* fileStream = dynamic_cast<juce::FileInputStream*>(reader.input);
+
+    // Antes de mapear: cualquier otra entrada pasaria por aca en cada conversion
+    if (fileStream == nullptr || reader.getFormatName() != "MP3 file")
+        return nullptr;
+
+    auto map = std::make_unique<juce::MemoryMappedFile>(fileStream->getFile(), juce::MemoryMappedFile::readOnly);
+    const auto* data = static_cast<const juce::uint8*>(map->getData());
+    const auto size = (juce::int64) map->getSize();
+
+    if (data == nullptr || size < 10)
+        return nullptr;
+
+    // ID3v2 al principio: se salta igual que en el reader de JUCE
+    juce::int64 pos = 0;
+
+    if (std::memcmp(data, "ID3", 3) == 0 && data[3] != 0xff && ((data[6] | data[7] | data[8] | data[9]) & 0x80) == 0)
+        pos = 10 + (((juce::int64) data[6] << 21) | (data[7] << 14) | (data[8] << 7) | data[9]);
+
+    // Indice: de cabecera en cabecera, todas con el formato de la primera
+    FrameHeader format, header;
+
+    if (pos + 4 > size || ! parseFrameHeader(data + pos, format) || pos + format.numBytes > size)
+        return nullptr;
+
+    StreamInfo info;
+    info.layer           = format.layer;
+    info.samplesPerFrame = format.getSamplesPerFrame();
+    info.numChannels     = format.numChannels;
+
+    if (readXingTag(data + pos, format, info.encoderDelay, info.padding))
+        pos += format.numBytes;
+
+    std::vector<juce::int64> frameOffsets;
+    frameOffsets.reserve((size_t) (size / juce::jmax(1, format.numBytes)) + 1);
+
+    while (pos + 4 <= size && parseFrameHeader(data + pos, header) && header.isSameFormat(format)
+            && pos + header.numBytes <= size
+            && (header.layer != 3 || header.numBytes >= getMainDataOffset(header)))
+    {
+        frameOffsets.push_back(pos);
+        pos += header.numBytes;
+    }
+
+    // Basura entre frames (el decoder de JUCE la saltea buscando el
+    // sync; aca no hay indice fiable): queda el reader de JUCE
+    if (frameOffsets.empty() || ! isStreamEnd(data + pos, size - pos, format)
+         || format.numChannels != (int) reader.numChannels
+         || format.getSampleRate() != (int) reader.sampleRate)
+        return nullptr;
+
+    // El decoder no da el primer frame si usa reservorio (no hay de donde)
+    parseFrameHeader(data + frameOffsets.front(), header);
+    const bool firstFrameSilent = header.layer == 3 && getMainDataBegin(data + frameOffsets.front(), header) > 0;
+
+    frameOffsets.push_back(pos);
+
+    std::unique_ptr<HZMp3Reader> mp3(new HZMp3Reader(std::move(map), info, std::move(frameOffsets),
+                                                     firstFrameSilent, numThreads));
+
+    if (mp3->numSamples <= 0)
+        return nullptr;
+
+    return mp3;
+   #else
+    juce::ignoreUnused(reader, numThreads);
+    return nullptr;
+   #endif
+}
+
+HZMp3Reader::HZMp3Reader(std::unique_ptr<juce::MemoryMappedFile> file, const StreamInfo& streamInfo,
+                         std::vector<juce::int64> offsets, bool firstFrameSilent, int numThreads)
+    : map(std::move(file)),
+      data(static_cast<const juce::uint8*>(map->getData())),
+      dataSize((juce::int64) map->getSize()),
+      info(streamInfo),
+      frameOffsets(std::move(offsets)),
+      skipFirst(firstFrameSilent ? 1 : 0),
+      primerFrames(info.layer == 3 ? 1 : 0)
+{
+    const int spf = info.samplesPerFrame;
+    const auto numMpegFrames = (juce::int64) getNumMpegFrames();
+
+    // Un paso de la ventana de sintesis cada 32 muestras, 16 pasos
+    phasePeriod = 16 / std::gcd(16, spf / 32);
+
+    rawSamples = (numMpegFrames - skipFirst) * spf;
+
+    if (info.layer == 3 && info.encoderDelay >= 0)
+    {
+        startOffset = info.encoderDelay + layer3DecoderDelay - skipFirst * spf;
+        numSamples  = numMpegFrames * spf - info.encoderDelay - info.padding;
+    }
+    else
+    {
+        numSamples = rawSamples;
+    }
+
+    framesPerSegment = juce::jmax(1, segmentSamples / spf);
+    segmentCapacity  = framesPerSegment * spf;
+
+    const int threads = juce::jmax(1, numThreads);
+
+    if (threads > 1)
+        pool = std::make_unique<juce::ThreadPool>(threads);
+
+    // Cola: el segmento que se lee y los que se decodifican por adelantado
+    slots.resize((size_t) juce::jmax(2, threads * 2));
+
+    for (auto& slot : slots)
+    {
+        slot = std::make_unique<Slot>();
+        slot->samples.malloc((size_t) info.numChannels * (size_t) segmentCapacity);
+    }
+}
+
+HZMp3Reader::~HZMp3Reader()
+{
+    for (auto& slot : slots)
+        wait(*slot);
+}
+
+int HZMp3Reader::getNumSegments() const noexcept
+{
+    return (getNumMpegFrames() + framesPerSegment - 1) / framesPerSegment;
+}
+
+int HZMp3Reader::getWarmupStart(int frame) const noexcept
+{
+    // Misma fase de sintesis que decodificando desde el principio: los
+    // frames que sintetiza el tramo antes de 'frame' (el del reservorio
+    // incluido) son congruentes con los de todo el archivo
+    int start = frame - minWarmupFrames;
+
+    while (start > 0 && (start - skipFirst - primerFrames) % phasePeriod != 0)
+        --start;
+
+    return start > 0 ? start : -1;   // -1: desde el principio del archivo
+}
+
+void HZMp3Reader::writePrimerFrame(juce::MemoryOutputStream& out, int frame) const
+{
+    const auto* first = data + frameOffsets[(size_t) frame];
+    FrameHeader header;
+    parseFrameHeader(first, header);
+
+    // La cabecera del frame con el bitrate mas alto, sin relleno ni CRC:
+    // entra el reservorio mas grande (511 bytes, 255 en MPEG-2 / 2.5)
+    const auto word = (juce::ByteOrder::bigEndianInt(first) & ~0xf200u) | 0x1e000u;
+    const juce::uint8 primer[4] = { (juce::uint8) (word >> 24), (juce::uint8) (word >> 16),
+                                    (juce::uint8) (word >> 8), (juce::uint8) word };
+
+    FrameHeader primerHeader;
+    parseFrameHeader(primer, primerHeader);
+
+    const int mainBytes = primerHeader.numBytes - getMainDataOffset(primerHeader);
+    const int reservoir = juce::jmin(getMainDataBegin(first, header), mainBytes);
+
+    // Los ultimos bytes de datos antes del frame, de atras para adelante
+    // (sin cabeceras ni side info); antes del primer frame, ceros
+    juce::HeapBlock<juce::uint8> tail((size_t) mainBytes, true);
+    int end = mainBytes;
+
+    for (int f = frame - 1; f >= 0 && end > mainBytes - reservoir; --f)
+    {
+        const auto* previous = data + frameOffsets[(size_t) f];
+        parseFrameHeader(previous, header);
+
+        const int available = header.numBytes - getMainDataOffset(header);
+        const int n = juce::jmin(end - (mainBytes - reservoir), available);
+        end -= n;
+        std::memcpy(tail + end, previous + header.numBytes - n, (size_t) n);
+    }
+
+    // Side info en cero: sin reservorio, granulos vacios (silencio)
+    out.write(primer, 4);
+    out.writeRepeatedByte(0, (size_t) primerHeader.getSideInfoBytes());
+    out.write(tail, (size_t) mainBytes);
+}
+
+juce::int64 HZMp3Reader::getSegmentStart(int segment) const noexcept
+{
+    if (segment >= getNumSegments())
+        return rawSamples;
+
+    return segment == 0 ? 0 : ((juce::int64) segment * framesPerSegment - skipFirst) * info.samplesPerFrame;
+}
+
+bool HZMp3Reader::decodeSegment(int segment, float* samples) const
+{
+   #if JUCE_USE_MP3AUDIOFORMAT
+    const int numMpegFrames = getNumMpegFrames();
+    const int spf = info.samplesPerFrame;
+    const int first = segment * framesPerSegment;
+    const int last = juce::jmin(numMpegFrames, first + framesPerSegment);
+    const int warmup = getWarmupStart(first);
+
+    // Desde el principio (ID3, Xing) o desde el frame de precalentamiento
+    // con el del reservorio delante, hasta un par de frames despues: el
+    // decoder de JUCE deja en cero el ultimo frame si el stream termina
+    // justo ahi. El ultimo segmento llega hasta el final del archivo,
+    // igual que de corrido.
+    const auto from = warmup < 0 ? (juce::int64) 0 : frameOffsets[(size_t) warmup];
+    const auto to = last + trailingFrames < numMpegFrames ? frameOffsets[(size_t) (last + trailingFrames)] : dataSize;
+
+    auto discard = (juce::int64) spf * (warmup < 0 ? juce::jmax(0, first - skipFirst)
+                                                   : primerFrames + first - warmup);
+    const int count = spf * (last - juce::jmax(first, skipFirst));
+
+    std::unique_ptr<juce::InputStream> input;
+
+    if (warmup < 0 || primerFrames == 0)
+    {
+        input = std::make_unique<juce::MemoryInputStream>(data + from, (size_t) (to - from), false);
+    }
+    else
+    {
+        auto block = std::make_unique<juce::MemoryOutputStream>((size_t) (to - from) + 2048);
+        writePrimerFrame(*block, warmup);
+        block->write(data + from, (size_t) (to - from));
+        input = std::make_unique<juce::MemoryInputStream>(block->getMemoryBlock(), true);
+    }
+
+    std::unique_ptr<juce::AudioFormatReader> decoder(juce::MP3AudioFormat().createReaderFor(input.release(), true));
+
+    if (decoder == nullptr)
+        return false;
+
+    // El decoder escribe float en los int* de readSamples
+    int* channels[2];
+
+    for (int ch = 0; ch < info.numChannels; ++ch)
+        channels[ch] = reinterpret_cast<int*>(samples + (size_t) ch * (size_t) segmentCapacity);
+
+    juce::int64 position = 0;
+
+    while (discard > 0)
+    {
+        const int n = (int) juce::jmin(discard, (juce::int64) segmentCapacity);
+
+        if (! decoder->readSamples(channels, info.numChannels, 0, position, n))
+            return false;
+
+        position += n;
+        discard -= n;
+    }
+
+    return decoder->readSamples(channels, info.numChannels, 0, position, count);
+   #else
+    juce::ignoreUnused(segment, samples);
+    return false;
+   #endif
+}
+
+HZMp3Reader::Slot& HZMp3Reader::request(int segment)
+{
+    auto& slot = *slots[(size_t) segment % slots.size()];
+
+    if (slot.segment == segment)
+        return slot;
+
+    wait(slot);
+    slot.segment = segment;
+
+    if (pool == nullptr)
+    {
+        slot.ok = decodeSegment(segment, slot.samples);
+        return slot;
+    }
+
+    slot.inFlight = true;
+
+    pool->addJob([this, &slot, segment]
+    {
+        slot.ok = decodeSegment(segment, slot.samples);
+        slot.done.signal();
+    });
+
+    return slot;
+}
+
+void HZMp3Reader::wait(Slot& slot)
+{
+    if (slot.inFlight)
+    {
+        slot.done.wait();
+        slot.inFlight = false;
+    }
+}
+
+template <typename SampleType>
+bool HZMp3Reader::read(SampleType* const* dest, int numChannels, juce::int64 start, int numFrames)
+{
+    jassert(numChannels == info.numChannels);
+
+    const int spf = info.samplesPerFrame;
+    const int numSegments = getNumSegments();
+
+    // Lo que hay: dentro del largo y de lo que da el decoder (con tag, el
+    // principio del retardo y el final del relleno quedan afuera)
+    const auto lower = juce::jmax((juce::int64) 0, -startOffset);
+    const auto upper = juce::jmin(numSamples, rawSamples - startOffset);
+    const int begin = (int) juce::jlimit((juce::int64) 0, (juce::int64) numFrames, lower - start);
+    const int end   = (int) juce::jlimit((juce::int64) begin, (juce::int64) numFrames, upper - start);
+
+    for (int done = begin; done < end;)
+    {
+        const auto position = start + done + startOffset;
+        const int index = (int) ((position / spf + skipFirst) / framesPerSegment);
+
+        // El que hace falta y los siguientes, en orden
+        auto& slot = request(index);
+
+        for (int ahead = 1; ahead < (int) slots.size() && index + ahead < numSegments; ++ahead)
+            request(index + ahead);
+
+        wait(slot);
+
+        if (! slot.ok)
+            return false;
+
+        const auto offset = position - getSegmentStart(index);
+        const int n = (int) juce::jmin((juce::int64) (end - done), getSegmentStart(index + 1) - position);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            const auto* in = slot.samples + (size_t) ch * (size_t) segmentCapacity + (size_t) offset;
+            std::copy(in, in + n, dest[ch] + done);
+        }
+
+        done += n;
+    }
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        std::fill(dest[ch], dest[ch] + begin, SampleType());
+        std::fill(dest[ch] + end, dest[ch] + numFrames, SampleType());
+    }
+
+    return true;
+}
+
+template bool HZMp3Reader::read<float>(float* const*, int, juce::int64, int);
+template bool HZMp3Reader::read<double>(double* const*, int, juce::int64, int);
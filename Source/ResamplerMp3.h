@@ -0,0 +1,117 @@
+#pragma once
+#include "JuceHeader.h"
+
+// ==========================================================
+//  Lectura de MP3 en paralelo
+//
+//  El MP3Reader de JUCE decodifica frame a frame en un solo
+//  hilo y para buscar vuelve a empezar. Aca el archivo
+//  (mapeado en memoria) se indexa de una pasada saltando de
+//  cabecera en cabecera (todas iguales en capa, version,
+//  frecuencia y canales), y se parte en segmentos de frames
+//  que se decodifican en hilos del pool propio, cada uno con
+//  el decoder de JUCE sobre su tramo de bytes.
+//
+//  Cada segmento arranca unos frames antes (precalentado:
+//  el solapamiento del IMDCT con el granulo anterior y la
+//  ventana de sintesis) y esas muestras se descartan. El
+//  primer frame del tramo se elige para que la fase de la
+//  ventana de sintesis (un paso cada 32 muestras) sea la
+//  misma que decodificando desde el principio.
+//
+//  Reservorio de bits (capa III): los datos de un frame
+//  pueden empezar hasta 511 bytes antes de su cabecera, y el
+//  decoder de JUCE solo los busca al final del frame
+//  anterior. Delante del tramo va un frame sin audio (side
+//  info en cero, el bitrate mas alto del formato) que lleva
+//  al final esos bytes, copiados del indice: el primer frame
+//  de verdad ya decodifica entero. Ese frame da un bloque de
+//  silencio que se descarta con el precalentamiento.
+//
+//  Con eso cada segmento sale igual bit a bit que el mismo
+//  tramo decodificado de corrido desde el principio.
+//
+//  Con tag Xing / Info + LAME se descuentan el retardo del
+//  encoder (mas los 529 del decoder de capa III) al
+//  principio y el relleno al final: el largo es el del audio
+//  original. Sin tag, el largo es frames x muestras por frame.
+//
+//  read() pide el segmento que necesita y los siguientes
+//  (lectura anticipada, en orden) y espera solo si el suyo
+//  todavia no esta; cualquier posicion se lee sin recorrer
+//  el archivo desde el principio.
+// ==========================================================
+class HZMp3Reader
+{
+public:
+    /** nullptr si no aplica: el reader no es de MP3 o no lee de un
+        archivo, el archivo no es un stream MPEG de audio de punta a
+        punta (basura entre frames, bitrate libre, cabeceras que cambian
+        de formato) o no hay decoder de MP3 (JUCE_USE_MP3AUDIOFORMAT).
+        numThreads: hilos para decodificar. */
+    static std::unique_ptr<HZMp3Reader> create(juce::AudioFormatReader& reader, int numThreads);
+
+    /** Espera los segmentos que sigan en el pool. */
+    ~HZMp3Reader();
+
+    /** Como AudioFormatReader::read: numFrames desde start, en planar
+        (mas alla del final, ceros). */
+    template <typename SampleType>
+    bool read(SampleType* const* dest, int numChannels, juce::int64 start, int numFrames);
+
+    /** Muestras por canal (sin retardo ni relleno si hay tag LAME). */
+    juce::int64 getNumFrames() const noexcept { return numSamples; }
+    int getNumSegments() const noexcept;
+    int getNumMpegFrames() const noexcept { return (int) frameOffsets.size() - 1; }
+
+    /** -1 sin tag LAME. */
+    int getEncoderDelay() const noexcept { return info.encoderDelay; }
+    int getPadding() const noexcept { return info.padding; }
+
+    struct StreamInfo
+    {
+        int layer = 0;
+        int samplesPerFrame = 0;
+        int numChannels = 0;
+        int encoderDelay = -1, padding = -1;
+    };
+
+private:
+    // Un segmento decodificado: planar, float (lo que da el decoder)
+    struct Slot
+    {
+        int segment = -1;
+        bool inFlight = false, ok = false;
+        juce::HeapBlock<float> samples;
+        juce::WaitableEvent done;
+    };
+
+    HZMp3Reader(std::unique_ptr<juce::MemoryMappedFile> map, const StreamInfo& info,
+                std::vector<juce::int64> frameOffsets, bool firstFrameSilent, int numThreads);
+
+    int getWarmupStart(int frame) const noexcept;
+    void writePrimerFrame(juce::MemoryOutputStream& out, int frame) const;
+    juce::int64 getSegmentStart(int segment) const noexcept;
+    Slot& request(int segment);
+    void wait(Slot& slot);
+    bool decodeSegment(int segment, float* samples) const;
+
+    std::unique_ptr<juce::MemoryMappedFile> map;
+    const juce::uint8* data = nullptr;
+    juce::int64 dataSize = 0;
+    const StreamInfo info;
+
+    // Frames de audio (sin el de Xing / Info): offset de cada uno y el
+    // final del ultimo
+    const std::vector<juce::int64> frameOffsets;
+
+    const int skipFirst;                      // el decoder no da el primer frame (reservorio)
+    const int primerFrames;                   // 1 en capa III: el frame con el reservorio
+    int phasePeriod = 1;                      // frames hasta repetir la fase de sintesis
+    int framesPerSegment = 0, segmentCapacity = 0;
+    juce::int64 rawSamples = 0;               // lo que da el decoder
+    juce::int64 startOffset = 0, numSamples = 0;
+
+    std::unique_ptr<juce::ThreadPool> pool;   // nullptr con un solo hilo
+    std::vector<std::unique_ptr<Slot>> slots;
+};
@@ -0,0 +1,1466 @@
+#include "ResamplerPcm.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+#if JUCE_USE_SSE_INTRINSICS
+ #include <immintrin.h>
+#elif JUCE_USE_ARM_NEON
+ #include <arm_neon.h>
+#endif
+
+#if JUCE_USE_SSE_INTRINSICS && (JUCE_GCC || JUCE_CLANG)
+ #define HZ_SSSE3_TARGET __attribute__((target("ssse3")))
+#else
+ #define HZ_SSSE3_TARGET
+#endif
+
+namespace
+{
+    // Muestras por tramo: int32 desempaquetados + bytes crudos en L1/L2
+    constexpr int chunkSamples = 4096;
+
+    int chunkId(const char* name) noexcept
+    {
+        return (int) juce::ByteOrder::littleEndianInt(name);
+    }
+
+    // ------------------------------------------------------
+    //  Mascara de desempaque: 4 muestras de bytesPerSample
+    //  bytes -> 4 int32 con la muestra en los bytes altos
+    //  (0x80 = cero). En big endian los bytes van invertidos.
+    // ------------------------------------------------------
+    struct ShuffleMask
+    {
+        alignas(16) juce::uint8 bytes[16];
+
+        ShuffleMask(int bytesPerSample, bool bigEndian) noexcept
+        {
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                for (int b = 0; b < 4; ++b)
+                {
+                    const int fromLow = b - (4 - bytesPerSample);   // byte de la muestra, desde el menos significativo
+                    const int source  = bigEndian ? bytesPerSample - 1 - fromLow : fromLow;
+
+                    bytes[lane * 4 + b] = fromLow < 0 ? (juce::uint8) 0x80
+                                                      : (juce::uint8) (lane * bytesPerSample + source);
+                }
+            }
+        }
+    };
+
+   #if JUCE_USE_SSE_INTRINSICS
+    HZ_SSSE3_TARGET int unpackSsse3(const juce::uint8* src, int* dst, int numSamples, int bytesPerSample,
+                                    const ShuffleMask& mask) noexcept
+    {
+        const __m128i m = _mm_load_si128(reinterpret_cast<const __m128i*>(mask.bytes));
+        const int numBytes = numSamples * bytesPerSample;
+        int i = 0;
+
+        // Carga de 16 bytes aunque se usen 8 o 12: sin pasar del final del tramo
+        for (; i * bytesPerSample + 16 <= numBytes; i += 4)
+        {
+            const __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * bytesPerSample));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_shuffle_epi8(raw, m));
+        }
+
+        return i;
+    }
+
+    // Local: la deteccion de CPU de JUCE tambien es un estatico
+    bool hasSsse3() noexcept
+    {
+        static const bool available = juce::SystemStats::hasSSSE3();
+        return available;
+    }
+   #endif
+
+    // Bytes crudos -> int32 justificado a la izquierda (o bits del float)
+    void unpackSamples(const juce::uint8* src, int* dst, int numSamples, int bytesPerSample, bool bigEndian,
+                       const ShuffleMask& mask) noexcept
+    {
+        int i = 0;
+
+       #if JUCE_USE_SSE_INTRINSICS
+        if (hasSsse3())
+            i = unpackSsse3(src, dst, numSamples, bytesPerSample, mask);
+       #elif JUCE_USE_ARM_NEON && defined (__aarch64__)
+        const uint8x16_t m = vld1q_u8(mask.bytes);
+
+        for (; i * bytesPerSample + 16 <= numSamples * bytesPerSample; i += 4)
+            vst1q_u8(reinterpret_cast<juce::uint8*>(dst + i), vqtbl1q_u8(vld1q_u8(src + i * bytesPerSample), m));
+       #else
+        juce::ignoreUnused(mask);
+       #endif
+
+        for (; i < numSamples; ++i)
+        {
+            const juce::uint8* s = src + i * bytesPerSample;
+            juce::uint32 v = 0;
+
+            for (int b = 0; b < bytesPerSample; ++b)
+                v |= (juce::uint32) s[bigEndian ? bytesPerSample - 1 - b : b] << (8 * (4 - bytesPerSample + b));
+
+            dst[i] = (int) v;
+        }
+    }
+
+    // ------------------------------------------------------
+    //  Desintercalado + escala. El factor es el de JUCE en
+    //  cada precision (float: 1 / 0x7fffffff, como
+    //  convertFixedToFloat; double: 1 / 2^31, como el
+    //  BlockReader de doble). Mono y estereo en SSE2; con mas
+    //  canales, frame a frame (lectura contigua del tramo).
+    // ------------------------------------------------------
+    template <typename SampleType, bool isFloat>
+    SampleType toSample(int v) noexcept
+    {
+        if constexpr (isFloat)
+        {
+            float f;
+            std::memcpy(&f, &v, sizeof(float));
+            return (SampleType) f;
+        }
+        else if constexpr (std::is_same_v<SampleType, float>)
+        {
+            return (float) v * (1.0f / (float) 0x7fffffff);
+        }
+        else
+        {
+            return v * (1.0 / 2147483648.0);
+        }
+    }
+
+    template <typename SampleType, bool isFloat>
+    void toPlanarScalar(const int* src, SampleType* const* dest, int numChannels, int offset,
+                        int first, int numFrames) noexcept
+    {
+        if (numChannels > 2)
+        {
+            for (int i = first; i < numFrames; ++i)
+                for (int ch = 0; ch < numChannels; ++ch)
+                    dest[ch][offset + i] = toSample<SampleType, isFloat>(src[i * numChannels + ch]);
+
+            return;
+        }
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            for (int i = first; i < numFrames; ++i)
+                dest[ch][offset + i] = toSample<SampleType, isFloat>(src[i * numChannels + ch]);
+    }
+
+    template <typename SampleType>
+    void toPlanar(const int* src, SampleType* const* dest, int numChannels, int offset, int numFrames, bool isFloat) noexcept
+    {
+        int done = 0;
+
+       #if JUCE_USE_SSE_INTRINSICS
+        if constexpr (std::is_same_v<SampleType, float>)
+        {
+            const __m128 scale = _mm_set1_ps(1.0f / (float) 0x7fffffff);
+
+            if (numChannels <= 2)
+                done = numFrames & ~3;
+
+            for (int ch = 0; ch < numChannels && done > 0; ++ch)
+            {
+                float* out = dest[ch] + offset;
+
+                const auto store = [out, isFloat, scale](int index, __m128 bits) noexcept
+                {
+                    _mm_storeu_ps(out + index, isFloat ? bits : _mm_mul_ps(_mm_cvtepi32_ps(_mm_castps_si128(bits)), scale));
+                };
+
+                if (numChannels == 1)
+                {
+                    for (int i = 0; i < done; i += 4)
+                        store(i, _mm_loadu_ps(reinterpret_cast<const float*>(src + i)));
+                }
+                else
+                {
+                    // L R L R | L R L R -> L L L L (o R R R R)
+                    for (int i = 0; i < done; i += 4)
+                    {
+                        const __m128 a = _mm_loadu_ps(reinterpret_cast<const float*>(src + 2 * i));
+                        const __m128 b = _mm_loadu_ps(reinterpret_cast<const float*>(src + 2 * i + 4));
+                        store(i, ch == 0 ? _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0))
+                                         : _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+                    }
+                }
+            }
+        }
+       #endif
+
+        if (isFloat)
+            toPlanarScalar<SampleType, true>(src, dest, numChannels, offset, done, numFrames);
+        else
+            toPlanarScalar<SampleType, false>(src, dest, numChannels, offset, done, numFrames);
+    }
+
+    // ------------------------------------------------------
+    //  Escritura: planar -> intercalado (int32) -> bytes.
+    //  La mascara de empaque es la inversa de ShuffleMask:
+    //  de cada int32 justificado quedan los bytesPerSample
+    //  bytes altos, en little endian y uno detras de otro.
+    // ------------------------------------------------------
+    constexpr int quantizeChunk = 256;
+    constexpr int writeBlockBytes = 65536;
+
+    struct PackMask
+    {
+        alignas(16) juce::uint8 bytes[16];
+
+        explicit PackMask(int bytesPerSample) noexcept
+        {
+            for (int k = 0; k < 16; ++k)
+                bytes[k] = k < 4 * bytesPerSample ? (juce::uint8) ((k / bytesPerSample) * 4 + 4 - bytesPerSample + k % bytesPerSample)
+                                                  : (juce::uint8) 0x80;
+        }
+    };
+
+   #if JUCE_USE_SSE_INTRINSICS
+    HZ_SSSE3_TARGET int packSsse3(const int* src, juce::uint8* dst, int numSamples, int bytesPerSample,
+                                  const PackMask& mask) noexcept
+    {
+        const __m128i m = _mm_load_si128(reinterpret_cast<const __m128i*>(mask.bytes));
+        const int numBytes = numSamples * bytesPerSample;
+        int i = 0;
+
+        // Escribe 16 bytes aunque valgan 8 o 12: el resto lo pisa la vuelta siguiente
+        for (; i * bytesPerSample + 16 <= numBytes; i += 4)
+        {
+            const __m128i q = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * bytesPerSample), _mm_shuffle_epi8(q, m));
+        }
+
+        return i;
+    }
+   #endif
+
+    void packSamples(const int* src, juce::uint8* dst, int numSamples, int bytesPerSample, const PackMask& mask) noexcept
+    {
+        int i = 0;
+
+       #if JUCE_USE_SSE_INTRINSICS
+        if (hasSsse3())
+            i = packSsse3(src, dst, numSamples, bytesPerSample, mask);
+       #elif JUCE_USE_ARM_NEON && defined (__aarch64__)
+        const uint8x16_t m = vld1q_u8(mask.bytes);
+
+        for (; i * bytesPerSample + 16 <= numSamples * bytesPerSample; i += 4)
+            vst1q_u8(dst + i * bytesPerSample, vqtbl1q_u8(vld1q_u8(reinterpret_cast<const juce::uint8*>(src + i)), m));
+       #else
+        juce::ignoreUnused(mask);
+       #endif
+
+        for (; i < numSamples; ++i)
+        {
+            const auto v = (juce::uint32) src[i];
+
+            for (int b = 0; b < bytesPerSample; ++b)
+                dst[i * bytesPerSample + b] = (juce::uint8) (v >> (8 * (4 - bytesPerSample + b)));
+        }
+    }
+
+    template <int bytesPerSample>
+    void packStrided(const int* in, juce::uint8* out, int stride, int numFrames) noexcept
+    {
+        for (int i = 0; i < numFrames; ++i, out += stride)
+        {
+            // Los bytes altos del int32 justificado, en little endian
+            const auto v = juce::ByteOrder::swapIfBigEndian((juce::uint32) in[i]);
+            std::memcpy(out, reinterpret_cast<const juce::uint8*>(&v) + 4 - bytesPerSample, bytesPerSample);
+        }
+    }
+
+    // ------------------------------------------------------
+    //  Formatos de palabra completa (int32, float, double): no
+    //  hay bytes que descartar, solo intercalar palabras de 4
+    //  u 8 bytes. Mono es una copia; estereo, unpack de SSE2.
+    // ------------------------------------------------------
+    template <typename T>
+    inline void storeLittleEndian(juce::uint8* dst, T value) noexcept
+    {
+        std::memcpy(dst, &value, sizeof(T));
+
+       #if JUCE_BIG_ENDIAN
+        std::reverse(dst, dst + sizeof(T));
+       #endif
+    }
+
+    template <typename T>
+    void interleaveWords(const T* const* src, juce::uint8* dst, int numChannels, int numFrames) noexcept
+    {
+        static_assert(sizeof(T) == 4 || sizeof(T) == 8, "palabras de 4 u 8 bytes");
+        int i = 0;
+
+       #if JUCE_LITTLE_ENDIAN
+        if (numChannels == 1)
+        {
+            std::memcpy(dst, src[0], (size_t) numFrames * sizeof(T));
+            return;
+        }
+       #endif
+
+       #if JUCE_USE_SSE_INTRINSICS
+        if (numChannels == 2)
+        {
+            constexpr int step = 16 / (int) sizeof(T);
+
+            for (; i + step <= numFrames; i += step)
+            {
+                const __m128i l = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src[0] + i));
+                const __m128i r = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src[1] + i));
+                auto* out = reinterpret_cast<__m128i*>(dst + (size_t) i * 2 * sizeof(T));
+
+                if constexpr (sizeof(T) == 4)
+                {
+                    _mm_storeu_si128(out,     _mm_unpacklo_epi32(l, r));
+                    _mm_storeu_si128(out + 1, _mm_unpackhi_epi32(l, r));
+                }
+                else
+                {
+                    _mm_storeu_si128(out,     _mm_unpacklo_epi64(l, r));
+                    _mm_storeu_si128(out + 1, _mm_unpackhi_epi64(l, r));
+                }
+            }
+        }
+       #endif
+
+        for (; i < numFrames; ++i)
+            for (int ch = 0; ch < numChannels; ++ch)
+                storeLittleEndian(dst + ((size_t) i * (size_t) numChannels + (size_t) ch) * sizeof(T), src[ch][i]);
+    }
+
+    // Salida float en la otra precision del motor. Sin recorte:
+    // cvtpd_ps redondea al mas cercano, igual que el cast
+    template <typename Out, typename In>
+    void convertSamples(const In* in, Out* out, int numSamples) noexcept
+    {
+        int i = 0;
+
+       #if JUCE_USE_SSE_INTRINSICS
+        if constexpr (std::is_same_v<In, double>)
+        {
+            for (; i + 4 <= numSamples; i += 4)
+                _mm_storeu_ps(out + i, _mm_movelh_ps(_mm_cvtpd_ps(_mm_loadu_pd(in + i)),
+                                                     _mm_cvtpd_ps(_mm_loadu_pd(in + i + 2))));
+        }
+        else
+        {
+            for (; i + 4 <= numSamples; i += 4)
+            {
+                const __m128 x = _mm_loadu_ps(in + i);
+                _mm_storeu_pd(out + i,     _mm_cvtps_pd(x));
+                _mm_storeu_pd(out + i + 2, _mm_cvtps_pd(_mm_movehl_ps(x, x)));
+            }
+        }
+       #endif
+
+        for (; i < numSamples; ++i)
+            out[i] = (Out) in[i];
+    }
+
+    template <typename Out, typename In>
+    void packFloat(const In* const* in, std::vector<const Out*>& channels, std::vector<Out>& scratch,
+                   juce::uint8* dst, int numChannels, int numFrames) noexcept
+    {
+        if constexpr (std::is_same_v<In, Out>)
+        {
+            juce::ignoreUnused(channels, scratch);
+            interleaveWords(in, dst, numChannels, numFrames);
+        }
+        else
+        {
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                Out* converted = scratch.data() + (size_t) ch * (size_t) quantizeChunk;
+                convertSamples(in[ch], converted, numFrames);
+                channels[(size_t) ch] = converted;
+            }
+
+            interleaveWords(channels.data(), dst, numChannels, numFrames);
+        }
+    }
+
+    // Mono y estereo: intercalado SSE2 en scratch + empaque SIMD.
+    // Con mas canales, cada canal va directo a sus bytes (una pasada)
+    void packInterleaved(const int* const* src, int* scratch, juce::uint8* dst, int numChannels, int numFrames,
+                         int bytesPerSample, const PackMask& mask) noexcept
+    {
+        if (bytesPerSample == 4)
+        {
+            interleaveWords(src, dst, numChannels, numFrames);
+            return;
+        }
+
+        if (numChannels > 2)
+        {
+            const int stride = numChannels * bytesPerSample;
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                if (bytesPerSample == 2)
+                    packStrided<2>(src[ch], dst + ch * 2, stride, numFrames);
+                else
+                    packStrided<3>(src[ch], dst + ch * 3, stride, numFrames);
+            }
+
+            return;
+        }
+
+        const int* interleaved = src[0];
+        int i = 0;
+
+        if (numChannels == 2)
+        {
+           #if JUCE_USE_SSE_INTRINSICS
+            for (; i + 4 <= numFrames; i += 4)
+            {
+                const __m128i l = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src[0] + i));
+                const __m128i r = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src[1] + i));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(scratch + 2 * i),     _mm_unpacklo_epi32(l, r));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(scratch + 2 * i + 4), _mm_unpackhi_epi32(l, r));
+            }
+           #endif
+
+            for (; i < numFrames; ++i)
+            {
+                scratch[2 * i]     = src[0][i];
+                scratch[2 * i + 1] = src[1][i];
+            }
+
+            interleaved = scratch;
+        }
+
+        packSamples(interleaved, dst, numFrames * numChannels, bytesPerSample, mask);
+    }
+
+    // dwChannelMask del WavAudioFormatWriter de JUCE (canonicalWavChannelSet):
+    // 0 en mono, estereo y mas de 8 canales (sin WAVE_FORMAT_EXTENSIBLE)
+    int getWavChannelMask(int numChannels) noexcept
+    {
+        switch (numChannels)
+        {
+            case 3:  return 0x07;   // L R C
+            case 4:  return 0x33;   // L R Ls Rs
+            case 5:  return 0x37;   // 5.0
+            case 6:  return 0x3f;   // 5.1
+            case 7:  return 0xf7;   // 7.0 SDDS
+            case 8:  return 0xff;   // 7.1 SDDS
+            default: return 0;
+        }
+    }
+
+    // ------------------------------------------------------
+    //  Metadatos: ids de chunk y campos dentro de una copia
+    // ------------------------------------------------------
+    juce::String getChunkName(int id)
+    {
+        const char name[4] = { (char) id, (char) (id >> 8), (char) (id >> 16), (char) (id >> 24) };
+        return juce::String(name, 4).trimEnd();
+    }
+
+    // Los escribe HZWavWriter (o no hacen falta en la salida)
+    bool isStructuralChunk(int id) noexcept
+    {
+        for (auto* name : { "fmt ", "fact", "ds64", "data", "JUNK", "junk", "PAD ", "FLLR" })
+            if (id == chunkId(name))
+                return true;
+
+        return false;
+    }
+
+    // Describen el audio de la entrada: con el resampleado quedan mal
+    bool isStaleChunk(int id) noexcept
+    {
+        return id == chunkId("PEAK") || id == chunkId("levl") || id == chunkId("MD5 ");
+    }
+
+    void putLittleEndian(juce::uint8* p, juce::uint32 value) noexcept
+    {
+        for (int i = 0; i < 4; ++i)
+            p[i] = (juce::uint8) (value >> (8 * i));
+    }
+
+    juce::uint32 toField(juce::int64 value) noexcept
+    {
+        return (juce::uint32) juce::jlimit((juce::int64) 0, (juce::int64) 0xffffffff, value);
+    }
+
+    // Texto entre <tag> y </tag>, sin decodificar el XML
+    bool findXmlValue(const std::string& text, const std::string& tag, size_t& begin, size_t& end)
+    {
+        begin = text.find("<" + tag + ">");
+
+        if (begin == std::string::npos)
+            return false;
+
+        begin += tag.size() + 2;
+        end = text.find("</" + tag + ">", begin);
+        return end != std::string::npos;
+    }
+
+    juce::String formatSampleRate(double rate)
+    {
+        return rate == std::floor(rate) ? juce::String((juce::int64) rate) : juce::String(rate, 3);
+    }
+}
+
+// ==========================================================
+//  Cabeceras: solo lo necesario para ubicar el chunk de datos
+//  (y la frecuencia, para el reader de seguimiento). Con el
+//  reader de JUCE, create() exige que el formato coincida y el
+//  largo valido es el suyo.
+// ==========================================================
+bool HZPcmReader::parseWav(juce::InputStream& in, Format& format)
+{
+    const int riff = in.readInt();
+
+    if (riff != chunkId("RIFF") && riff != chunkId("RF64") && riff != chunkId("BW64"))
+        return false;
+
+    format.fileSize = (juce::int64) (juce::uint32) in.readInt() + 8;
+
+    if (in.readInt() != chunkId("WAVE"))
+        return false;
+
+    juce::int64 ds64DataSize = -1, dataSize = -1;
+    int blockAlign = 0, bitsPerSample = 0;
+
+    while (! in.isExhausted())
+    {
+        const int id = in.readInt();
+        const auto size = (juce::uint32) in.readInt();
+        const juce::int64 chunkStart = in.getPosition();
+        juce::int64 chunkSize = size;
+
+        if (id == chunkId("ds64"))
+        {
+            format.fileSize = in.readInt64() + 8;
+            ds64DataSize = in.readInt64();
+        }
+        else if (id == chunkId("fmt "))
+        {
+            auto tag = (juce::uint16) in.readShort();
+            format.numChannels = (juce::uint16) in.readShort();
+            format.sampleRate = (double) (juce::uint32) in.readInt();
+            in.readInt();
+            blockAlign = (juce::uint16) in.readShort();
+            bitsPerSample = (juce::uint16) in.readShort();
+
+            // WAVE_FORMAT_EXTENSIBLE: el tag real son los 2 primeros bytes del GUID
+            if (tag == 0xfffe && size >= 40)
+            {
+                in.readShort();
+                in.readShort();
+                in.readInt();
+                tag = (juce::uint16) in.readShort();
+            }
+
+            if (tag != 1 && tag != 3)
+                return false;
+
+            format.isFloat = (tag == 3);
+        }
+        else if (id == chunkId("data"))
+        {
+            dataSize = (riff != chunkId("RIFF") && size == 0xffffffff) ? ds64DataSize : (juce::int64) size;
+            format.dataStart = chunkStart;
+            chunkSize = dataSize;
+
+            if (dataSize < 0)
+                return false;
+        }
+
+        if (dataSize >= 0 && blockAlign > 0)
+            break;
+
+        in.setPosition(chunkStart + chunkSize + (chunkSize & 1));
+    }
+
+    if (dataSize < 0 || format.numChannels <= 0 || bitsPerSample % 8 != 0
+         || blockAlign != format.numChannels * (bitsPerSample / 8))
+        return false;
+
+    format.bytesPerSample = bitsPerSample / 8;
+    format.bigEndian = false;
+    format.numFrames = dataSize / blockAlign;
+    return true;
+}
+
+bool HZPcmReader::parseAiff(juce::InputStream& in, Format& format)
+{
+    if (in.readInt() != chunkId("FORM"))
+        return false;
+
+    format.fileSize = (juce::int64) (juce::uint32) in.readIntBigEndian() + 8;
+    const int type = in.readInt();
+
+    if (type != chunkId("AIFF") && type != chunkId("AIFC"))
+        return false;
+
+    juce::int64 dataBytes = -1;
+    int bitsPerSample = 0;
+
+    while (! in.isExhausted())
+    {
+        const int id = in.readInt();
+        const auto length = (juce::uint32) in.readIntBigEndian();
+        const juce::int64 chunkStart = in.getPosition();
+
+        if (id == chunkId("COMM"))
+        {
+            format.numChannels = (juce::uint16) in.readShortBigEndian();
+            in.readIntBigEndian();
+            bitsPerSample = (juce::uint16) in.readShortBigEndian();
+
+            // Frecuencia en extended de 80 bits: exponente con sesgo 16383,
+            // mantisa de 64 con el 1 explicito
+            const auto exponent = (juce::uint16) in.readShortBigEndian();
+            const auto mantissa = (juce::uint64) in.readInt64BigEndian();
+            format.sampleRate = std::ldexp((double) mantissa, (exponent & 0x7fff) - 16383 - 63);
+
+            format.bigEndian = true;
+            format.isFloat = false;
+
+            if (length > 18)
+            {
+                const int compression = in.readInt();
+
+                if (compression == chunkId("sowt"))
+                    format.bigEndian = false;
+                else if (compression == chunkId("fl32") || compression == chunkId("FL32"))
+                    format.isFloat = true;
+                else if (compression != chunkId("NONE") && compression != chunkId("twos"))
+                    return false;
+            }
+        }
+        else if (id == chunkId("SSND"))
+        {
+            const auto offset = (juce::uint32) in.readIntBigEndian();
+            format.dataStart = chunkStart + 8 + offset;
+            dataBytes = juce::jmax((juce::int64) 0, (juce::int64) length - 8 - offset);
+
+            // Grabando: SSND sin tamaño todavia, lo que sigue es audio
+            if (length == 0)
+                break;
+        }
+
+        in.setPosition(chunkStart + length + (length & 1));
+    }
+
+    if (dataBytes < 0 || format.numChannels <= 0 || bitsPerSample % 8 != 0)
+        return false;
+
+    format.bytesPerSample = bitsPerSample / 8;
+    format.numFrames = dataBytes / (format.numChannels * format.bytesPerSample);
+    return true;
+}
+
+bool HZPcmReader::isSupported(const Format& format) noexcept
+{
+    const int bits = format.bytesPerSample * 8;
+    return format.isFloat ? bits == 32 : (bits == 16 || bits == 24 || bits == 32);
+}
+
+std::unique_ptr<HZPcmReader> HZPcmReader::create(juce::AudioFormatReader& reader, bool follow)
+{
+    auto* fileStream = dynamic_cast<juce::FileInputStream*>(reader.input);
+
+    if (fileStream == nullptr)
+        return nullptr;
+
+    const auto file = fileStream->getFile();
+    juce::FileInputStream in(file);
+
+    if (in.failedToOpen())
+        return nullptr;
+
+    Format format;
+    const auto name = reader.getFormatName();
+    const bool isAiff = name == "AIFF file";
+    const bool parsed = name == "WAV file" ? parseWav(in, format)
+                      : isAiff             ? parseAiff(in, format)
+                                           : false;
+
+    // Tiene que describir lo mismo que el reader de JUCE (en seguimiento
+    // el largo del reader es el de una cabecera que todavia no es final)
+    const int bits = format.bytesPerSample * 8;
+
+    if (! parsed
+         || format.numChannels != (int) reader.numChannels
+         || bits != (int) reader.bitsPerSample
+         || format.isFloat != reader.usesFloatingPointData
+         || ! isSupported(format)
+         || (! follow && format.numFrames < reader.lengthInSamples))
+        return nullptr;
+
+    if (! follow)
+        format.numFrames = reader.lengthInSamples;
+
+    std::unique_ptr<HZPcmReader> pcm(new HZPcmReader(file, format, isAiff, follow));
+
+    if (! pcm->isMapped() && pcm->stream->failedToOpen())
+        return nullptr;
+
+    if (follow && ! pcm->refresh())
+        return nullptr;
+
+    return pcm;
+}
+
+// ==========================================================
+//  Reader de seguimiento
+//
+//  Un AudioFormatReader sobre un HZPcmReader propio: el resto
+//  de la conversion lo usa como el de JUCE (formato, canales,
+//  y read() para el pre-escaneo), y create() lo reconoce por
+//  el nombre del formato y el FileInputStream. Las lecturas
+//  mas alla del largo conocido releen la cabecera.
+// ==========================================================
+namespace
+{
+    class FollowReader : public juce::AudioFormatReader
+    {
+    public:
+        FollowReader(const juce::File& file, std::unique_ptr<HZPcmReader> source, const juce::String& formatName,
+                     double rate, int channels, int bits, bool isFloat)
+            : juce::AudioFormatReader(new juce::FileInputStream(file), formatName),
+              pcm(std::move(source))
+        {
+            sampleRate = rate;
+            numChannels = (unsigned int) channels;
+            bitsPerSample = (unsigned int) bits;
+            usesFloatingPointData = isFloat;
+            lengthInSamples = pcm->getNumFrames();
+        }
+
+        bool readSamples(int* const* destChannels, int numDestChannels, int startOffsetInDestBuffer,
+                         juce::int64 startSampleInFile, int numSamples) override
+        {
+            if (startSampleInFile + numSamples > pcm->getNumFrames() && ! pcm->isClosed())
+            {
+                pcm->refresh();
+                lengthInSamples = pcm->getNumFrames();
+            }
+
+            // En double: int32 y float32 pasan sin redondeo
+            const int channels = (int) numChannels;
+            planar.setSize(channels, numSamples, false, false, true);
+
+            if (! pcm->read(planar.getArrayOfWritePointers(), channels, startSampleInFile, numSamples))
+                return false;
+
+            for (int ch = 0; ch < numDestChannels; ++ch)
+            {
+                if (destChannels[ch] == nullptr)
+                    continue;
+
+                auto* dest = destChannels[ch] + startOffsetInDestBuffer;
+
+                if (ch >= channels)
+                {
+                    std::fill(dest, dest + numSamples, 0);
+                    continue;
+                }
+
+                const double* src = planar.getReadPointer(ch);
+
+                if (usesFloatingPointData)
+                {
+                    for (int i = 0; i < numSamples; ++i)
+                        reinterpret_cast<float*>(dest)[i] = (float) src[i];
+                }
+                else
+                {
+                    for (int i = 0; i < numSamples; ++i)
+                        dest[i] = (int) juce::jlimit(-2147483648.0, 2147483647.0, src[i] * 2147483648.0);
+                }
+            }
+
+            return true;
+        }
+
+    private:
+        std::unique_ptr<HZPcmReader> pcm;
+        juce::AudioBuffer<double> planar;
+    };
+}
+
+std::unique_ptr<juce::AudioFormatReader> HZPcmReader::createFollowReader(const juce::File& file)
+{
+    juce::FileInputStream in(file);
+
+    if (in.failedToOpen())
+        return nullptr;
+
+    Format format;
+    const bool isAiff = file.hasFileExtension("aif;aiff;aifc");
+    const bool parsed = isAiff ? parseAiff(in, format) : parseWav(in, format);
+
+    if (! parsed || ! isSupported(format) || format.sampleRate <= 0.0)
+        return nullptr;
+
+    std::unique_ptr<HZPcmReader> pcm(new HZPcmReader(file, format, isAiff, true));
+
+    if (pcm->stream->failedToOpen() || ! pcm->refresh())
+        return nullptr;
+
+    return std::make_unique<FollowReader>(file, std::move(pcm), isAiff ? "AIFF file" : "WAV file",
+                                          format.sampleRate, format.numChannels, format.bytesPerSample * 8,
+                                          format.isFloat);
+}
+
+HZPcmReader::HZPcmReader(const juce::File& f, const Format& fmt, bool aiff, bool follow)
+    : file(f),
+      format(fmt),
+      isAiff(aiff),
+      following(follow),
+      bytesPerFrame(fmt.numChannels * fmt.bytesPerSample),
+      chunkFrames(juce::jmax(1, chunkSamples / fmt.numChannels))
+{
+    const juce::Range<juce::int64> dataRange(format.dataStart, format.dataStart + format.numFrames * bytesPerFrame);
+
+    // El mapeo tiene tamaño fijo: en seguimiento se lee del stream
+    if (! following && ! dataRange.isEmpty())
+    {
+        map = std::make_unique<juce::MemoryMappedFile>(file, dataRange, juce::MemoryMappedFile::readOnly);
+
+        if (map->getData() == nullptr)
+            map.reset();
+    }
+
+    if (map == nullptr)
+    {
+        stream = std::make_unique<juce::FileInputStream>(file);
+        rawChunk.malloc((size_t) chunkFrames * (size_t) bytesPerFrame);
+    }
+
+    unpacked.malloc((size_t) chunkFrames * (size_t) format.numChannels);
+}
+
+bool HZPcmReader::refresh()
+{
+    jassert(following);
+
+    juce::FileInputStream in(file);
+
+    if (in.failedToOpen())
+        return false;
+
+    // El grabador puede estar reescribiendo la cabecera: si no se entiende,
+    // se toma como abierta y vale lo que hay en disco
+    Format header;
+    const bool parsed = (isAiff ? parseAiff(in, header) : parseWav(in, header))
+                         && header.dataStart == format.dataStart;
+
+    const auto fileSize = in.getTotalLength();
+    const auto onDisk = juce::jmax((juce::int64) 0, (fileSize - format.dataStart) / bytesPerFrame);
+
+    closed = parsed && header.fileSize == fileSize && header.numFrames > 0 && header.numFrames <= onDisk;
+    format.numFrames = closed ? header.numFrames : onDisk;
+    return true;
+}
+
+template <typename SampleType>
+bool HZPcmReader::read(SampleType* const* dest, int numChannels, juce::int64 start, int numFrames)
+{
+    jassert(numChannels == format.numChannels);
+
+    const ShuffleMask mask(format.bytesPerSample, format.bigEndian);
+    const int available = (int) juce::jlimit((juce::int64) 0, (juce::int64) numFrames, format.numFrames - start);
+
+    for (int done = 0; done < available;)
+    {
+        const int n = juce::jmin(chunkFrames, available - done);
+        const juce::int64 filePos = format.dataStart + (start + done) * bytesPerFrame;
+        const juce::uint8* raw;
+
+        if (map != nullptr)
+        {
+            raw = static_cast<const juce::uint8*>(map->getData()) + (filePos - map->getRange().getStart());
+        }
+        else
+        {
+            const int numBytes = n * bytesPerFrame;
+
+            if (! stream->setPosition(filePos) || stream->read(rawChunk.get(), numBytes) != numBytes)
+                return false;
+
+            raw = rawChunk.get();
+        }
+
+        unpackSamples(raw, unpacked.get(), n * format.numChannels, format.bytesPerSample, format.bigEndian, mask);
+        toPlanar(unpacked.get(), dest, format.numChannels, done, n, format.isFloat);
+        done += n;
+    }
+
+    for (int ch = 0; ch < numChannels; ++ch)
+        std::fill(dest[ch] + available, dest[ch] + numFrames, SampleType());
+
+    return true;
+}
+
+template bool HZPcmReader::read<float>(float* const*, int, juce::int64, int);
+template bool HZPcmReader::read<double>(double* const*, int, juce::int64, int);
+
+// ==========================================================
+//  Metadatos del WAV de entrada
+// ==========================================================
+std::unique_ptr<HZWavMetadata> HZWavMetadata::create(const juce::File& file)
+{
+    auto map = std::make_unique<juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readOnly);
+    const auto* data = static_cast<const juce::uint8*>(map->getData());
+    const auto size = (juce::int64) map->getSize();
+
+    if (data == nullptr || size < 12)
+        return nullptr;
+
+    const int riff = (int) juce::ByteOrder::littleEndianInt(data);
+
+    if ((riff != chunkId("RIFF") && riff != chunkId("RF64") && riff != chunkId("BW64"))
+         || (int) juce::ByteOrder::littleEndianInt(data + 8) != chunkId("WAVE"))
+        return nullptr;
+
+    std::vector<Chunk> chunks;
+    juce::StringArray dropped;
+    juce::int64 ds64DataSize = -1;
+
+    for (juce::int64 pos = 12; pos + 8 <= size;)
+    {
+        const int id = (int) juce::ByteOrder::littleEndianInt(data + pos);
+        const auto chunkSize = juce::ByteOrder::littleEndianInt(data + pos + 4);
+        auto length = (juce::int64) chunkSize;
+
+        if (id == chunkId("data") && riff != chunkId("RIFF") && chunkSize == 0xffffffff)
+            length = ds64DataSize;
+
+        // Un chunk cortado (el archivo no se cerro bien): hasta ahi
+        if (length < 0 || pos + 8 + length > size)
+            break;
+
+        if (id == chunkId("ds64") && length >= 16)
+            ds64DataSize = (juce::int64) juce::ByteOrder::littleEndianInt64(data + pos + 16);
+        else if (isStaleChunk(id))
+            dropped.addIfNotAlreadyThere(getChunkName(id));
+        else if (! isStructuralChunk(id))
+            chunks.push_back({ id, data + pos + 8, chunkSize });
+
+        pos += 8 + length + (length & 1);
+    }
+
+    if (chunks.empty())
+        return nullptr;
+
+    return std::unique_ptr<HZWavMetadata>(new HZWavMetadata(std::move(map), std::move(chunks), dropped));
+}
+
+HZWavMetadata::HZWavMetadata(std::unique_ptr<juce::MemoryMappedFile> file, std::vector<Chunk> list,
+                             const juce::StringArray& droppedNames)
+    : map(std::move(file)),
+      chunks(std::move(list)),
+      dropped(droppedNames)
+{
+}
+
+void HZWavMetadata::setRates(double nominal, double inRate, double inRateEnd, double rate,
+                             juce::int64 inputFrames, HZSampleFormat outputFormat) noexcept
+{
+    nominalRate = nominal;
+    outRate = rate;
+    bitsPerSample = getBitsPerSample(outputFormat);
+    step = inRate / outRate;
+    stepEnd = inRateEnd / outRate;
+
+    // La rampa del motor variable: sobre la duracion estimada de la salida
+    rampFrames = inRateEnd != inRate ? std::ceil((double) inputFrames / (0.5 * (step + stepEnd))) : 0.0;
+}
+
+juce::String HZWavMetadata::getDescription() const
+{
+    juce::StringArray names;
+
+    for (const auto& chunk : chunks)
+        names.addIfNotAlreadyThere(getChunkName(chunk.id));
+
+    auto text = names.joinIntoString(", ");
+
+    if (! dropped.isEmpty())
+        text << " (sin " << dropped.joinIntoString(", ") << ": describen el audio original)";
+
+    return text;
+}
+
+juce::int64 HZWavMetadata::mapPosition(juce::int64 position, juce::int64 numFrames) const noexcept
+{
+    // Frame de salida n en la entrada: step n + (stepEnd - step) n^2 / 2R
+    // durante la rampa, stepEnd despues
+    const auto x = (double) position;
+    double n = x / step;
+
+    if (rampFrames > 0.0)
+    {
+        const double a = (stepEnd - step) / (2.0 * rampFrames);
+        const double rampEnd = (step + a * rampFrames) * rampFrames;
+
+        n = x <= rampEnd ? 2.0 * x / (step + std::sqrt(step * step + 4.0 * a * x))
+                         : rampFrames + (x - rampEnd) / stepEnd;
+    }
+
+    return juce::jlimit((juce::int64) 0, numFrames, (juce::int64) std::llround(n));
+}
+
+juce::int64 HZWavMetadata::mapTimestamp(juce::int64 samples) const noexcept
+{
+    return (juce::int64) std::llround((double) samples * outRate / nominalRate);
+}
+
+juce::int64 HZWavMetadata::getCuePosition(juce::uint32 name) const noexcept
+{
+    for (const auto& chunk : chunks)
+    {
+        if (chunk.id != chunkId("cue ") || chunk.size < 4)
+            continue;
+
+        const auto numPoints = juce::jmin(juce::ByteOrder::littleEndianInt(chunk.data), (chunk.size - 4) / 24);
+
+        for (juce::uint32 i = 0; i < numPoints; ++i)
+        {
+            const auto* point = chunk.data + 4 + i * 24;
+
+            if (juce::ByteOrder::littleEndianInt(point) == name)
+                return juce::ByteOrder::littleEndianInt(point + 20);
+        }
+    }
+
+    return 0;
+}
+
+bool HZWavMetadata::rewrite(const Chunk& chunk, juce::int64 numFrames, juce::MemoryBlock& result) const
+{
+    const auto id = chunk.id;
+    const auto copy = [&]() -> juce::uint8*
+    {
+        result.replaceAll(chunk.data, chunk.size);
+        return static_cast<juce::uint8*>(result.getData());
+    };
+
+    const auto movePosition = [&](juce::uint8* field)
+    {
+        putLittleEndian(field, toField(mapPosition(juce::ByteOrder::littleEndianInt(field), numFrames)));
+    };
+
+    // dwCuePoints + { dwName, dwPosition, fccChunk, dwChunkStart, dwBlockStart, dwSampleOffset }
+    if (id == chunkId("cue ") && chunk.size >= 4)
+    {
+        auto* p = copy();
+        const auto numPoints = juce::jmin(juce::ByteOrder::littleEndianInt(p), (chunk.size - 4) / 24);
+
+        for (juce::uint32 i = 0; i < numPoints; ++i)
+        {
+            movePosition(p + 4 + i * 24 + 4);
+            movePosition(p + 4 + i * 24 + 20);
+        }
+
+        return true;
+    }
+
+    // 36 bytes (dwSamplePeriod en ns, dwNumSampleLoops) + loops de 24
+    // { dwCuePointID, dwType, dwStart, dwEnd, dwFraction, dwPlayCount }
+    if (id == chunkId("smpl") && chunk.size >= 36)
+    {
+        auto* p = copy();
+        const auto numLoops = juce::jmin(juce::ByteOrder::littleEndianInt(p + 28), (chunk.size - 36) / 24);
+
+        putLittleEndian(p + 8, toField(std::llround(1.0e9 / outRate)));
+
+        for (juce::uint32 i = 0; i < numLoops; ++i)
+        {
+            movePosition(p + 36 + i * 24 + 8);
+            movePosition(p + 36 + i * 24 + 12);
+        }
+
+        return true;
+    }
+
+    // LIST adtl: el largo de cada region (ltxt) desde su marcador
+    if (id == chunkId("LIST") && chunk.size >= 4 && (int) juce::ByteOrder::littleEndianInt(chunk.data) == chunkId("adtl"))
+    {
+        auto* p = copy();
+
+        for (juce::uint32 pos = 4; pos + 8 <= chunk.size;)
+        {
+            const auto subSize = juce::ByteOrder::littleEndianInt(p + pos + 4);
+
+            if (subSize > chunk.size - pos - 8)
+                break;
+
+            if ((int) juce::ByteOrder::littleEndianInt(p + pos) == chunkId("ltxt") && subSize >= 8)
+            {
+                auto* fields = p + pos + 8;
+                const auto start = getCuePosition(juce::ByteOrder::littleEndianInt(fields));
+                const auto end = start + juce::ByteOrder::littleEndianInt(fields + 4);
+
+                putLittleEndian(fields + 4, toField(mapPosition(end, numFrames) - mapPosition(start, numFrames)));
+            }
+
+            pos += 8 + subSize + (subSize & 1);
+        }
+
+        return true;
+    }
+
+    // Description, Originator, OriginatorReference, fecha y hora: el
+    // TimeReference (64 bits) empieza en el byte 338
+    if (id == chunkId("bext") && chunk.size >= 346)
+    {
+        auto* p = copy();
+        const auto timeReference = (juce::int64) juce::ByteOrder::littleEndianInt64(p + 338);
+        const auto moved = (juce::uint64) mapTimestamp(timeReference);
+
+        putLittleEndian(p + 338, (juce::uint32) moved);
+        putLittleEndian(p + 342, (juce::uint32) (moved >> 32));
+        return true;
+    }
+
+    // iXML: solo si tiene alguno de los campos (el resto sale del mapeo)
+    if (id == chunkId("iXML"))
+    {
+        static const char* const tags[] = { "FILE_SAMPLE_RATE", "TIMESTAMP_SAMPLE_RATE",
+                                            "TIMESTAMP_SAMPLES_SINCE_MIDNIGHT_HI",
+                                            "TIMESTAMP_SAMPLES_SINCE_MIDNIGHT_LO",
+                                            "BWF_TIME_REFERENCE_HIGH", "BWF_TIME_REFERENCE_LOW",
+                                            "AUDIO_BIT_DEPTH" };
+
+        const auto* begin = reinterpret_cast<const char*>(chunk.data);
+        const auto* end = begin + chunk.size;
+
+        const auto hasTag = [&](const char* tag)
+        {
+            const std::string open = "<" + std::string(tag) + ">";
+            return std::search(begin, end, open.begin(), open.end()) != end;
+        };
+
+        if (std::none_of(std::begin(tags), std::end(tags), hasTag))
+            return false;
+
+        std::string text(begin, end);
+        size_t valueBegin = 0, valueEnd = 0;
+
+        const auto replaceValue = [&](const std::string& tag, const juce::String& value)
+        {
+            if (findXmlValue(text, tag, valueBegin, valueEnd))
+                text.replace(valueBegin, valueEnd - valueBegin, value.toStdString());
+        };
+
+        const auto getValue = [&](const std::string& tag) -> juce::int64
+        {
+            return findXmlValue(text, tag, valueBegin, valueEnd)
+                     ? juce::String(text.substr(valueBegin, valueEnd - valueBegin)).trim().getLargeIntValue()
+                     : -1;
+        };
+
+        replaceValue(tags[0], formatSampleRate(outRate));
+        replaceValue(tags[1], formatSampleRate(outRate));
+
+        // Marcas de tiempo de 64 bits partidas en dos campos de 32: la
+        // del iXML y la copia del TimeReference del bext
+        const auto moveTimestamp = [&](const char* highTag, const char* lowTag)
+        {
+            const auto high = getValue(highTag), low = getValue(lowTag);
+
+            if (high >= 0 && low >= 0)
+            {
+                const auto moved = (juce::uint64) mapTimestamp((high << 32) | low);
+                replaceValue(highTag, juce::String((juce::int64) (moved >> 32)));
+                replaceValue(lowTag, juce::String((juce::int64) (moved & 0xffffffff)));
+            }
+        };
+
+        moveTimestamp(tags[2], tags[3]);
+        moveTimestamp(tags[4], tags[5]);
+
+        if (bitsPerSample > 0)
+            replaceValue(tags[6], juce::String(bitsPerSample));
+
+        result.replaceAll(text.data(), text.size());
+        return true;
+    }
+
+    return false;
+}
+
+juce::int64 HZWavMetadata::write(juce::OutputStream& out, juce::int64 numFrames) const
+{
+    juce::int64 total = 0;
+    juce::MemoryBlock rewritten;
+
+    for (const auto& chunk : chunks)
+    {
+        // Los que llevan tiempos, de una copia; el resto, del mapeo
+        const bool changed = rewrite(chunk, numFrames, rewritten);
+        const auto* bytes = changed ? static_cast<const juce::uint8*>(rewritten.getData()) : chunk.data;
+        const auto size = changed ? (juce::uint32) rewritten.getSize() : chunk.size;
+
+        if (! out.writeInt(chunk.id) || ! out.writeInt((int) size) || ! out.write(bytes, size)
+             || ((size & 1) != 0 && ! out.writeByte(0)))
+            return -1;
+
+        total += 8 + (juce::int64) size + (size & 1);
+    }
+
+    return total;
+}
+
+// ==========================================================
+//  Escritura directa de WAV
+// ==========================================================
+HZWavWriter::HZWavWriter(std::unique_ptr<juce::OutputStream> stream, double rate, int channels,
+                         HZSampleFormat sampleFormat, HZDitherMode dither, bool useBw64)
+    : output(std::move(stream)),
+      sampleRate(rate),
+      numChannels(channels),
+      format(sampleFormat),
+      bw64(useBw64),
+      bitsPerSample(getBitsPerSample(sampleFormat)),
+      bytesPerFrame(channels * (bitsPerSample / 8)),
+      headerPosition(output != nullptr ? output->getPosition() : 0)
+{
+    jassert(format != HZSampleFormat::source);
+
+    blockFrames = juce::jmax(quantizeChunk, writeBlockBytes / bytesPerFrame);
+    block.malloc((size_t) blockFrames * (size_t) bytesPerFrame + 16);
+
+    if (isFloatFormat(format))
+    {
+        floatScratch.resize((size_t) quantizeChunk * (size_t) numChannels);
+        doubleScratch.resize((size_t) quantizeChunk * (size_t) numChannels);
+    }
+    else
+    {
+        quantizer = std::make_unique<HZQuantizer>(numChannels, bitsPerSample, dither);
+
+        planar.malloc((size_t) quantizeChunk * (size_t) numChannels);
+        interleaved.malloc((size_t) quantizeChunk * (size_t) numChannels);
+        planarChannels.malloc((size_t) numChannels);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            planarChannels[ch] = planar + (size_t) ch * (size_t) quantizeChunk;
+    }
+
+    floatChunk.resize((size_t) numChannels);
+    doubleChunk.resize((size_t) numChannels);
+
+    if (output != nullptr && ! writeHeader())
+        failed = true;
+}
+
+HZWavWriter::~HZWavWriter()
+{
+    finish();
+}
+
+template <typename SampleType>
+bool HZWavWriter::writeSamples(const SampleType* const* input, int numFrames)
+{
+    if (! isOk() || finished)
+        return false;
+
+    const PackMask mask(bitsPerSample / 8);
+    auto& chunk = [this]() -> auto&
+    {
+        if constexpr (std::is_same_v<SampleType, float>)
+            return floatChunk;
+        else
+            return doubleChunk;
+    }();
+
+    // Tramos de quantizeChunk frames que terminan en el bloque de salida
+    for (int done = 0; done < numFrames;)
+    {
+        const int n = juce::jmin(quantizeChunk, numFrames - done, blockFrames - blockUsed);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            chunk[(size_t) ch] = input[ch] + done;
+
+        auto* dst = block + (size_t) blockUsed * (size_t) bytesPerFrame;
+
+        if (quantizer != nullptr)
+        {
+            quantizer->process(chunk.data(), planarChannels.get(), n);
+            packInterleaved(planarChannels.get(), interleaved.get(), dst, numChannels, n, bitsPerSample / 8, mask);
+        }
+        else if (format == HZSampleFormat::float32)
+        {
+            packFloat(chunk.data(), floatChunk, floatScratch, dst, numChannels, n);
+        }
+        else
+        {
+            packFloat(chunk.data(), doubleChunk, doubleScratch, dst, numChannels, n);
+        }
+
+        blockUsed += n;
+        done += n;
+
+        if (blockUsed == blockFrames && ! flushBlock())
+            return false;
+    }
+
+    return true;
+}
+
+void HZWavWriter::setProgressiveHeader(double intervalSeconds)
+{
+    headerIntervalMs = (juce::uint32) juce::jmax(0.0, intervalSeconds * 1000.0);
+    lastHeaderUpdate = juce::Time::getMillisecondCounter();
+
+    // La cabecera vacia ya es un WAV valido: que este en disco desde ya
+    if (isOk())
+        output->flush();
+}
+
+void HZWavWriter::setMetadata(std::unique_ptr<HZWavMetadata> chunks)
+{
+    metadata = std::move(chunks);
+}
+
+bool HZWavWriter::flushBlock()
+{
+    const auto numBytes = (size_t) blockUsed * (size_t) bytesPerFrame;
+    blockUsed = 0;
+
+    if (numBytes == 0)
+        return true;
+
+    if (! output->write(block, numBytes))
+    {
+        // Sin espacio: al menos que la cabecera describa lo que se escribio
+        writeHeader();
+        failed = true;
+        return false;
+    }
+
+    dataBytes += numBytes;
+
+    if (headerIntervalMs > 0)
+    {
+        const auto now = juce::Time::getMillisecondCounter();
+
+        if (now - lastHeaderUpdate >= headerIntervalMs)
+        {
+            lastHeaderUpdate = now;
+
+            // El bloque ya se escribio: la cabecera nunca cuenta de mas
+            if (! writeHeader())
+            {
+                failed = true;
+                return false;
+            }
+
+            output->flush();
+        }
+    }
+
+    return true;
+}
+
+bool HZWavWriter::finish()
+{
+    if (output == nullptr || finished)
+        return isOk();
+
+    finished = true;
+
+    if (! failed && flushBlock())
+    {
+        if ((dataBytes & 1) != 0)
+            output->writeByte(0);
+
+        // Los metadatos despues del audio (y del byte de relleno)
+        if (metadata != nullptr)
+        {
+            const auto written = metadata->write(*output, (juce::int64) (dataBytes / (juce::uint64) bytesPerFrame));
+            failed = written < 0;
+            metadataBytes = (juce::uint64) juce::jmax((juce::int64) 0, written);
+        }
+
+        failed = failed || ! writeHeader();
+    }
+
+    output->flush();
+    return isOk();
+}
+
+bool HZWavWriter::writeHeader()
+{
+    // Cabecera de tamaño fijo (JUNK o ds64): el audio no se mueve al pasar
+    // a RF64. El byte de relleno solo existe al cerrar
+    const auto pad = finished ? (dataBytes & 1) : 0;
+    const auto riffSize = dataBytes + pad + metadataBytes + 4 + 8 + 40 + 8 + 8 + 28;
+    const bool isRF64 = isLargeFile();
+    const int channelMask = getWavChannelMask(numChannels);
+    const bool isExtensible = isRF64 || channelMask != 0;
+    const bool isFloat = isFloatFormat(format);
+    const auto endPosition = output->getPosition();
+
+    if (endPosition != headerPosition && ! output->setPosition(headerPosition))
+        return false;
+
+    auto& out = *output;
+    out.writeInt(chunkId(! isRF64 ? "RIFF" : (bw64 ? "BW64" : "RF64")));
+    out.writeInt(isRF64 ? -1 : (int) riffSize);
+    out.writeInt(chunkId("WAVE"));
+
+    if (isRF64)
+    {
+        out.writeInt(chunkId("ds64"));
+        out.writeInt(28);
+        out.writeInt64((juce::int64) riffSize);
+        out.writeInt64((juce::int64) dataBytes);
+        out.writeInt64((juce::int64) (dataBytes / (juce::uint64) bytesPerFrame));   // frames (el "fact")
+        out.writeInt(0);                                                             // sin tabla
+    }
+    else
+    {
+        const int junkSize = 28 + (isExtensible ? 0 : 24);
+        out.writeInt(chunkId("JUNK"));
+        out.writeInt(junkSize);
+        out.writeRepeatedByte(0, (size_t) junkSize);
+    }
+
+    out.writeInt(chunkId("fmt "));
+    out.writeInt(isExtensible ? 40 : 16);
+    out.writeShort((short) (isExtensible ? 0xfffe : (isFloat ? 3 : 1)));   // WAVE_FORMAT_IEEE_FLOAT / PCM
+    out.writeShort((short) numChannels);
+    out.writeInt((int) sampleRate);
+    out.writeInt((int) ((double) bytesPerFrame * sampleRate));
+    out.writeShort((short) bytesPerFrame);
+    out.writeShort((short) bitsPerSample);
+
+    if (isExtensible)
+    {
+        // KSDATAFORMAT_SUBTYPE_IEEE_FLOAT / _PCM
+        static constexpr juce::uint8 guidTail[8] = { 0x80, 0x00, 0x00, 0xaa, 0x00, 0x38, 0x9b, 0x71 };
+
+        out.writeShort(22);
+        out.writeShort((short) bitsPerSample);
+        out.writeInt(channelMask);
+        out.writeInt(isFloat ? 3 : 1);
+        out.writeShort(0);
+        out.writeShort(0x0010);
+        out.write(guidTail, sizeof(guidTail));
+    }
+
+    out.writeInt(chunkId("data"));
+    out.writeInt(isRF64 ? -1 : (int) dataBytes);
+
+    // Al crear, el audio sigue a la cabecera; al cerrar, se vuelve al final
+    return endPosition == headerPosition || out.setPosition(endPosition);
+}
+
+template bool HZWavWriter::writeSamples<float>(const float* const*, int);
+template bool HZWavWriter::writeSamples<double>(const double* const*, int);
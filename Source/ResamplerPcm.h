@@ -0,0 +1,300 @@
+#pragma once
+#include "JuceHeader.h"
+#include "ResamplerDither.h"
+
+// ==========================================================
+//  Lectura directa de PCM (WAV / AIFF)
+//
+//  AudioFormatReader::read desempaqueta a int32 en un buffer
+//  y despues lo recorre de nuevo para pasarlo a float. Aca
+//  los bytes del chunk de datos (mapeado en memoria, o leido
+//  del stream si no se puede mapear) se decodifican en tramos
+//  de ~16 KB que quedan en cache, directo al buffer planar que
+//  consume el motor:
+//
+//    1) desempaque a int32 justificado: pshufb / tbl con una
+//       mascara por formato (int24 de 3 bytes, byte swap de
+//       AIFF y float big endian en la misma instruccion);
+//    2) desintercalado + escala a float/double (SSE2).
+//
+//  El resultado es el mismo bit a bit que el de JUCE (mismo
+//  factor de escala), asi que se puede usar o no sin cambiar
+//  la salida.
+//
+//  Seguimiento (archivo que se sigue grabando): sin mapeo, y
+//  refresh() vuelve a leer la cabecera y el tamaño. Mientras
+//  se graba, el largo es lo que ya esta en disco (la cabecera
+//  suele decir 0 o un valor viejo); el archivo esta cerrado
+//  cuando el tamaño del RIFF/FORM cubre el archivo entero y
+//  el chunk de datos tiene tamaño: desde ahi manda la cabecera.
+// ==========================================================
+class HZPcmReader
+{
+public:
+    /** nullptr si no aplica: el reader no lee de un archivo WAV/AIFF o
+        el formato no es PCM de 16/24/32 bits o float de 32. follow: el
+        archivo se esta grabando (el largo sale de refresh()). */
+    static std::unique_ptr<HZPcmReader> create(juce::AudioFormatReader& reader, bool follow = false);
+
+    /** Reader para seguimiento armado con la cabecera del archivo, sin el
+        de JUCE: el grabador suele dejar el RIFF / FORM en 0 hasta cerrar y
+        JUCE no abre esos archivos. El largo es lo que ya esta en disco.
+        nullptr si no es WAV/AIFF PCM de 16/24/32 bits o float de 32. */
+    static std::unique_ptr<juce::AudioFormatReader> createFollowReader(const juce::File& file);
+
+    /** Como AudioFormatReader::read: numFrames desde start, en planar
+        (mas alla del final, ceros). */
+    template <typename SampleType>
+    bool read(SampleType* const* dest, int numChannels, juce::int64 start, int numFrames);
+
+    /** Solo en seguimiento: relee cabecera y tamaño. false si el archivo
+        ya no se puede abrir. */
+    bool refresh();
+
+    juce::int64 getNumFrames() const noexcept { return format.numFrames; }
+    bool isClosed() const noexcept { return closed; }
+    bool isMapped() const noexcept { return map != nullptr; }
+
+private:
+    struct Format
+    {
+        juce::int64 dataStart = 0;
+        juce::int64 numFrames = 0;
+        juce::int64 fileSize = -1;     // segun la cabecera (RIFF / FORM + 8)
+        double sampleRate = 0.0;
+        int numChannels = 0;
+        int bytesPerSample = 0;
+        bool bigEndian = false;
+        bool isFloat = false;
+    };
+
+    HZPcmReader(const juce::File& file, const Format& format, bool isAiff, bool follow);
+
+    static bool parseWav(juce::InputStream& in, Format& format);
+    static bool parseAiff(juce::InputStream& in, Format& format);
+    static bool isSupported(const Format& format) noexcept;
+
+    const juce::File file;
+    Format format;
+    const bool isAiff, following;
+    const int bytesPerFrame;
+    const int chunkFrames;
+    bool closed = false;
+
+    std::unique_ptr<juce::MemoryMappedFile> map;
+    std::unique_ptr<juce::FileInputStream> stream;   // si no se pudo mapear
+
+    juce::HeapBlock<juce::uint8> rawChunk;
+    juce::HeapBlock<int> unpacked;
+};
+
+// ==========================================================
+//  Salida del motor
+//
+//  runStream escribe cada bloque en planar (float o double
+//  segun la precision del motor) sin saber el contenedor:
+//  WAV (HZWavWriter) o FLAC (HZFlacWriter).
+// ==========================================================
+class HZAudioWriter
+{
+public:
+    virtual ~HZAudioWriter() = default;
+
+    virtual bool isOk() const noexcept = 0;
+    virtual HZSampleFormat getFormat() const noexcept = 0;
+
+    /** numFrames en planar, una llamada por bloque del motor. */
+    virtual bool write(const float* const* input, int numFrames) = 0;
+    virtual bool write(const double* const* input, int numFrames) = 0;
+
+    /** El archivo a medio escribir se puede ir leyendo (intervalSeconds:
+        cada cuanto se pone al dia lo que haga falta; 0 = solo al cerrar). */
+    virtual void setProgressiveHeader(double intervalSeconds) = 0;
+
+    /** Completa la cabecera; despues ya no se puede escribir. */
+    virtual bool finish() = 0;
+};
+
+// ==========================================================
+//  Metadatos del WAV de entrada
+//
+//  El WAV de salida llevaba solo fmt y data: BWF (bext),
+//  iXML, marcadores (cue, LIST adtl), loops (smpl) y el resto
+//  se perdian. Aca los chunks de la entrada (mapeada en
+//  memoria) van a la salida despues del audio, del mapeo al
+//  stream: no pasan por StringPairArray ni por un buffer.
+//
+//  Solo se reescriben los campos que son tiempo en muestras
+//  (y la profundidad en bits del iXML):
+//
+//    cue    posicion y offset de cada marcador
+//    smpl   periodo de muestra, inicio y fin de cada loop
+//    LIST   largo de cada region (ltxt de adtl)
+//    bext   TimeReference (muestras desde medianoche)
+//    iXML   FILE_SAMPLE_RATE, TIMESTAMP_SAMPLE_RATE,
+//           TIMESTAMP_SAMPLES_SINCE_MIDNIGHT_HI / _LO, la
+//           copia del bext (BWF_TIME_REFERENCE_HIGH / _LOW)
+//           y AUDIO_BIT_DEPTH
+//
+//  Las posiciones dentro del archivo siguen el paso del motor
+//  (con la rampa de la correccion de deriva); las marcas de
+//  tiempo absolutas, la frecuencia nominal (la del fmt).
+//
+//  No se copian los de estructura (fmt, fact, ds64, data,
+//  relleno) ni los que describen el audio viejo y quedarian
+//  mal: picos (PEAK, levl) y checksum (MD5).
+// ==========================================================
+class HZWavMetadata
+{
+public:
+    /** nullptr si el archivo no es WAV / RF64 / BW64 o no tiene chunks
+        que copiar. */
+    static std::unique_ptr<HZWavMetadata> create(const juce::File& file);
+
+    /** nominalRate: la del fmt de la entrada. inRate / inRateEnd: la real
+        al principio y al final (rampa lineal a lo largo de inputFrames,
+        como en el motor variable). outputFormat: el de la salida (ya
+        resuelto), para la profundidad del iXML. */
+    void setRates(double nominalRate, double inRate, double inRateEnd, double outRate,
+                  juce::int64 inputFrames, HZSampleFormat outputFormat) noexcept;
+
+    /** "bext, iXML, cue" (y lo que no se copia). */
+    juce::String getDescription() const;
+
+    /** Escribe los chunks donde este el stream. numFrames: largo de la
+        salida (tope de las posiciones). Bytes escritos, -1 si falla. */
+    juce::int64 write(juce::OutputStream& out, juce::int64 numFrames) const;
+
+private:
+    struct Chunk
+    {
+        int id = 0;
+        const juce::uint8* data = nullptr;
+        juce::uint32 size = 0;
+    };
+
+    HZWavMetadata(std::unique_ptr<juce::MemoryMappedFile> map, std::vector<Chunk> chunks,
+                  const juce::StringArray& dropped);
+
+    bool rewrite(const Chunk& chunk, juce::int64 numFrames, juce::MemoryBlock& result) const;
+    juce::int64 mapPosition(juce::int64 position, juce::int64 numFrames) const noexcept;
+    juce::int64 mapTimestamp(juce::int64 samples) const noexcept;
+    juce::int64 getCuePosition(juce::uint32 name) const noexcept;
+
+    std::unique_ptr<juce::MemoryMappedFile> map;
+    const std::vector<Chunk> chunks;
+    const juce::StringArray dropped;
+
+    double nominalRate = 0.0, outRate = 0.0;
+    double step = 1.0, stepEnd = 1.0;         // frames de entrada por frame de salida
+    double rampFrames = 0.0;                  // 0 = paso constante
+    int bitsPerSample = 0;                    // de la salida
+};
+
+// ==========================================================
+//  Escritura directa de WAV
+//
+//  writer->write(int**) recibe el PCM cuantizado en planar,
+//  lo pasa por los conversores de AudioData a un temporal
+//  intercalado y recien ahi lo escribe. Aca la salida del
+//  motor se cuantiza en tramos de 256 frames (int32 en L1),
+//  se intercala y empaqueta con SIMD (pshufb / tbl, la
+//  inversa del desempaque) directo en un bloque de 64 KB que
+//  va entero al stream (mas grande que el buffer del
+//  FileOutputStream: no se copia otra vez).
+//
+//  Cada formato tiene su camino: 16 y 24 bits empaquetan
+//  los bytes altos; 32 bits y float solo intercalan palabras
+//  de 4 u 8 bytes (float se escribe tal cual, convertido con
+//  SSE2 si el motor trabaja en la otra precision).
+//
+//  La cabecera es la del WavAudioFormatWriter de JUCE, byte
+//  a byte: JUNK de reserva para pasar a RF64 al cerrar si el
+//  audio supera 4 GB, WAVE_FORMAT_EXTENSIBLE con mascara de
+//  canales de 3 a 8 canales (IEEE_FLOAT en float).
+//
+//  RF64 / BW64: el JUNK ocupa lo mismo que el ds64 y el fmt
+//  extensible lo mismo que el simple mas el resto del JUNK,
+//  asi que al cerrar solo se reescriben los 104 bytes de la
+//  cabecera: el audio no se mueve ni se vuelve a escribir.
+//  BW64 (ITU-R BS.2088) es el mismo formato con otro id; el
+//  reader WAV de JUCE solo abre RF64.
+//
+//  Modo progresivo: cada tanto, despues de escribir un bloque,
+//  se reescribe la cabecera con los tamaños de lo que ya esta
+//  en disco. El archivo a medio escribir es siempre un WAV
+//  valido (audio primero, cabecera despues) que va creciendo.
+//
+//  Los metadatos de la entrada (HZWavMetadata) se escriben al
+//  cerrar, despues del audio: la cabecera no cambia de tamaño.
+// ==========================================================
+class HZWavWriter : public HZAudioWriter
+{
+public:
+    /** format no puede ser source (ya resuelto). El dither solo aplica a
+        los formatos enteros. bw64: id BW64 en vez de RF64 si pasa de 4 GB.
+        El stream tiene que poder volver atras (setPosition) para
+        completar la cabecera. */
+    HZWavWriter(std::unique_ptr<juce::OutputStream> stream, double sampleRate, int numChannels,
+                HZSampleFormat format, HZDitherMode dither, bool bw64 = false);
+
+    /** Llama a finish(). */
+    ~HZWavWriter() override;
+
+    bool isOk() const noexcept override { return output != nullptr && ! failed; }
+    HZSampleFormat getFormat() const noexcept override { return format; }
+
+    /** Cabecera al dia cada intervalSeconds (0 = solo al cerrar). */
+    void setProgressiveHeader(double intervalSeconds) override;
+
+    /** Chunks de la entrada que van despues del audio al cerrar. */
+    void setMetadata(std::unique_ptr<HZWavMetadata> chunks);
+
+    /** El RIFF ya no entra en 32 bits: cabecera con ds64. Cuenta el
+        tamaño del RIFF, no solo el de los datos (a menos de 96 bytes de
+        los 4 GB el campo ya no alcanza). */
+    bool isLargeFile() const noexcept
+    {
+        return dataBytes + (dataBytes & 1) + metadataBytes + 96 > 0xffffffffull;
+    }
+
+    /** Cuantiza (o convierte) numFrames en planar, intercala y escribe. */
+    bool write(const float* const* input, int numFrames) override  { return writeSamples(input, numFrames); }
+    bool write(const double* const* input, int numFrames) override { return writeSamples(input, numFrames); }
+
+    /** Vacia el bloque y reescribe la cabecera con los tamaños finales. */
+    bool finish() override;
+
+private:
+    template <typename SampleType>
+    bool writeSamples(const SampleType* const* input, int numFrames);
+
+    bool flushBlock();
+    bool writeHeader();
+
+    std::unique_ptr<juce::OutputStream> output;
+    const double sampleRate;
+    const int numChannels;
+    const HZSampleFormat format;
+    const bool bw64;
+    const int bitsPerSample, bytesPerFrame;
+    const juce::int64 headerPosition;
+
+    std::unique_ptr<HZQuantizer> quantizer;   // nullptr en float
+
+    juce::HeapBlock<juce::uint8> block;
+    int blockFrames = 0, blockUsed = 0;     // en frames
+
+    juce::HeapBlock<int> planar, interleaved;
+    juce::HeapBlock<int*> planarChannels;
+    std::vector<const float*> floatChunk;     // entrada del tramo (punteros desplazados)
+    std::vector<const double*> doubleChunk;
+    std::vector<float> floatScratch;          // float <-> double para la salida float
+    std::vector<double> doubleScratch;
+
+    std::unique_ptr<HZWavMetadata> metadata;
+
+    juce::uint64 dataBytes = 0, metadataBytes = 0;
+    juce::uint32 headerIntervalMs = 0, lastHeaderUpdate = 0;
+    bool failed = false, finished = false;
+};
@@ -0,0 +1,156 @@
+#include "JuceHeader.h"
+#include "../Source/Resampler.h"
+#include <cstdio>
+
+// ==========================================================
+//  Test de determinismo
+//
+//  Con options.deterministic la salida tiene que ser la misma
+//  bit a bit con cualquier numero de hilos y tamaño de bloque.
+//  Se genera un WAV de prueba, se convierte con 1, 2 y 7
+//  hilos y bloques de 257, 4096 y el del autotune, y se
+//  comparan los hashes de los archivos de salida. Cubre los
+//  motores racional, halfband, compacto y variable (entrada
+//  con reloj desviado), en float y en doble precision.
+// ==========================================================
+namespace
+{
+    juce::uint64 hashFile(const juce::File& file)
+    {
+        juce::MemoryBlock data;
+
+        if (! file.loadFileAsData(data))
+            return 0;
+
+        // FNV-1a de 64 bits
+        juce::uint64 hash = 14695981039346656037ull;
+
+        for (size_t i = 0; i < data.getSize(); ++i)
+            hash = (hash ^ (juce::uint8) data[i]) * 1099511628211ull;
+
+        return hash;
+    }
+
+    // Estereo de 24 bits: dos senos, un barrido y ruido (semilla fija)
+    bool writeTestFile(const juce::File& file, double sampleRate, int numFrames)
+    {
+        juce::AudioBuffer<float> buffer(2, numFrames);
+        juce::Random random(1234);
+
+        for (int i = 0; i < numFrames; ++i)
+        {
+            const double t = i / sampleRate;
+            const double sweep = std::sin(juce::MathConstants<double>::twoPi * (200.0 + 4000.0 * t) * t);
+
+            buffer.setSample(0, i, (float) (0.4 * std::sin(juce::MathConstants<double>::twoPi * 997.0 * t)
+                                            + 0.2 * sweep + 0.05 * (random.nextFloat() - 0.5f)));
+            buffer.setSample(1, i, (float) (0.3 * std::sin(juce::MathConstants<double>::twoPi * 6003.0 * t)
+                                            + 0.3 * sweep + 0.05 * (random.nextFloat() - 0.5f)));
+        }
+
+        file.deleteFile();
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::OutputStream> stream(file.createOutputStream());
+
+        if (stream == nullptr)
+            return false;
+
+        const auto writer = wav.createWriterFor(stream, juce::AudioFormatWriterOptions().withSampleRate(sampleRate)
+                                                                                        .withNumChannels(2)
+                                                                                        .withBitsPerSample(24));
+
+        return writer != nullptr && writer->writeFromAudioSampleBuffer(buffer, 0, numFrames);
+    }
+
+    struct TestCase
+    {
+        const char* name;
+        double newRate;
+        double inputRate;   // 0 = la del header
+    };
+}
+
+int main()
+{
+    const auto dir = juce::File::getSpecialLocation(juce::File::tempDirectory).getChildFile("HZDeterminismTest");
+    dir.deleteRecursively();
+    dir.createDirectory();
+
+    const auto input = dir.getChildFile("input.wav");
+
+    if (! writeTestFile(input, 44100.0, 3 * 44100))
+    {
+        std::printf("Error: no se pudo escribir %s\n", input.getFullPathName().toRawUTF8());
+        return 1;
+    }
+
+    const TestCase cases[] = {
+        { "racional", 48000.0, 0.0 },
+        { "halfband", 88200.0, 0.0 },
+        { "compacto", 44144.0, 0.0 },
+        { "variable", 48000.0, 44099.37 }
+    };
+
+    int failures = 0;
+
+    for (const auto& test : cases)
+    {
+        for (const bool doublePrecision : { false, true })
+        {
+            juce::uint64 reference = 0;
+            juce::String referenceRun;
+
+            for (const int numThreads : { 1, 2, 7 })
+            {
+                for (const int blockSize : { 257, 4096, 0 })
+                {
+                    HZConvertOptions options;
+                    options.deterministic = true;
+                    options.doublePrecision = doublePrecision;
+                    options.numThreads = numThreads;
+                    options.blockSize = blockSize;
+                    options.inputRate = test.inputRate;
+
+                    juce::String message;
+                    const auto output = HZResampler::convertSampleRate(input, test.newRate, false, message, options);
+                    const auto hash = output.existsAsFile() && output != input ? hashFile(output) : 0;
+                    output.deleteFile();
+
+                    const auto run = juce::String(test.name) + (doublePrecision ? " doble" : " float")
+                                   + " hilos=" + juce::String(numThreads)
+                                   + " bloque=" + (blockSize > 0 ? juce::String(blockSize) : juce::String("auto"));
+
+                    if (hash == 0)
+                    {
+                        std::printf("FALLA %s: %s\n", run.toRawUTF8(), message.toRawUTF8());
+                        ++failures;
+                    }
+                    else if (reference == 0)
+                    {
+                        reference = hash;
+                        referenceRun = run;
+                    }
+                    else if (hash != reference)
+                    {
+                        std::printf("FALLA %s: la salida difiere de %s\n", run.toRawUTF8(), referenceRun.toRawUTF8());
+                        ++failures;
+                    }
+                }
+            }
+
+            std::printf("%s %s: %016llx\n", test.name, doublePrecision ? "doble" : "float",
+                        (unsigned long long) reference);
+        }
+    }
+
+    dir.deleteRecursively();
+
+    if (failures > 0)
+    {
+        std::printf("%d conversiones no deterministas\n", failures);
+        return 1;
+    }
+
+    std::printf("OK\n");
+    return 0;
+}